@@ -0,0 +1,236 @@
+/**
+ * @brief Microbenchmarks of the hot kernels: region classification, the map per region, region
+ * sampling, trajectories and output
+ *
+ * Every benchmark runs a fixed workload of `items` operations once to warm up and then
+ * `--repeats` times. Reported are the nanoseconds per operation (minimum and median over the
+ * repeats) and the operations per second of the median repeat.
+ *
+ * Usage: microbench <angle> <width> [--repeats R] [--filter S] [--scale F] [--json FILE] [config flags]
+ *     --repeats R  Timed repeats of each benchmark (default 5)
+ *     --filter S   Only run benchmarks whose name contains S
+ *     --scale F    Multiplies the size of every workload (default 1)
+ *     --json FILE  Also write the results as JSON
+ * Remaining flags (e.g. --classifier) are those of `config::configure_runtime`.
+ * From cfiles/: make bench ARGS="0 1 --repeats 10 --json bench.json"
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "Writer.h"
+#include "Geometry.h"
+#include "SMapHelper.h"
+#include "ScatteringMap.h"
+
+struct BenchResult {
+    std::string name;
+    size_t items = 0;		 // Operations per repeat
+    std::vector<double> seconds; // Per repeat
+
+    double NsPerOp(const double& s) const { return 1e9*s/items; }
+    double Min() const { return NsPerOp(*std::ranges::min_element(seconds)); }
+    double Median() const {
+	std::vector<double> sorted = seconds;
+	std::ranges::sort(sorted);
+	return NsPerOp(sorted[sorted.size()/2]);
+    }
+    double ItemsPerSecond() const { return 1e9/Median(); }
+};
+
+namespace bench {
+    size_t repeats = 5;
+    double scale = 1;
+    std::string filter;
+    std::string json; // Results file, none when empty
+    std::vector<BenchResult> results;
+
+    /// Keeps `x` from being optimised away
+    template <typename T>
+    void DoNotOptimize(const T& x) { asm volatile("" : : "r,m"(x) : "memory"); }
+
+    /// Workload size `n` multiplied by `--scale`
+    size_t Size(const size_t& n) { return std::max<size_t>(1, std::llround(n*scale)); }
+
+    /**@brief Times `body`, which performs `items` operations per call
+    */
+    template <typename F>
+    void Run(const std::string& name, const size_t& items, F&& body) {
+	if (!filter.empty() && name.find(filter) == std::string::npos) return;
+	using clock = std::chrono::steady_clock;
+	BenchResult R{ name, items, {} };
+	body(); // Warm up
+	for (size_t r = 0; r < repeats; ++r) {
+	    const clock::time_point t0 = clock::now();
+	    body();
+	    R.seconds.push_back(std::chrono::duration<double>(clock::now() - t0).count());
+	}
+	std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+		  << std::setw(12) << R.Min() << std::setw(12) << R.Median() << std::scientific << std::setprecision(3)
+		  << std::setw(14) << R.ItemsPerSecond() << std::defaultfloat << std::setw(10) << items << "\n";
+	results.push_back(R);
+    }
+
+    void WriteJSON(const std::string& fname) {
+	nlohmann::ordered_json j;
+	j["width"] = config::d;
+	j["alpha"] = config::alpha;
+	j["classifier"] = (int)config::classifier;
+	j["repeats"] = repeats;
+	j["scale"] = scale;
+	for (const auto& R : results) {
+	    j["benchmarks"].push_back({ { "name", R.name }, { "items", R.items }, { "ns_per_op_min", R.Min() },
+					{ "ns_per_op_median", R.Median() }, { "items_per_second", R.ItemsPerSecond() },
+					{ "seconds", R.seconds } });
+	}
+	std::ofstream ofs(fname);
+	if (!ofs.is_open())
+	    throw std::runtime_error("ERROR: Could not open file: " + fname + ".");
+	ofs << j.dump(4);
+    }
+}
+
+/**@brief Region labels of uniform points over the channel, with each classifier
+ */
+void benchClassifiers() {
+    const size_t n = bench::Size(1 << 16);
+    Random<float_> rng(1, 0);
+    std::vector<float_> h(n), theta(n);
+    for (size_t i = 0; i < n; ++i) {
+	h[i] = rng.getUniformRandom(0, config::d);
+	theta[i] = rng.getUniformRandom(-PI2, PI2);
+    }
+    auto run = [&](const std::string& name, auto&& classify) {
+	bench::Run(name, n, [&] {
+	    int sum = 0;
+	    for (size_t i = 0; i < n; ++i)
+		sum += classify(h[i], theta[i]);
+	    bench::DoNotOptimize(sum);
+	});
+    };
+    run("whichRegion", [](const float_& a, const float_& b) { return whichRegion<float_>(a, b); });
+    run("whichRegionTangent", [](const float_& a, const float_& b) { return whichRegionTangent<float_>(a, b); });
+    run("whichRegionAdaptive", [](const float_& a, const float_& b) { return whichRegionAdaptive<float_>(a, b); });
+}
+
+/**@brief One application of the map to points of each region, and sampling of each region
+ */
+void benchRegions() {
+    withGeometry([&](auto G) { // Map specialised for the selected width, as in the production drivers
+	ScatteringMap<float_, decltype(G)> Map;
+	for (const auto& label : config::regionLabels) {
+	    const size_t n = bench::Size(1 << 12);
+	    Random<float_> rng(2, label);
+	    const auto [h0, theta0] = getPointsInRegion<float_>(label, n, rng);
+	    bench::Run("SMap/" + std::to_string(label), n, [&] {
+		float_ sum = 0;
+		for (size_t i = 0; i < n; ++i) {
+		    float_ h = h0[i], theta = theta0[i], tau = 0;
+		    int_ll x = 0;
+		    int l = label;
+		    bool dirFlag = false;
+		    Map.SMap(h, theta, tau, x, l, dirFlag);
+		    sum += h + tau + l;
+		}
+		bench::DoNotOptimize(sum);
+	    });
+	}
+    });
+    for (const auto& label : config::regionLabels) {
+	const size_t n = bench::Size(1 << 10);
+	bench::Run("getPointsInRegion/" + std::to_string(label), n, [&] {
+	    Random<float_> rng(3, label);
+	    bench::DoNotOptimize(getPointsInRegion<float_>(label, n, rng));
+	});
+    }
+}
+
+/**@brief Trajectories recorded at every iterate, and at evenly spaced times
+ */
+void benchTrajectories() {
+    const size_t nParticles = bench::Size(64), nIterates = 1000;
+    std::vector<SParticle<float_>> Initial;
+    Random<float_> rng(4, 0);
+    for (size_t j = 0; j < nParticles; ++j)
+	Initial.push_back(SParticle<float_>({ 0., config::d }, { -PI2, PI2 }, rng));
+    std::vector<size_t> iterates(nIterates);
+    std::iota(iterates.begin(), iterates.end(), 0);
+    std::vector<float_> times(nIterates);
+    for (size_t i = 0; i < times.size(); ++i)
+	times[i] = i; // About one collision per unit time
+    withGeometry([&](auto G) {
+	ScatteringMap<float_, decltype(G)> Map;
+	bench::Run("getTrajectory/iterates", nParticles*nIterates, [&] {
+	    for (const auto& SP : Initial) {
+		SParticle<float_> P = SP;
+		bench::DoNotOptimize(Map.getTrajectory(P, iterates).H.back());
+	    }
+	});
+	bench::Run("getTrajectory/time", nParticles*nIterates, [&] { // Per recorded time
+	    for (const auto& SP : Initial) {
+		SParticle<float_> P = SP;
+		bench::DoNotOptimize(Map.getTrajectory(P, times).H.back());
+	    }
+	});
+    });
+}
+
+/**@brief Rows of doubles written in each output format. Operations are values written
+ */
+void benchWriter() {
+    const size_t nRows = bench::Size(64), nCols = 4096;
+    std::vector<std::vector<float_>> rows(nRows, std::vector<float_>(nCols));
+    Random<float_> rng(5, 0);
+    for (auto& row : rows) { // Smooth rows, like trajectory times
+	float_ t = 0;
+	for (auto& x : row)
+	    x = (t += rng.getUniformRandom(0, 1));
+    }
+    const std::string base = std::filesystem::temp_directory_path().string() + "/microbench_Writer";
+    for (const std::string ext : { ".dat", ".npy", ".dod" }) {
+	bench::Run("Writer/" + ext.substr(1), nRows*nCols, [&] {
+	    Writer W(base + ext);
+	    for (const auto& row : rows)
+		W.WriteRowVector<float_>(row);
+	});
+	std::filesystem::remove(base + ext);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<char*> args = { argv[0] }; // Flags left for config::configure_runtime
+    for (int i = 1; i < argc; ++i) {
+	const std::string flag = argv[i];
+	if (flag == "--repeats" || flag == "--filter" || flag == "--scale" || flag == "--json") {
+	    if (i + 1 >= argc)
+		throw std::invalid_argument("ERROR: Missing value for argument " + flag + ".");
+	    const std::string value = argv[++i];
+	    if (flag == "--repeats") bench::repeats = std::max<size_t>(1, std::stoul(value));
+	    else if (flag == "--filter") bench::filter = value;
+	    else if (flag == "--scale") bench::scale = std::stod(value);
+	    else bench::json = value;
+	} else {
+	    args.push_back(argv[i]);
+	}
+    }
+    config::configure_runtime(args.size(), args.data());
+
+    std::cout << std::left << std::setw(36) << "benchmark" << std::right << std::setw(12) << "ns/op min"
+	      << std::setw(12) << "ns/op med" << std::setw(14) << "items/s" << std::setw(10) << "items" << "\n";
+    benchClassifiers();
+    benchRegions();
+    benchTrajectories();
+    benchWriter();
+    if (!bench::json.empty())
+	bench::WriteJSON(bench::json);
+}
@@ -0,0 +1,162 @@
+/**
+ * @brief Checkpoints of trajectory runs, from which an interrupted run resumes bit-identically
+ *
+ * Trajectory drivers write whole trajectories one batch of initial conditions at a time, and
+ * initial condition j is drawn from the counter-based stream (seed, j). Between batches no
+ * particle is in flight, so the state of a run is the number of initial conditions written, the
+ * position of every output file, and what is reported at the end of the run. A process may open
+ * several runs, one per driver call; the checkpoint records which, so that on resume the runs
+ * completed before it are skipped.
+ */
+
+#ifndef CHECKPOINT_H_INCLUDED
+#define CHECKPOINT_H_INCLUDED
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "config.h"
+#include "Writer.h"
+#include "Shadow.h"
+
+constexpr char CHECKPOINT_MAGIC[4] = { 'S', 'M', 'C', 'K' };
+constexpr std::uint32_t CHECKPOINT_VERSION = 2;
+
+struct Checkpoint {
+
+    std::string run;			   // Driver, arguments and configuration. Must match on resume
+    std::uint64_t seed = 0;		   // config::seed of the run
+    std::uint64_t index = 0;		   // Trajectory runs the process opened before this one (config::trajectoryRun)
+    std::uint64_t call = 0;		   // Calls of `WriteTrajectories` completed
+    std::uint64_t particle = 0;		   // Initial conditions of the current call written
+    std::array<WriterState,6> writers;	   // Trajectory files, in the order of `getTrajectoryWriters`
+    std::vector<std::uint64_t> unresolved; // Initial conditions of the current call cut short
+    ShadowReport shadow;		   // Shadow runs of the completed calls
+
+    std::string path; // File saved to. Nothing is saved when empty
+
+    /// True when config::checkpointSeconds have passed since the last save
+    bool Due() const {
+	return !path.empty() && config::checkpointSeconds > 0
+	    && std::chrono::duration<double>(std::chrono::steady_clock::now() - saved).count() >= config::checkpointSeconds;
+    }
+
+    /**@brief Saves the state of the run with the current position of its writers
+    *
+    * The file is written next to `path` and then renamed over it, so an interruption while
+    * saving leaves the previous checkpoint intact.
+    */
+    void Save(std::array<Writer,6>& trajWriters) {
+	for (size_t k = 0; k < writers.size(); ++k)
+	    writers[k] = trajWriters[k].State();
+	const std::string tmp = path + ".tmp";
+	{
+	    std::ofstream ofs(tmp, std::ios::binary);
+	    if (!ofs.is_open())
+		throw std::runtime_error("ERROR: Could not open file: " + tmp + ".");
+	    ofs.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	    Put(ofs, CHECKPOINT_VERSION);
+	    PutString(ofs, run);
+	    Put(ofs, seed);
+	    Put(ofs, index);
+	    Put(ofs, call);
+	    Put(ofs, particle);
+	    for (const auto& w : writers) {
+		Put(ofs, w.bytes);
+		Put(ofs, w.rows);
+		Put(ofs, w.cols);
+		PutString(ofs, w.descr);
+	    }
+	    PutVector(ofs, unresolved);
+	    Put(ofs, (std::uint64_t)shadow.nSteps);
+	    PutString(ofs, shadow.precision);
+	    PutVector(ofs, std::vector<std::uint64_t>(shadow.firstDivergence.begin(), shadow.firstDivergence.end()));
+	    ofs.flush();
+	    if (!ofs)
+		throw std::runtime_error("ERROR: Could not write to file: " + tmp + ".");
+	}
+	std::filesystem::rename(tmp, path);
+	saved = std::chrono::steady_clock::now();
+    }
+
+    /// Reads a checkpoint saved to `fname`
+    static Checkpoint Read(const std::string& fname) {
+	std::ifstream ifs(fname, std::ios::binary);
+	if (!ifs.is_open())
+	    throw std::runtime_error("ERROR: No checkpoint to resume from: " + fname + ".");
+	ifs.exceptions(std::ios::failbit | std::ios::badbit);
+	Checkpoint C;
+	try {
+	    char magic[sizeof(CHECKPOINT_MAGIC)];
+	    ifs.read(magic, sizeof(magic));
+	    if (std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0 || Get<std::uint32_t>(ifs) != CHECKPOINT_VERSION)
+		throw std::runtime_error("ERROR: " + fname + " is not a checkpoint of this version.");
+	    C.run = GetString(ifs);
+	    C.seed = Get<std::uint64_t>(ifs);
+	    C.index = Get<std::uint64_t>(ifs);
+	    C.call = Get<std::uint64_t>(ifs);
+	    C.particle = Get<std::uint64_t>(ifs);
+	    for (auto& w : C.writers) {
+		w.bytes = Get<std::uint64_t>(ifs);
+		w.rows = Get<std::uint64_t>(ifs);
+		w.cols = Get<std::uint64_t>(ifs);
+		w.descr = GetString(ifs);
+	    }
+	    C.unresolved = GetVector(ifs);
+	    C.shadow.nSteps = Get<std::uint64_t>(ifs);
+	    C.shadow.precision = GetString(ifs);
+	    const std::vector<std::uint64_t> divergence = GetVector(ifs);
+	    C.shadow.firstDivergence.assign(divergence.begin(), divergence.end());
+	} catch (const std::ios::failure&) {
+	    throw std::runtime_error("ERROR: Checkpoint " + fname + " is truncated.");
+	}
+	C.path = fname;
+	return C;
+    }
+
+private:
+    std::chrono::steady_clock::time_point saved = std::chrono::steady_clock::now();
+
+    template <typename U>
+    static void Put(std::ostream& os, const U& x) {
+	static_assert(std::is_trivially_copyable_v<U>);
+	os.write(reinterpret_cast<const char*>(&x), sizeof(U));
+    }
+
+    static void PutString(std::ostream& os, const std::string& s) {
+	Put(os, (std::uint64_t)s.size());
+	os.write(s.data(), s.size());
+    }
+
+    static void PutVector(std::ostream& os, const std::vector<std::uint64_t>& v) {
+	Put(os, (std::uint64_t)v.size());
+	os.write(reinterpret_cast<const char*>(v.data()), v.size()*sizeof(std::uint64_t));
+    }
+
+    template <typename U>
+    static U Get(std::istream& is) {
+	U x;
+	is.read(reinterpret_cast<char*>(&x), sizeof(U));
+	return x;
+    }
+
+    static std::string GetString(std::istream& is) {
+	std::string s(Get<std::uint64_t>(is), '\0');
+	is.read(s.data(), s.size());
+	return s;
+    }
+
+    static std::vector<std::uint64_t> GetVector(std::istream& is) {
+	std::vector<std::uint64_t> v(Get<std::uint64_t>(is));
+	is.read(reinterpret_cast<char*>(v.data()), v.size()*sizeof(std::uint64_t));
+	return v;
+    }
+};
+
+#endif
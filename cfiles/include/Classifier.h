@@ -0,0 +1,146 @@
+/**
+ * @brief Batched alternatives to `whichRegion` for classifying many (h,theta) at once
+ *
+ * Labels are identical to `whichRegion`. Comparisons are made in tangent space and any point
+ * close enough to a singular direction for rounding to matter is handed back to `whichRegion`.
+ */
+
+#ifndef CLASSIFIER_H_INCLUDED
+#define CLASSIFIER_H_INCLUDED
+
+#include <array>
+#include <vector>
+#include "config.h"
+#include "CoordinateSpace.h"
+#include "SMapHelper.h"
+
+/// Points classified per tile by `whichRegionBatch`
+constexpr size_t CLASSIFIER_TILE = 64;
+
+/**@brief Classifies a tile of up to `TILE` points with straight-line masked code
+ *
+ * Every singular direction is of the form X = atan(u) with u rational in h, and tan is 
+ * monotone on (-pi/2, pi/2), so theta < X is decided by tan(theta) < u. This replaces the 
+ * ~20 `atan` calls of the chain in `whichRegion` by one `tan` and a few divisions per point.
+ * The indicator functions are evaluated as masks for all points and the label is selected 
+ * in reverse priority order of the chain in `whichRegion`. Points for which any comparison 
+ * falls within `TANGENT_GUARD` (in units of epsilon of T) of a boundary are reclassified with 
+ * `whichRegion`, so that the labels are bit-identical to it.
+ * @param h Entrance heights
+ * @param theta Entrance angles
+ * @param labels Output labels. -1 where `whichRegion` would return -1
+ * @param n Number of points, n <= TILE
+*/
+template <typename T, size_t TILE>
+void whichRegionTile(const T* h, const T* theta, int* labels, const size_t& n) {
+    const T d = config::d;
+    std::array<T, TILE> th, tn;
+    std::array<unsigned char, TILE> ambiguous;
+    for (size_t l = 0; l < n; ++l) th[l] = getThetaRHS(theta[l]);
+    for (size_t l = 0; l < n; ++l) tn[l] = tan(th[l]);
+
+    auto amb = nearTangent<T>;
+
+    if (config::widthSelection == 0) {
+	for (size_t l = 0; l < n; ++l) {
+	    const T H = h[l], t = tn[l];
+	    // Arguments of the singular directions exactly as in CoordinateSpace.h 
+	    const T u1 = -(H/d), u2 = -((H+d)/(4*d)), u3 = -((H+d)/(5*d)), u4 = -((H+d-(T)DELTA)/(d+(T)DELTA)),
+			 u5 = -((H)/(d+1)), u6 = -((H)/(2*d+1)), u7 = (d-H)/(2*d+1), u8 = ((T)DELTA-H)/(2*d+(T)DELTA),
+			 u9 = ((T)DELTA-H)/(d+(T)DELTA), u10 = (1-H)/(2*d+1), u11 = (1-H)/(d+1), u12 = (d-H)/d,
+			 u13 = (d+(T)DELTA-H)/(d+(T)DELTA), u14 = (d+1-H)/(d+1), u15 = d+1-H, u16 = (d+(T)DELTA-H)/(T)DELTA,
+			 u17 = 2*d+1-H, u18 = ((T)DELTA+2*d-H)/(T)DELTA, ug = ((T)DELTA-H)/(T)DELTA;
+	    const bool in = (H > 0) & (H < d) & (th[l] > X0) & (th[l] < X19);
+	    const bool g0 = in & (t < ug);
+	    const bool g2 = in & (t > ug) & (t < u16);
+	    const bool g3 = in & (t > u16);
+	    const bool y1 = (t > u1) & (t < u4);
+	    const bool y7 = (t > u9) & (t < u12);
+	    int label = -1;
+	    label = (g3 & (t > u18)) ? 18 : label;
+	    label = (g3 & (t > u17) & (t < u18)) ? 17 : label;
+	    label = (g3 & (t < u17)) ? 16 : label;
+	    label = (g2 & (t > u15)) ? 15 : label;
+	    label = (g2 & (t > u14) & (t < u15)) ? 14 : label;
+	    label = (g2 & (t > u13) & (t < u14)) ? 13 : label;
+	    label = (g2 & (t > u12) & (t < u13)) ? 12 : label;
+	    label = (g0 & (H < 1/(float_)4) & (t > u11) & (t < u12)) ? 11 : label;
+	    label = (g0 & (H < 1/(float_)3) & (t > u10) & (t < u11) & y7) ? 10 : label;
+	    label = (g0 & (t > u9) & (t < u10) & y7) ? 9 : label;
+	    label = (g0 & (t > u8) & (t < u9)) ? 8 : label;
+	    label = (g0 & (t > u7) & (t < u8)) ? 7 : label;
+	    label = (g0 & (t > u6) & (t < u7)) ? 6 : label;
+	    label = (g0 & (t > u5) & (t < u6)) ? 5 : label;
+	    label = (g0 & (t > u4) & (t < u5)) ? 4 : label;
+	    label = (g0 & (H < (1/(float_)3)) & (t > u3) & (t < u4) & y1) ? 3 : label;
+	    label = (g0 & (H > 1/(float_)8) & (t > u2) & (t < u3) & y1) ? 2 : label;
+	    label = (g0 & (H > (1/(float_)6)) & (t > u1) & (t < u2)) ? 1 : label;
+	    label = (g0 & (t < u1)) ? 0 : label;
+	    labels[l] = label;
+	    ambiguous[l] = in & (amb(t,u1) | amb(t,u2) | amb(t,u3) | amb(t,u4) | amb(t,u5) | amb(t,u6) | amb(t,u7)
+			      | amb(t,u8) | amb(t,u9) | amb(t,u10) | amb(t,u11) | amb(t,u12) | amb(t,u13) | amb(t,u14) 
+			      | amb(t,u15) | amb(t,u16) | amb(t,u17) | amb(t,u18) | amb(t,ug));
+	}
+    } else {
+	for (size_t l = 0; l < n; ++l) {
+	    const T H = h[l], t = tn[l];
+	    const T u1 = -(H/d), u5 = -((H)/(d+1)), u6 = -((H)/(2*d+1)), u7 = (d-H)/(2*d+1), 
+			 u8 = ((T)DELTA-H)/(2*d+(T)DELTA), u9 = ((T)DELTA-H)/(d+(T)DELTA), u11 = (1-H)/(d+1), u12 = (d-H)/d,
+			 u13 = (d+(T)DELTA-H)/(d+(T)DELTA), u14 = (d+1-H)/(d+1), u15 = d+1-H, u16 = (d+(T)DELTA-H)/(T)DELTA,
+			 u17 = 2*d+1-H, u18 = ((T)DELTA+2*d-H)/(T)DELTA, ug = ((T)DELTA-H)/(T)DELTA, 
+			 ua0 = -H, ua1 = (T)1 - 2*H, u19 = d-H;
+	    const bool in = (H > 0) & (H < d) & (th[l] > X0) & (th[l] < X19);
+	    const bool b19 = in & (t > ug) & (t < u19);
+	    const bool g0 = !b19 & in & (t < ug);
+	    const bool g2 = !b19 & in & (t > ug) & (t < u16);
+	    const bool g3 = !b19 & in & (t > u16);
+	    const bool a = (t > ua0) & (t < ua1);
+	    int label = -1;
+	    label = (g3 & (t > u18)) ? 18 : label;
+	    label = (g3 & (t > u17) & (t < u18)) ? 17 : label;
+	    label = (g3 & (t < u17)) ? 16 : label;
+	    label = (g2 & (t > u15)) ? 15 : label;
+	    label = (g2 & (t > u14) & (t < u15)) ? 14 : label;
+	    label = (g2 & (t > u13) & (t < u14)) ? 13 : label;
+	    label = (g2 & (t > u12) & (t < u13)) ? 12 : label;
+	    label = (g0 & (H < 1/(float_)3) & (t > u11) & a) ? 11 : label;
+	    label = (g0 & (H < 2/(float_)5) & (t > u7) & (t < u11) & a) ? 10 : label;
+	    label = (g0 & (H < 1/(float_)2) & (t > u9) & (t < u7) & a) ? 9 : label;
+	    label = (g0 & (H < 1/(float_)2) & (t > u8) & (t < u9) & a) ? 8 : label;
+	    label = (g0 & (H < 3/(float_)5) & (t > u6) & (t < u8) & a) ? 6 : label;
+	    label = (g0 & (H < 2/(float_)3) & (t > u5) & (t < u6) & a) ? 5 : label;
+	    label = (g0 & (t > u1) & (t < u5) & a) ? 4 : label;
+	    label = (g0 & (t < u1)) ? 0 : label;
+	    label = b19 ? 19 : label;
+	    labels[l] = label;
+	    ambiguous[l] = in & (amb(t,u1) | amb(t,u5) | amb(t,u6) | amb(t,u7) | amb(t,u8) | amb(t,u9) | amb(t,u11)
+			      | amb(t,u12) | amb(t,u13) | amb(t,u14) | amb(t,u15) | amb(t,u16) | amb(t,u17)
+			      | amb(t,u18) | amb(t,ug) | amb(t,ua0) | amb(t,ua1) | amb(t,u19));
+	}
+    }
+    // Exact fallback near singular directions
+    for (size_t l = 0; l < n; ++l)
+	if (ambiguous[l])
+	    labels[l] = whichRegion<T>(h[l], theta[l]);
+}
+
+/**@brief Classifies `n` points in tiles of `CLASSIFIER_TILE`
+ * @param h Entrance heights
+ * @param theta Entrance angles
+ * @param labels Output labels
+ * @param n Number of points
+*/
+template <typename T>
+void whichRegionBatch(const T* h, const T* theta, int* labels, const size_t& n) {
+    for (size_t i = 0; i < n; i += CLASSIFIER_TILE)
+	whichRegionTile<T, CLASSIFIER_TILE>(h + i, theta + i, labels + i, std::min(CLASSIFIER_TILE, n - i));
+}
+
+template <typename T>
+std::vector<int> whichRegionBatch(const std::vector<T>& h, const std::vector<T>& theta) {
+    std::vector<int> labels(h.size());
+    whichRegionBatch<T>(h.data(), theta.data(), labels.data(), h.size());
+    return labels;
+}
+
+#endif
@@ -0,0 +1,191 @@
+/**
+ * @brief Lossless compressed encodings of the Labels, Positions and Time trajectory members
+ *
+ *	  - RLE:   runs of equal labels, each stored as one varint (run length << 5 | label + 1)
+ *	  - Delta: first position, then differences between consecutive positions, as zigzag varints
+ *	  - DoD:   IEEE bit patterns of the (non-negative, increasing) cumulative times, as the first
+ *	  	   value, first difference, then differences of differences, all zigzag varints
+ *
+ * A file starts with the magic bytes "SMPK", a version byte and a codec byte. Each row (one
+ * trajectory) follows as varint(number of values), varint(number of bytes), then the bytes.
+ */
+
+#ifndef CODEC_H_INCLUDED
+#define CODEC_H_INCLUDED
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+enum class Codec : unsigned char { RLE = 1, Delta = 2, DoD = 3 };
+
+const std::string CODEC_MAGIC = "SMPK";
+constexpr unsigned char CODEC_VERSION = 1;
+
+/**@brief Codec of a file name by its extension, e.g. Labels.rle. False for other files
+*/
+inline bool getCodec(const std::string& fname, Codec& codec) {
+    if (fname.ends_with(".rle")) { codec = Codec::RLE; return true; }
+    if (fname.ends_with(".delta")) { codec = Codec::Delta; return true; }
+    if (fname.ends_with(".dod")) { codec = Codec::DoD; return true; }
+    return false;
+}
+
+inline std::uint64_t zigzag(const std::int64_t& x) { return ((std::uint64_t)x << 1) ^ (std::uint64_t)(x >> 63); }
+inline std::int64_t unzigzag(const std::uint64_t& u) { return (std::int64_t)(u >> 1) ^ -(std::int64_t)(u & 1); }
+
+inline void putVarint(std::string& out, std::uint64_t u) {
+    while (u >= 0x80) {
+	out += (char)(u | 0x80);
+	u >>= 7;
+    }
+    out += (char)u;
+}
+
+inline std::uint64_t getVarint(const char*& p, const char* end) {
+    std::uint64_t u = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+	if (p == end)
+	    throw std::runtime_error("ERROR: Truncated varint in @getVarint().");
+	const unsigned char b = *p++;
+	u |= (std::uint64_t)(b & 0x7F) << shift;
+	if (!(b & 0x80)) return u;
+    }
+    throw std::runtime_error("ERROR: Malformed varint in @getVarint().");
+}
+
+/// Integer (or bit pattern) a value is encoded through
+template <typename T>
+std::int64_t toCode(const T& x) {
+    if constexpr (std::is_integral_v<T>) return x;
+    else if constexpr (std::is_floating_point_v<T> && sizeof(T) == 8) return std::bit_cast<std::int64_t>(x);
+    else if constexpr (std::is_floating_point_v<T> && sizeof(T) == 4) return std::bit_cast<std::int32_t>(x);
+    else throw std::invalid_argument("ERROR: Type cannot be encoded in @toCode().");
+}
+
+template <typename T>
+T fromCode(const std::int64_t& c) {
+    if constexpr (std::is_integral_v<T>) return (T)c;
+    else if constexpr (std::is_floating_point_v<T> && sizeof(T) == 8) return std::bit_cast<T>(c);
+    else if constexpr (std::is_floating_point_v<T> && sizeof(T) == 4) return std::bit_cast<T>((std::int32_t)c);
+    else throw std::invalid_argument("ERROR: Type cannot be decoded in @fromCode().");
+}
+
+/**@brief Encodes one row
+* @param codec Encoding
+* @param v Row values
+* @return Encoded bytes, without the row framing
+*/
+template <typename T>
+std::string Encode(const Codec& codec, std::span<const T> v) {
+    std::string out;
+    if (codec == Codec::RLE) {
+	if constexpr (std::is_integral_v<T>) {
+	    for (size_t i = 0; i < v.size(); ) {
+		bool outOfRange = v[i] > 30;
+		if constexpr (std::is_signed_v<T>)
+		    outOfRange |= v[i] < -1;
+		if (outOfRange)
+		    throw std::invalid_argument("ERROR: Label out of range in @Encode().");
+		size_t j = i + 1;
+		while (j < v.size() && v[j] == v[i]) ++j;
+		putVarint(out, ((std::uint64_t)(j - i) << 5) | (std::uint64_t)(v[i] + 1));
+		i = j;
+	    }
+	} else {
+	    throw std::invalid_argument("ERROR: RLE encoding is defined for integer labels.");
+	}
+    } else {
+	std::int64_t prev = 0, prevDelta = 0;
+	for (size_t i = 0; i < v.size(); ++i) {
+	    const std::int64_t c = toCode<T>(v[i]);
+	    const std::int64_t delta = (std::int64_t)((std::uint64_t)c - (std::uint64_t)prev);
+	    if (codec == Codec::Delta || i < 2)
+		putVarint(out, zigzag(i == 0 ? c : delta));
+	    else
+		putVarint(out, zigzag((std::int64_t)((std::uint64_t)delta - (std::uint64_t)prevDelta)));
+	    prevDelta = delta;
+	    prev = c;
+	}
+    }
+    return out;
+}
+
+template <typename T>
+std::string Encode(const Codec& codec, const std::vector<T>& v) { return Encode<T>(codec, std::span<const T>(v)); }
+
+/**@brief Decodes one row
+* @param codec Encoding
+* @param p Start of the encoded bytes
+* @param end End of the encoded bytes
+* @param n Number of values in the row
+*/
+template <typename T>
+std::vector<T> Decode(const Codec& codec, const char* p, const char* end, const size_t& n) {
+    std::vector<T> v;
+    v.reserve(n);
+    if (codec == Codec::RLE) {
+	while (v.size() < n) {
+	    const std::uint64_t u = getVarint(p, end);
+	    const size_t run = u >> 5;
+	    if (run == 0 || v.size() + run > n)
+		throw std::runtime_error("ERROR: Malformed run in @Decode().");
+	    v.insert(v.end(), run, (T)((std::int64_t)(u & 0x1F) - 1));
+	}
+    } else {
+	std::uint64_t c = 0, delta = 0;
+	for (size_t i = 0; i < n; ++i) {
+	    const std::uint64_t u = (std::uint64_t)unzigzag(getVarint(p, end));
+	    if (i == 0) c = u;
+	    else {
+		delta = (codec == Codec::Delta || i == 1) ? u : delta + u;
+		c += delta;
+	    }
+	    v.push_back(fromCode<T>((std::int64_t)c));
+	}
+    }
+    if (p != end)
+	throw std::runtime_error("ERROR: Trailing bytes in row in @Decode().");
+    return v;
+}
+
+/// File header of an encoded file
+inline std::string CodecHeader(const Codec& codec) {
+    return CODEC_MAGIC + (char)CODEC_VERSION + (char)codec;
+}
+
+/**@brief Reads every row of a file written by `Writer` with a codec
+* @param fname File name
+* @return Rows of the file
+*/
+template <typename T>
+std::vector<std::vector<T>> ReadEncodedRows(const std::string& fname) {
+    std::ifstream ifs(fname, std::ios::binary);
+    if (!ifs.is_open())
+	throw std::runtime_error("ERROR: Could not open file: " + fname + ".");
+    const std::string bytes((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    if (bytes.size() < 6 || bytes.compare(0, 4, CODEC_MAGIC) != 0 || bytes[4] != (char)CODEC_VERSION)
+	throw std::runtime_error("ERROR: " + fname + " is not an encoded trajectory file.");
+    const Codec codec = (Codec)bytes[5];
+    const char* p = bytes.data() + 6;
+    const char* end = bytes.data() + bytes.size();
+    std::vector<std::vector<T>> rows;
+    while (p != end) {
+	const size_t n = getVarint(p, end);
+	const size_t nBytes = getVarint(p, end);
+	if ((size_t)(end - p) < nBytes)
+	    throw std::runtime_error("ERROR: Truncated row in " + fname + ".");
+	rows.push_back(Decode<T>(codec, p, p + nBytes, n));
+	p += nBytes;
+    }
+    return rows;
+}
+
+#endif
@@ -18,41 +18,59 @@
 // ===================================================================================
 constexpr float_ X0 = -PI2;
  
-float_ X1(const float_& d, const float_& h) { return -atan(h/d); }
+template <typename T = float_>
+T X1(const T& d, const T& h) { return -atan(h/d); }
  
-float_ X2(const float_& d, const float_& h) { return -atan((h+d)/(4*d)); }
+template <typename T = float_>
+T X2(const T& d, const T& h) { return -atan((h+d)/(4*d)); }
  
-float_ X3(const float_& d, const float_& h) { return -atan((h+d)/(5*d)); }
+template <typename T = float_>
+T X3(const T& d, const T& h) { return -atan((h+d)/(5*d)); }
  
-float_ X4(const float_& d, const float_& h) { return -atan((h+d-DELTA)/(d+DELTA)); }
+template <typename T = float_>
+T X4(const T& d, const T& h) { return -atan((h+d-(T)DELTA)/(d+(T)DELTA)); }
  
-float_ X5(const float_& d, const float_& h) { return -atan((h)/(d+1)); }
+template <typename T = float_>
+T X5(const T& d, const T& h) { return -atan((h)/(d+1)); }
  
-float_ X6(const float_& d, const float_& h) { return -atan((h)/(2*d+1)); }
+template <typename T = float_>
+T X6(const T& d, const T& h) { return -atan((h)/(2*d+1)); }
  
-float_ X7(const float_& d, const float_& h) { return atan((d-h)/(2*d+1)); }
+template <typename T = float_>
+T X7(const T& d, const T& h) { return atan((d-h)/(2*d+1)); }
  
-float_ X8(const float_& d, const float_& h) { return atan((DELTA-h)/(2*d+DELTA)); }
+template <typename T = float_>
+T X8(const T& d, const T& h) { return atan(((T)DELTA-h)/(2*d+(T)DELTA)); }
  
-float_ X9(const float_& d, const float_& h) { return atan((DELTA-h)/(d+DELTA)); }
+template <typename T = float_>
+T X9(const T& d, const T& h) { return atan(((T)DELTA-h)/(d+(T)DELTA)); }
  
-float_ X10(const float_& d, const float_& h) { return atan((1-h)/(2*d+1)); }
+template <typename T = float_>
+T X10(const T& d, const T& h) { return atan((1-h)/(2*d+1)); }
  
-float_ X11(const float_& d, const float_& h) { return atan((1-h)/(d+1)); }
+template <typename T = float_>
+T X11(const T& d, const T& h) { return atan((1-h)/(d+1)); }
  
-float_ X12(const float_& d, const float_& h) { return atan((d-h)/d); }
+template <typename T = float_>
+T X12(const T& d, const T& h) { return atan((d-h)/d); }
  
-float_ X13(const float_& d, const float_& h) { return atan((d+DELTA-h)/(d+DELTA)); }
+template <typename T = float_>
+T X13(const T& d, const T& h) { return atan((d+(T)DELTA-h)/(d+(T)DELTA)); }
  
-float_ X14(const float_& d, const float_& h) { return atan((d+1-h)/(d+1)); }
+template <typename T = float_>
+T X14(const T& d, const T& h) { return atan((d+1-h)/(d+1)); }
  
-float_ X15(const float_& d, const float_& h) { return atan(d+1-h); }
+template <typename T = float_>
+T X15(const T& d, const T& h) { return atan(d+1-h); }
  
-float_ X16(const float_& d, const float_& h) { return atan((d+DELTA-h)/DELTA); }
+template <typename T = float_>
+T X16(const T& d, const T& h) { return atan((d+(T)DELTA-h)/(T)DELTA); }
  
-float_ X17(const float_& d, const float_& h) { return atan(2*d+1-h); }
+template <typename T = float_>
+T X17(const T& d, const T& h) { return atan(2*d+1-h); }
  
-float_ X18(const float_& d, const float_& h) { return atan((DELTA+2*d-h)/DELTA); }
+template <typename T = float_>
+T X18(const T& d, const T& h) { return atan(((T)DELTA+2*d-h)/(T)DELTA); }
 constexpr float_ X19 = PI2;
 // ===================================================================================
 // SINGULAR DIRECTIONS. END.
@@ -60,136 +78,169 @@ constexpr float_ X19 = PI2;
 // ===================================================================================
 // INDICATOR FUNCTIONS FOR EACH REGION. START.
 // ===================================================================================
-bool IN_BETA0(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA0(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X0 && theta < X1(d, h))); 
 }
 /// Individual bouncing trajectories not distinguished at this stage
-bool IN_BETA1(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA1(const T& d, const T& h, const T& theta) { 
     return ((h > (1/(float_)6) && h < d) && (theta > X1(d, h) && theta < X2(d, h)));
 }
  
-bool IN_Y1(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_Y1(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X1(d, h) && theta < X4(d, h))); 
 }
  
-bool IN_BETA2(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA2(const T& d, const T& h, const T& theta) { 
     return (((h > 1/(float_)8 && h < d) && (theta > X2(d, h) && theta < X3(d, h))) && IN_Y1(d, h, theta)); 
 }
  
-bool IN_BETA3(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA3(const T& d, const T& h, const T& theta) { 
     return (((h > 0 && h < (1/(float_)3)) && (theta > X3(d, h) && theta < X4(d, h))) && IN_Y1(d, h, theta)); 
 }
  
-bool IN_BETA4(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA4(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X4(d, h) && theta < X5(d, h))); 
 }
  
-bool IN_BETA5(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA5(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X5(d, h) && theta < X6(d, h))); 
 }
  
-bool IN_BETA6(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA6(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X6(d, h) && theta < X7(d, h))); 
 }
  
-bool IN_BETA7(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA7(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X7(d, h) && theta < X8(d, h))); 
 }
  
-bool IN_BETA8(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA8(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X8(d, h) && theta < X9(d, h))); 
 }
  
-bool IN_Y7(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_Y7(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X9(d, h) && theta < X12(d, h))); 
 }
  
-bool IN_BETA9(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA9(const T& d, const T& h, const T& theta) { 
     return (((h > 0 && h < d) && (theta > X9(d, h) && theta < X10(d, h))) && IN_Y7(d,h,theta)); 
 }
  
-bool IN_BETA10(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA10(const T& d, const T& h, const T& theta) { 
     return (((h > 0 && h < 1/(float_)3) && (theta > X10(d, h) && theta < X11(d, h))) && IN_Y7(d,h,theta)); 
 }
  
-bool IN_BETA11(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA11(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < 1/(float_)4) && (theta > X11(d, h) && theta < X12(d, h))); 
 }
 /// Individual bouncing ball trajectories not distinguished at this stage
-bool IN_BETA12(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA12(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X12(d, h) && theta < X13(d, h))); 
 }
  
-bool IN_BETA13(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA13(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X13(d, h) && theta < X14(d, h))); 
 }
  
-bool IN_BETA14(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA14(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X14(d, h) && theta < X15(d, h))); 
 }
  
-bool IN_BETA15(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA15(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X15(d, h) && theta < X16(d, h))); 
 }
  
-bool IN_BETA16(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA16(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X16(d, h) && theta < X17(d, h))); 
 }
  
-bool IN_BETA17(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA17(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X17(d, h) && theta < X18(d, h))); 
 }
  
-bool IN_BETA18(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_BETA18(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X18(d, h) && theta < X19)); 
 }
 /// The following regions are for when d = 1. These differ from above when first collision is on \Gamma_0
-bool IN_A(const float_& d, const float_& h, const float_& theta) { 
-    return ((h > 0 && h < d) && (theta > -atan(h) && theta < atan((float_)1 - 2*h))); 
+template <typename T = float_>
+bool IN_A(const T& d, const T& h, const T& theta) { 
+    return ((h > 0 && h < d) && (theta > -atan(h) && theta < atan((T)1 - 2*h))); 
 }
  
-bool IN_ZJ0(const float_& d, const float_& h, const float_& theta) { // REGION 4
+template <typename T = float_>
+bool IN_ZJ0(const T& d, const T& h, const T& theta) { // REGION 4
     return (((h > 0 && h < d) && (theta > X1(d, h) && theta < X5(d,h))) && IN_A(d,h,theta)); 
 }
  
-bool IN_ZJ1(const float_& d, const float_& h, const float_& theta) { // REGION 5
+template <typename T = float_>
+bool IN_ZJ1(const T& d, const T& h, const T& theta) { // REGION 5
     return (((h > 0 && h < 2/(float_)3) && (theta > X5(d, h) && theta < X6(d,h))) && IN_A(d,h,theta)); 
 }
  
-bool IN_ZJ2(const float_& d, const float_& h, const float_& theta) { // REGION 6
+template <typename T = float_>
+bool IN_ZJ2(const T& d, const T& h, const T& theta) { // REGION 6
     return (((h > 0 && h < 3/(float_)5) && (theta > X6(d, h) && theta < X8(d,h))) && IN_A(d,h,theta)); 
 }
  
-bool IN_ZJ3(const float_& d, const float_& h, const float_& theta) { // REGION 7
+template <typename T = float_>
+bool IN_ZJ3(const T& d, const T& h, const T& theta) { // REGION 7
     return (((h > 0 && h < 1/(float_)2) && (theta > X8(d, h) && theta < X9(d,h))) && IN_A(d,h,theta)); 
 }
  
-bool IN_ZJ4(const float_& d, const float_& h, const float_& theta) { // REGION 8
+template <typename T = float_>
+bool IN_ZJ4(const T& d, const T& h, const T& theta) { // REGION 8
     return (((h > 0 && h < 1/(float_)2) && (theta > X9(d, h) && theta < X7(d,h))) && IN_A(d,h,theta)); 
 }
  
-bool IN_ZJ5(const float_& d, const float_& h, const float_& theta) { // REGION 9
+template <typename T = float_>
+bool IN_ZJ5(const T& d, const T& h, const T& theta) { // REGION 9
     return (((h > 0 && h < 2/(float_)5) && (theta > X7(d, h) && theta < X11(d,h))) && IN_A(d,h,theta)); 
 }
  
-bool IN_ZJ6(const float_& d, const float_& h, const float_& theta) { // REGION 10
-    return (((h > 0 && h < 1/(float_)3) && (theta > X11(d, h) && theta < atan((DELTA-h)/DELTA))) && IN_A(d,h,theta)); 
+template <typename T = float_>
+bool IN_ZJ6(const T& d, const T& h, const T& theta) { // REGION 10
+    return (((h > 0 && h < 1/(float_)3) && (theta > X11(d, h) && theta < atan(((T)DELTA-h)/(T)DELTA))) && IN_A(d,h,theta)); 
 }
  
-bool IN_BETA19(const float_& d, const float_& h, const float_& theta) { 
-    return ((h > 0 && h < d) && (theta > atan((DELTA-h)/DELTA) && theta < atan(d-h))); 
+template <typename T = float_>
+bool IN_BETA19(const T& d, const T& h, const T& theta) { 
+    return ((h > 0 && h < d) && (theta > atan(((T)DELTA-h)/(T)DELTA) && theta < atan(d-h))); 
 }
 
 /// Regions determining a first collision on \Gamma_0, \Gamma_2 or \Gamma_3
-bool IN_G0(const float_& d, const float_& h, const float_& theta) { 
-    return ((h > 0 && h < d) && (theta > X0 && theta < atan((DELTA-h)/DELTA))); 
+template <typename T = float_>
+bool IN_G0(const T& d, const T& h, const T& theta) { 
+    return ((h > 0 && h < d) && (theta > X0 && theta < atan(((T)DELTA-h)/(T)DELTA))); 
 }
  
-bool IN_G2(const float_& d, const float_& h, const float_& theta) { 
-    return ((h > 0 && h < d) && (theta > atan((DELTA-h)/DELTA) && theta < X16(d,h))); 
+template <typename T = float_>
+bool IN_G2(const T& d, const T& h, const T& theta) { 
+    return ((h > 0 && h < d) && (theta > atan(((T)DELTA-h)/(T)DELTA) && theta < X16(d,h))); 
 } 
  
-bool IN_G3(const float_& d, const float_& h, const float_& theta) { 
+template <typename T = float_>
+bool IN_G3(const T& d, const T& h, const T& theta) { 
     return ((h > 0 && h < d) && (theta > X16(d,h) && theta < X19)); 
 } 
 // ===================================================================================
@@ -198,17 +249,35 @@ bool IN_G3(const float_& d, const float_& h, const float_& theta) {
 // ===================================================================================
 // INTEGER FUNCTIONS FOR BOUNCING TRAJECTORIES. START.
 // ===================================================================================
+/// Equation 6, from t = tan(theta)
+template <typename T = float_>
+int_ll alphaFromTan(const T& d, const T& h, const T& t) { 
+    return ceil((-h - t) / (d * (1 + t)));
+}
+/// Equation 11, from t = tan(theta)
+template <typename T = float_>
+int_ll kappaFromTan(const T& d, const T& h, const T& t) { 
+    return ceil((d - h - t) / (d*(t - 1)));
+}
+/// Equation 13, from t = tan(theta)
+template <typename T = float_>
+int_ll gammaFromTan(const T& d, const T& h, const T& t) { 
+    return ceil((h - 1 - d) / (d*(1 - t)));
+}
 /// Equation 6
-int_ll alpha(const float_& d, const float_& h, const float_& theta) { 
-    return ceil((-h - tan(theta)) / (d * (1 + tan(theta))));
+template <typename T = float_>
+int_ll alpha(const T& d, const T& h, const T& theta) { 
+    return alphaFromTan(d, h, tan(theta));
 }
 /// Equation 11
-int_ll kappa(const float_& d, const float_& h, const float_& theta) { 
-    return ceil((d - h - tan(theta)) / (d*(tan(theta) - 1)));
+template <typename T = float_>
+int_ll kappa(const T& d, const T& h, const T& theta) { 
+    return kappaFromTan(d, h, tan(theta));
 }
 /// Equation 13
-int_ll gamma(const float_& d, const float_& h, const float_& theta) { 
-    return ceil((h - 1 - d) / (d*(1 - tan(theta))));
+template <typename T = float_>
+int_ll gamma(const T& d, const T& h, const T& theta) { 
+    return gammaFromTan(d, h, tan(theta));
 }
 // ===================================================================================
 // INTEGER FUNCTIONS FOR BOUNCING TRAJECTORIES. END.
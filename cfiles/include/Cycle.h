@@ -0,0 +1,71 @@
+/**
+ * @brief Detection of exactly periodic orbits, which trajectories then skip over in closed form
+ *
+ * A step of the map acts on (h, theta, label) alone: the dwell time and the change of position
+ * follow from them. When these repeat bit for bit after p steps, the orbit repeats them from then
+ * on, each period moving the particle by the same dx in the same time dt, so any number m of
+ * whole periods is skipped by adding m*dx and m*dt (e.g. the ballistic orbits theta = 0, pi).
+ * Positions are exact. Times are sums in closed form rather than step by step, so they may
+ * differ from those of stepping in the last bits.
+ */
+
+#ifndef CYCLE_H_INCLUDED
+#define CYCLE_H_INCLUDED
+
+#include <array>
+#include <cmath>
+#include "config.h"
+
+constexpr size_t CYCLE_MAX_PERIOD = 8; // Longest period detected
+
+template <typename T>
+class CycleDetector
+{
+    public:
+	/**@brief Adds the state reached by a step, at position `x` and total time `t`
+	 * @return Period of the cycle the particle is in, 0 if none is found
+	*/
+	size_t Push(const T& h, const T& theta, const int& label, const int_ll& x, const T& t) {
+	    period = 0;
+	    if (label != -1) {
+		for (size_t p = 1; p <= std::min(n, CYCLE_MAX_PERIOD); ++p) {
+		    const State& S = history[(n - p) % CYCLE_MAX_PERIOD];
+		    if (S.label == label && Same(S.h, h) && Same(S.theta, theta)) {
+			period = p;
+			dx = x - S.x;
+			dt = t - S.t;
+			break;
+		    }
+		}
+	    }
+	    history[n % CYCLE_MAX_PERIOD] = { h, theta, label, x, t };
+	    n++;
+	    return period;
+	}
+
+	/// Forgets the states seen, e.g. after skipping ahead
+	void Reset() { n = 0; period = 0; }
+
+	size_t Period() const { return period; }
+	int_ll Displacement() const { return dx; } // Change of position over a period
+	T Duration() const { return dt; }	   // Time of a period
+
+    private:
+	struct State {
+	    T h, theta;
+	    int label;
+	    int_ll x;
+	    T t;
+	};
+
+	// Equal, and of the same sign for zeros, so that the next steps are identical
+	static bool Same(const T& a, const T& b) { return a == b && std::signbit(a) == std::signbit(b); }
+
+	std::array<State, CYCLE_MAX_PERIOD> history;
+	size_t n = 0;	   // States pushed since the last reset
+	size_t period = 0;
+	int_ll dx = 0;
+	T dt = 0;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef ENSEMBLE_H_INCLUDED
+#define ENSEMBLE_H_INCLUDED
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "config.h"
+#include "Particle.h"
+#include "SMapHelper.h"
+#include "Classifier.h"
+
+/**@brief Structure-of-arrays equivalent of std::vector<SParticle>
+ *
+ * Each member of `SParticle` is held in its own contiguous array so that a batch of
+ * particles can be stepped with `ScatteringMap::EvolveBatch` without per-particle objects.
+ */
+template <typename T>
+struct ParticleEnsemble {
+
+    ParticleEnsemble() = default;
+
+    ParticleEnsemble(const size_t& n) { Resize(n); }
+
+    // Ensemble from initial conditions in coordinate space
+    ParticleEnsemble(const std::vector<T>& h, const std::vector<T>& theta) {
+	if (h.size() != theta.size())
+	    throw std::invalid_argument("ERROR: Mismatched `h` and `theta` sizes in @ParticleEnsemble().");
+	H = h;
+	Theta = theta;
+	Resize(h.size());
+	whichRegionBatch<T>(H.data(), Theta.data(), Label.data(), size());
+    }
+
+    void Resize(const size_t& n) {
+	H.resize(n);
+	Theta.resize(n);
+	Tau.resize(n,(T)0);
+	Position.resize(n,0);
+	Label.resize(n,-1);
+    }
+
+    void Set(const size_t& i, const T& h, const T& theta, const T& tau, const int_ll& position, const int& label) {
+	H[i] = h;
+	Theta[i] = theta;
+	Tau[i] = tau;
+	Position[i] = position;
+	Label[i] = label;
+    }
+
+    void Set(const size_t& i, const SParticle<T>& SP) {
+	Set(i, SP.H, SP.Theta, SP.Tau, SP.Position, SP.Label);
+    }
+
+    /// Appends an `SParticle` to the end of the ensemble
+    void Add(const SParticle<T>& SP) {
+	H.push_back(SP.H);
+	Theta.push_back(SP.Theta);
+	Tau.push_back(SP.Tau);
+	Position.push_back(SP.Position);
+	Label.push_back(SP.Label);
+    }
+
+    /// Copies the `i`th particle out of the ensemble
+    SParticle<T> Get(const size_t& i) const {
+	SParticle<T> SP(H[i], Theta[i], Tau[i], Position[i]);
+	SP.Label = Label[i];
+	return SP;
+    }
+
+    size_t size() const { return H.size(); }
+
+    std::vector<T> H, Theta, Tau;  // Entrance heights, angles and dwell times
+    std::vector<int_ll> Position;  // Lifted position of each particle
+    std::vector<int> Label;	   // Region label
+};
+
+/**@brief An ensemble evolved in continuous time, one time of a grid after another
+ *
+ * Holds the state of each particle after its last step, the state before it, and the times at
+ * which both were reached, so a snapshot at any time up to the current one is taken as in 
+ * `ScatteringMap::getTrajectory(SP, Time)` without storing trajectories. Advanced with 
+ * `ScatteringMap::AdvanceBatch`.
+ */
+template <typename T>
+struct TimedEnsemble {
+
+    TimedEnsemble() = default;
+
+    /// Ensemble at its initial states, whose time is their dwell time
+    TimedEnsemble(ParticleEnsemble<T> PE) : Current(std::move(PE)), Previous(Current.size()), Clock(Current.Tau), 
+					    PreviousClock(Current.size(), (T)0), Steps(Current.size(), 0) { }
+
+    /**@brief Copies the state of particle `i` nearest in time to `t` into `Snapshot`
+    *
+    * The state is the later of the last two when it was reached closer to `t`, the earlier 
+    * otherwise. A particle that has not reached `t` (it stopped in no region, or is yet to be 
+    * advanced) is given the defaults of an unrecorded `STrajectory` entry: zeros and label -1.
+    */
+    void Record(const size_t& i, const T& t, ParticleEnsemble<T>& Snapshot, std::vector<T>& SnapshotTime) const {
+	if (Steps[i] == 0 || Clock[i] < t) {
+	    Snapshot.Set(i, (T)0, (T)0, (T)0, 0, -1);
+	    SnapshotTime[i] = 0;
+	    return;
+	}
+	const bool later = (Clock[i] - t) < std::abs(PreviousClock[i] - t);
+	const ParticleEnsemble<T>& State = later ? Current : Previous;
+	Snapshot.Set(i, State.H[i], State.Theta[i], State.Tau[i], State.Position[i], State.Label[i]);
+	SnapshotTime[i] = later ? Clock[i] : PreviousClock[i];
+    }
+
+    size_t size() const { return Current.size(); }
+
+    ParticleEnsemble<T> Current, Previous; // States after and before the last step
+    std::vector<T> Clock, PreviousClock;   // Times at which these were reached
+    std::vector<std::uint64_t> Steps;	   // Steps taken by each particle
+};
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @brief Compile-time descriptions of each channel width, and a dispatcher from the runtime selection
+ *
+ * Code templated on a geometry reads d and the label set as constants instead of `config::d`
+ * and `config::widthSelection`, so width-dependent branches fold at compile time.
+ */
+
+#ifndef GEOMETRY_H_INCLUDED
+#define GEOMETRY_H_INCLUDED
+
+#include <array>
+#include <stdexcept>
+#include "config.h"
+
+template <size_t WIDTH>
+struct ChannelGeometry;
+
+/// d = 1/2 (config::widthSelection = 0)
+template <>
+struct ChannelGeometry<0> {
+    static constexpr size_t widthSelection = 0;
+    static constexpr float_ d = config::channel_widths[0];
+    static constexpr float_ dx = DX;
+    static constexpr float_ dx2 = DX2;
+    static constexpr std::array<int, 19> labels = { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18 };
+};
+
+/// d = 1 (config::widthSelection = 1)
+template <>
+struct ChannelGeometry<1> {
+    static constexpr size_t widthSelection = 1;
+    static constexpr float_ d = config::channel_widths[1];
+    static constexpr float_ dx = DX;
+    static constexpr float_ dx2 = DX2;
+    static constexpr std::array<int, 16> labels = { 0,4,5,6,8,9,10,11,12,13,14,15,16,17,18,19 };
+};
+
+using HalfWidth = ChannelGeometry<0>;
+using UnitWidth = ChannelGeometry<1>;
+
+/**@brief Calls `func(Geometry{})` with the geometry of the current `config::widthSelection`
+ *
+ * Use to pick a compile-time specialisation once, outside any hot loop, e.g.
+ *     withGeometry([&](auto G) { ScatteringMap<T, decltype(G)> Map; ... });
+ * @param func Generic callable taking a geometry by value
+*/
+template <typename F>
+decltype(auto) withGeometry(F&& func) {
+    switch (config::widthSelection) {
+	case 0: return func(HalfWidth{});
+	case 1: return func(UnitWidth{});
+	default:
+	    throw std::runtime_error("ERROR: Invalid `widthSelection`.");
+    }
+}
+
+#endif
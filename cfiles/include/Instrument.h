@@ -0,0 +1,203 @@
+/**
+ * @brief Optional instrumentation of the hot path: steps and their cycle counts per region,
+ * classifications, and rejection sampling attempts per region
+ *
+ * Compiled in only when `SMAP_INSTRUMENT` is defined (`make INSTRUMENT=1`). Otherwise every
+ * `SMAP_*` macro below expands to nothing, so the instrumented headers cost nothing. Counters
+ * are kept per thread and added to a process-wide total when the thread exits. The total is
+ * printed, and written to `Instrument.json` in the study's data directory, at exit.
+ */
+
+#ifndef INSTRUMENT_H_INCLUDED
+#define INSTRUMENT_H_INCLUDED
+
+#ifdef SMAP_INSTRUMENT
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include "config.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+constexpr size_t INSTRUMENT_BUCKETS = 65; // Bucket k of a cycle histogram holds counts c with bit_width(c) = k
+
+/// Time stamp counter, or nanoseconds where there is none
+inline std::uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct InstrumentCounters {
+    std::array<std::uint64_t, N_LABELS> steps{};	// Steps of the map by label of the state stepped from
+    std::array<std::uint64_t, N_LABELS> stepCycles{}; // Total cycles of these steps
+    std::array<std::array<std::uint64_t, INSTRUMENT_BUCKETS>, N_LABELS> cycleHistogram{};
+    std::array<std::uint64_t, N_LABELS + 1> classified{}; // Classifications by label, [0] for no region
+    std::uint64_t escalated = 0;  // Classifications repeated in float_wide
+    std::uint64_t wideSteps = 0;  // Steps repeated in float_wide (also counted in `steps`)
+    std::array<std::uint64_t, N_LABELS> proposals{}, accepted{}; // Rejection sampling of each region
+
+    void Merge(const InstrumentCounters& other) {
+	for (size_t l = 0; l < N_LABELS; ++l) {
+	    steps[l] += other.steps[l];
+	    stepCycles[l] += other.stepCycles[l];
+	    for (size_t k = 0; k < INSTRUMENT_BUCKETS; ++k)
+		cycleHistogram[l][k] += other.cycleHistogram[l][k];
+	    proposals[l] += other.proposals[l];
+	    accepted[l] += other.accepted[l];
+	}
+	for (size_t l = 0; l <= N_LABELS; ++l)
+	    classified[l] += other.classified[l];
+	escalated += other.escalated;
+	wideSteps += other.wideSteps;
+    }
+
+    /// Upper bound of the bucket holding the q-quantile of the cycles of steps from `label`
+    std::uint64_t CycleQuantile(const size_t& label, const double& q) const {
+	std::uint64_t seen = 0;
+	for (size_t k = 0; k < INSTRUMENT_BUCKETS; ++k) {
+	    seen += cycleHistogram[label][k];
+	    if (seen > q*steps[label])
+		return k == 0 ? 0 : (k == 64 ? UINT64_MAX : ((std::uint64_t)1 << k) - 1);
+	}
+	return 0;
+    }
+
+    void Print(std::ostream& os) const {
+	std::uint64_t totalSteps = 0, totalCycles = 0;
+	for (size_t l = 0; l < N_LABELS; ++l) {
+	    totalSteps += steps[l];
+	    totalCycles += stepCycles[l];
+	}
+	os << "Instrumentation: " << totalSteps << " steps (" << wideSteps << " repeated in float_wide), "
+	   << escalated << " classifications repeated in float_wide.\n"
+	   << std::setw(6) << "label" << std::setw(14) << "steps" << std::setw(10) << "% cycles" << std::setw(12)
+	   << "cycles/step" << std::setw(12) << "median <=" << std::setw(14) << "classified" << std::setw(12)
+	   << "accepted" << std::setw(14) << "attempts/pt" << "\n";
+	for (size_t l = 0; l < N_LABELS; ++l) {
+	    if (!steps[l] && !classified[l+1] && !accepted[l]) continue;
+	    os << std::setw(6) << l << std::setw(14) << steps[l] << std::fixed << std::setprecision(1)
+	       << std::setw(10) << (totalCycles ? 100.*stepCycles[l]/totalCycles : 0.)
+	       << std::setw(12) << (steps[l] ? (double)stepCycles[l]/steps[l] : 0.) << std::defaultfloat
+	       << std::setw(12) << CycleQuantile(l, 0.5) << std::setw(14) << classified[l+1] << std::setw(12) << accepted[l]
+	       << std::fixed << std::setprecision(3) << std::setw(14) << (accepted[l] ? (double)proposals[l]/accepted[l] : 0.) 
+	       << std::defaultfloat << "\n";
+	}
+	os << "No region: " << classified[0] << " classifications.\n";
+    }
+
+    void WriteJSON(const std::string& fname) const {
+	nlohmann::ordered_json j;
+	j["steps"] = steps;
+	j["step_cycles"] = stepCycles;
+	j["cycle_histogram"] = cycleHistogram; // [label][k]: steps of bit_width(cycles) = k
+	j["classified"] = classified;	       // [label + 1], [0] for no region
+	j["escalated"] = escalated;
+	j["wide_steps"] = wideSteps;
+	j["proposals"] = proposals;
+	j["accepted"] = accepted;
+	std::ofstream ofs(fname);
+	if (!ofs.is_open()) {
+	    std::cerr << "WARNING: Could not write instrumentation to " << fname << ".\n";
+	    return;
+	}
+	ofs << j.dump(4);
+    }
+};
+
+/**@brief Process-wide total of the counters of exited threads, reported at exit
+ */
+class InstrumentReport
+{
+    public:
+	void Merge(const InstrumentCounters& counters) {
+	    std::lock_guard<std::mutex> lock(mutex);
+	    totals.Merge(counters);
+	}
+
+	InstrumentCounters Totals() {
+	    std::lock_guard<std::mutex> lock(mutex);
+	    return totals;
+	}
+
+	~InstrumentReport() {
+	    totals.Print(std::cerr);
+	    totals.WriteJSON(config::DataPath + "Instrument.json");
+	}
+
+    private:
+	std::mutex mutex;
+	InstrumentCounters totals;
+};
+
+inline InstrumentReport& getInstrumentReport() {
+    static InstrumentReport Report;
+    return Report;
+}
+
+/// Counters of the calling thread, added to `getInstrumentReport()` when it exits
+inline InstrumentCounters& getThreadCounters() {
+    struct ThreadCounters : InstrumentCounters {
+	ThreadCounters() { getInstrumentReport(); } // Constructed first, so destroyed after every thread's counters
+	~ThreadCounters() { getInstrumentReport().Merge(*this); }
+    };
+    thread_local ThreadCounters Counters;
+    return Counters;
+}
+
+/// Totals of the exited threads and the calling thread
+inline InstrumentCounters getInstrumentTotals() {
+    InstrumentCounters Totals = getInstrumentReport().Totals();
+    Totals.Merge(getThreadCounters());
+    return Totals;
+}
+
+/**@brief Counts a step from `label` and its cycles, from construction to destruction
+ */
+class StepTimer
+{
+    public:
+	StepTimer(const int& label) : label(label), start(readCycles()) { }
+
+	~StepTimer() {
+	    if (label < 0 || label >= (int)N_LABELS) return;
+	    const std::uint64_t cycles = readCycles() - start;
+	    InstrumentCounters& C = getThreadCounters();
+	    C.steps[label]++;
+	    C.stepCycles[label] += cycles;
+	    C.cycleHistogram[label][std::bit_width(cycles)]++;
+	}
+
+    private:
+	const int label;
+	const std::uint64_t start;
+};
+
+#define SMAP_STEP_TIMER(label) const StepTimer smapStepTimer_(label)
+#define SMAP_COUNT_CLASSIFIED(label) (getThreadCounters().classified[(label) + 1]++)
+#define SMAP_COUNT_ESCALATED() (getThreadCounters().escalated++)
+#define SMAP_COUNT_WIDE_STEP() (getThreadCounters().wideSteps++)
+#define SMAP_COUNT_PROPOSAL(label) (getThreadCounters().proposals[label]++)
+#define SMAP_COUNT_ACCEPTED(label) (getThreadCounters().accepted[label]++)
+
+#else
+
+#define SMAP_STEP_TIMER(label) ((void)0)
+#define SMAP_COUNT_CLASSIFIED(label) ((void)0)
+#define SMAP_COUNT_ESCALATED() ((void)0)
+#define SMAP_COUNT_WIDE_STEP() ((void)0)
+#define SMAP_COUNT_PROPOSAL(label) ((void)0)
+#define SMAP_COUNT_ACCEPTED(label) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * @brief Precomputed index of region labels over a grid of cells in (h,theta)
+ *
+ * A region label only changes across a singular direction X1...X18 (and the other bounds
+ * listed in RegionCover.h) or across one of the thresholds in h of the indicator functions.
+ * Cells crossed by none of these lie wholly inside one region, and their label is stored.
+ * Points in such a cell are classified by one load; the remaining cells are marked `MIXED`
+ * and fall back to `whichRegion`, so labels are identical to it everywhere.
+ */
+
+#ifndef LABELINDEX_H_INCLUDED
+#define LABELINDEX_H_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "CoordinateSpace.h"
+#include "RegionCover.h"
+
+// Defined in SMapHelper.h
+template <typename T> T getThetaRHS(const T& theta);
+template <typename T> int whichRegion(const T& h, const T& theta);
+
+constexpr size_t LABEL_INDEX_H = 512;	   // Cells along h in (0,d)
+constexpr size_t LABEL_INDEX_THETA = 1024;  // Cells along theta in (-pi/2,pi/2)
+
+/// Margin by which cells are widened before testing them against the boundaries. Absorbs
+/// rounding in the boundaries, also when the predicates are evaluated in float, and in the 
+/// cell index of a point near a cell edge
+constexpr float_ LABEL_INDEX_GUARD = 1e-5;
+
+const std::string LABEL_INDEX_MAGIC = "SMLI";
+constexpr std::uint32_t LABEL_INDEX_VERSION = 1;
+
+struct LabelIndex {
+
+    static constexpr signed char MIXED = -2;
+
+    LabelIndex() = default;
+
+    /// Index of the current `config::widthSelection`
+    LabelIndex(const size_t& nH_, const size_t& nTheta_) :
+	widthSelection(config::widthSelection), d(config::d), nH(nH_), nTheta(nTheta_),
+	cells(nH_*nTheta_, MIXED) {
+	Scale();
+	std::vector<BoundaryFn> curves = { X1, X2, X3, X4, X5, X6, X7, X8, X9, X10, X11, X12,
+					   X13, X14, X15, X16, X17, X18, XG };
+	std::vector<float_> hCuts = { 1/(float_)8, 1/(float_)6, 1/(float_)4, 1/(float_)3 };
+	if (widthSelection == 1) {
+	    curves.insert(curves.end(), { XA0, XA1, XB19 });
+	    hCuts = { 1/(float_)3, 2/(float_)5, 1/(float_)2, 3/(float_)5, 2/(float_)3 };
+	}
+	const float_ dTheta = PI/nTheta;
+	std::vector<unsigned char> crossed(nTheta);
+	for (size_t i = 0; i < nH; ++i) {
+	    const float_ h0 = d*i/nH - LABEL_INDEX_GUARD, h1 = d*(i+1)/nH + LABEL_INDEX_GUARD;
+	    if (std::ranges::any_of(hCuts, [&](const float_& c) { return h0 <= c && c <= h1; }))
+		continue;
+	    std::fill(crossed.begin(), crossed.end(), 0);
+	    for (auto f : curves) {
+		// Boundaries are monotone in h, so over the column they stay within their end values
+		const float_ lo = std::min(f(d,h0), f(d,h1)) - LABEL_INDEX_GUARD;
+		const float_ hi = std::max(f(d,h0), f(d,h1)) + LABEL_INDEX_GUARD;
+		if (hi < -PI2 || lo > PI2) continue;
+		const size_t j0 = std::max(lo + PI2, (float_)0)/dTheta;
+		const size_t j1 = std::min((size_t)((hi + PI2)/dTheta), nTheta - 1);
+		for (size_t j = j0; j <= j1; ++j) crossed[j] = 1;
+	    }
+	    for (size_t j = 0; j < nTheta; ++j) {
+		if (crossed[j]) continue;
+		const float_ h = d*(i + 0.5)/nH, theta = -PI2 + dTheta*(j + 0.5);
+		cells[i*nTheta + j] = whichRegion<float_>(h, theta);
+	    }
+	}
+    }
+
+    /**@brief Region label of (h,theta), identical to `whichRegion`
+    */
+    template <typename T>
+    int Classify(const T& h, const T& theta) const {
+	const float_ H = h, Theta = getThetaRHS(theta);
+	if (H > 0 && H < d && Theta > -PI2 && Theta < PI2) {
+	    const size_t i = std::min((size_t)(H*hScale), nH - 1);
+	    const size_t j = std::min((size_t)((Theta + PI2)*thetaScale), nTheta - 1);
+	    const signed char label = cells[i*nTheta + j];
+	    if (label != MIXED)
+		return label;
+	}
+	return whichRegion<T>(h, theta);
+    }
+
+    /// Fraction of cells answered without falling back to `whichRegion`
+    float_ CleanFraction() const {
+	return cells.empty() ? 0 : (float_)std::ranges::count_if(cells, [](const signed char& c) { return c != MIXED; })/cells.size();
+    }
+
+    /**@brief Writes the index to a binary cache file
+    */
+    void Save(const std::string& fname) const {
+	std::ofstream ofs(fname, std::ios::binary);
+	if (!ofs.is_open())
+	    throw std::runtime_error("ERROR: Could not open file: " + fname + ".");
+	ofs.write(LABEL_INDEX_MAGIC.data(), LABEL_INDEX_MAGIC.size());
+	const std::uint32_t header[4] = { LABEL_INDEX_VERSION, (std::uint32_t)widthSelection,
+					  (std::uint32_t)nH, (std::uint32_t)nTheta };
+	ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+	ofs.write(reinterpret_cast<const char*>(&d), sizeof(d));
+	ofs.write(reinterpret_cast<const char*>(&LABEL_INDEX_GUARD), sizeof(LABEL_INDEX_GUARD));
+	ofs.write(reinterpret_cast<const char*>(cells.data()), cells.size());
+    }
+
+    /**@brief Reads an index written by `Save`
+    * @return False, leaving the index unchanged, unless the file holds an index of the
+    * current width, resolution and format
+    */
+    bool Load(const std::string& fname) {
+	std::ifstream ifs(fname, std::ios::binary);
+	if (!ifs.is_open())
+	    return false;
+	std::string magic(LABEL_INDEX_MAGIC.size(), ' ');
+	std::uint32_t header[4];
+	float_ d_, guard;
+	ifs.read(magic.data(), magic.size());
+	ifs.read(reinterpret_cast<char*>(header), sizeof(header));
+	ifs.read(reinterpret_cast<char*>(&d_), sizeof(d_));
+	ifs.read(reinterpret_cast<char*>(&guard), sizeof(guard));
+	if (!ifs || magic != LABEL_INDEX_MAGIC || header[0] != LABEL_INDEX_VERSION
+	    || header[1] != config::widthSelection || header[2] != LABEL_INDEX_H
+	    || header[3] != LABEL_INDEX_THETA || d_ != config::d || guard != LABEL_INDEX_GUARD)
+	    return false;
+	std::vector<signed char> cells_(header[2]*header[3]);
+	ifs.read(reinterpret_cast<char*>(cells_.data()), cells_.size());
+	if (!ifs || ifs.peek() != std::char_traits<char>::eof())
+	    return false;
+	widthSelection = header[1];
+	d = d_;
+	nH = header[2];
+	nTheta = header[3];
+	cells = std::move(cells_);
+	Scale();
+	return true;
+    }
+
+    size_t widthSelection = 0;
+    float_ d = 0;
+    size_t nH = 0, nTheta = 0;
+    float_ hScale = 0, thetaScale = 0;
+    std::vector<signed char> cells; // Label of cell (i,j) at i*nTheta + j, or MIXED
+
+private:
+    void Scale() {
+	hScale = nH/d;
+	thetaScale = nTheta/PI;
+    }
+};
+
+/**@brief Label index of the current width. Built once per width
+*
+* The index is read from `FILE_LABEL_INDEX` in the study's data directory when a matching
+* one is there, and otherwise built and written there (if the directory exists).
+*/
+const LabelIndex& getLabelIndex() {
+    static std::array<LabelIndex, config::channel_widths.size()> indices;
+    static std::array<std::once_flag, config::channel_widths.size()> built;
+    const size_t w = config::widthSelection;
+    std::call_once(built[w], [w] {
+	const std::string fname = config::DataPath + config::FILE_LABEL_INDEX;
+	if (indices[w].Load(fname))
+	    return;
+	indices[w] = LabelIndex(LABEL_INDEX_H, LABEL_INDEX_THETA);
+	if (std::filesystem::is_directory(config::DataPath))
+	    indices[w].Save(fname);
+    });
+    return indices[w];
+}
+
+#endif
@@ -17,9 +17,9 @@ template <typename T>
 struct SParticle {
     // Uniform random state
     SParticle() {
-	Random<T> h, theta;
-	T H = h.getUniformRandom(0, d);
-	T Theta = theta.getUniformRandom(-PI/(T)2, PI/(T)2);
+	Random<T> rng;
+	T H = rng.getUniformRandom(0, d);
+	T Theta = rng.getUniformRandom(-PI/(T)2, PI/(T)2);
 	Set(H, Theta, (T)0, 0, whichRegion<T>(H,Theta));
     }
 
@@ -33,10 +33,13 @@ struct SParticle {
     }
 
     SParticle(const std::pair<T,T>& h_interval, const std::pair<T,T>& theta_interval) {
-	Random<T> h, theta;
-	T H = h.getUniformRandom(h_interval.first, h_interval.second);
-	T Theta = theta.getUniformRandom(theta_interval.first, theta_interval.second);
-	Set(H, Theta, (T)0, 0, whichRegion<T>(H,Theta));
+	Random<T> rng;
+	Set(h_interval, theta_interval, rng);
+    }
+
+    // Uniform random in a rectangle, drawn from a given stream
+    SParticle(const std::pair<T,T>& h_interval, const std::pair<T,T>& theta_interval, Random<T>& rng) {
+	Set(h_interval, theta_interval, rng);
     }
 
     // Random inside a region 
@@ -59,6 +62,12 @@ struct SParticle {
 	Label = label;
     }
 
+    void Set(const std::pair<T,T>& h_interval, const std::pair<T,T>& theta_interval, Random<T>& rng) {
+	T H = rng.getUniformRandom(h_interval.first, h_interval.second);
+	T Theta = rng.getUniformRandom(theta_interval.first, theta_interval.second);
+	Set(H, Theta, (T)0, 0, whichRegion<T>(H,Theta));
+    }
+
     void Print() {
 	std::cout << std::setprecision(3) << std::fixed
 	<< "SParticle (d = " << d << ") {"
@@ -0,0 +1,199 @@
+/**
+ * @brief Background stage that writes batches of trajectories while the next batch is computed
+ */
+
+#ifndef PIPELINE_H_INCLUDED
+#define PIPELINE_H_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "config.h"
+#include "Writer.h"
+#include "Trajectory.h"
+
+constexpr size_t PIPELINE_DEPTH = 2;  // Batches in flight per I/O thread
+constexpr size_t PIPELINE_ARENAS = PIPELINE_DEPTH + 2; // Batches held by a pipeline: filled, queued or being written
+constexpr size_t PIPELINE_BYTES = (size_t)1 << 31;     // Budget of the arenas of a pipeline (2 GiB)
+constexpr size_t WRITER_THREADS = 2;  // Default number of I/O threads
+
+/**@brief Bounded single-producer single-consumer ring buffer
+ *
+ * Lock free: `head` and `tail` are running counts of pops and pushes. A full (empty) queue
+ * blocks the producer (consumer) on the atomic itself rather than spinning.
+ */
+template <typename T, size_t CAPACITY>
+class SPSCQueue
+{
+    public:
+	void Push(T&& x) {
+	    const size_t t = tail.load(std::memory_order_relaxed);
+	    size_t h;
+	    while (t - (h = head.load(std::memory_order_acquire)) == CAPACITY)
+		head.wait(h, std::memory_order_acquire);
+	    slots[t % CAPACITY] = std::move(x);
+	    tail.store(t + 1, std::memory_order_release);
+	    tail.notify_one();
+	}
+
+	T Pop() {
+	    const size_t h = head.load(std::memory_order_relaxed);
+	    size_t t;
+	    while ((t = tail.load(std::memory_order_acquire)) == h)
+		tail.wait(t, std::memory_order_acquire);
+	    T x = std::move(slots[h % CAPACITY]);
+	    head.store(h + 1, std::memory_order_release);
+	    head.notify_one();
+	    return x;
+	}
+
+    private:
+	std::array<T, CAPACITY> slots;
+	std::atomic<size_t> head = 0, tail = 0;
+};
+
+/**@brief Writes batches of trajectories to the trajectory files on background threads
+ *
+ * Batches are `EnsembleTrajectory` arenas owned by the pipeline and recycled: `Acquire` hands
+ * out the next arena once its previous batch is written, and `Push` queues it. The members are
+ * shared between I/O threads (thread i writes files i, i + nThreads, ...) and every thread
+ * writes the batches in the order they were pushed, so the files are identical to writing
+ * synchronously. Memory is bounded by the `PIPELINE_ARENAS` arenas: `Push` blocks while the
+ * I/O threads are `PIPELINE_DEPTH` batches behind, and `Acquire` while its arena is in use.
+ * Batches of at most `MaxBatch` trajectories keep the arenas within `PIPELINE_BYTES`.
+ */
+template <typename T>
+class TrajectoryPipeline
+{
+    public:
+	using Batch = const EnsembleTrajectory<T>*;
+
+	TrajectoryPipeline(std::array<Writer,6>& trajWriters, const size_t& nThreads = WRITER_THREADS)
+	    : writers(trajWriters), queues(std::clamp<size_t>(nThreads, 1, trajWriters.size())), written(queues.size()) {
+	    for (size_t i = 0; i < queues.size(); ++i) {
+		std::vector<size_t> idx;
+		for (size_t k = i; k < writers.size(); k += queues.size())
+		    idx.push_back(k);
+		threads.emplace_back([this, i, idx] { Drain(i, idx); });
+	    }
+	}
+
+	~TrajectoryPipeline() {
+	    try { Close(); } catch (...) { }
+	}
+
+	TrajectoryPipeline(const TrajectoryPipeline&) = delete;
+	TrajectoryPipeline& operator=(const TrajectoryPipeline&) = delete;
+
+	/// Most trajectories of `N` entries per batch for the arenas to fit in `PIPELINE_BYTES`. At least one
+	static size_t MaxBatch(const size_t& N) {
+	    const size_t bytes = std::max<size_t>(N, 1)*EnsembleTrajectory<T>::BytesPerEntry()*PIPELINE_ARENAS;
+	    return std::max<size_t>(PIPELINE_BYTES/bytes, 1);
+	}
+
+	/**@brief Arena for the next batch, of `n` trajectories of `N` entries, to fill and then `Push`
+	* 
+	* Waits for the batch it last held to be written. Rethrows the first error raised while writing
+	*/
+	EnsembleTrajectory<T>& Acquire(const size_t& n, const size_t& N) {
+	    if (failed.load()) Close();
+	    if (threads.empty())
+		throw std::logic_error("ERROR: Acquire from a closed TrajectoryPipeline.");
+	    if (pushed >= arenas.size())
+		Wait(pushed - arenas.size() + 1);
+	    EnsembleTrajectory<T>& Trajs = arenas[pushed % arenas.size()];
+	    Trajs.Reset(n, N);
+	    return Trajs;
+	}
+
+	/// Hands the batch filled since `Acquire` to the I/O threads. Rethrows the first error raised while writing
+	void Push() {
+	    if (failed.load()) Close();
+	    if (threads.empty())
+		throw std::logic_error("ERROR: Push to a closed TrajectoryPipeline.");
+	    for (auto& q : queues)
+		q.Push(&arenas[pushed % arenas.size()]);
+	    pushed++;
+	}
+
+	/// Copies a batch of trajectories of equal length into an arena and hands it to the I/O threads
+	void Push(std::vector<STrajectory<T>>&& trajs) {
+	    if (threads.empty())
+		throw std::logic_error("ERROR: Push to a closed TrajectoryPipeline.");
+	    const size_t N = trajs.empty() ? 0 : trajs[0].N;
+	    EnsembleTrajectory<T>& Trajs = Acquire(trajs.size(), N);
+	    for (size_t j = 0; j < trajs.size(); ++j) {
+		if (trajs[j].N != N)
+		    throw std::invalid_argument("ERROR: Trajectories of a batch must have the same length.");
+		TrajectoryView<T> View = Trajs[j];
+		std::ranges::copy(trajs[j].H, View.H.begin());
+		std::ranges::copy(trajs[j].Theta, View.Theta.begin());
+		std::ranges::copy(trajs[j].Tau, View.Tau.begin());
+		std::ranges::copy(trajs[j].Time, View.Time.begin());
+		std::ranges::copy(trajs[j].Label, View.Label.begin());
+		std::ranges::copy(trajs[j].Position, View.Position.begin());
+		View.nIterations = trajs[j].nIterations;
+	    }
+	    Push();
+	}
+
+	/// Waits for the batches pushed so far to be written. Rethrows the first error raised while writing
+	void Flush() {
+	    Wait(pushed);
+	    if (failed.load()) Close();
+	}
+
+	/// Waits for all batches to be written. Rethrows the first error raised while writing
+	void Close() {
+	    if (!threads.empty()) {
+		for (auto& q : queues)
+		    q.Push(nullptr);
+		for (auto& t : threads)
+		    t.join();
+		threads.clear();
+	    }
+	    if (error) std::rethrow_exception(error);
+	}
+
+    private:
+	void Drain(const size_t& i, const std::vector<size_t>& idx) {
+	    while (Batch batch = queues[i].Pop()) {
+		// After an error keep draining, without writing, so that `Push` and `Flush` cannot block
+		if (!failed.load()) {
+		    try {
+			batch->WriteSelected(writers, idx);
+		    } catch (...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!error) error = std::current_exception();
+			failed.store(true);
+		    }
+		}
+		written[i].fetch_add(1, std::memory_order_release);
+		written[i].notify_one();
+	    }
+	}
+
+	// Waits for every I/O thread to have written the first `n` batches
+	void Wait(const size_t& n) {
+	    for (auto& w : written) 
+		for (size_t k; (k = w.load(std::memory_order_acquire)) < n; )
+		    w.wait(k, std::memory_order_acquire);
+	}
+
+	std::array<Writer,6>& writers;
+	std::array<EnsembleTrajectory<T>, PIPELINE_ARENAS> arenas; // Batch b is filled in arena b % size
+	std::vector<SPSCQueue<Batch, PIPELINE_DEPTH>> queues;
+	std::vector<std::atomic<size_t>> written; // Batches written by each I/O thread
+	size_t pushed = 0;			  // Batches pushed
+	std::vector<std::thread> threads;
+	std::atomic<bool> failed = false;
+	std::mutex errorMutex;
+	std::exception_ptr error;
+};
+
+#endif
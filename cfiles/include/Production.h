@@ -5,6 +5,11 @@
 #define PRODUCTION_H_INCLUDED
 
 #include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <typeinfo>
 #include "config.h"
 #include "Random.h"
 #include "Writer.h"	   
@@ -12,6 +17,208 @@
 #include "SMapHelper.h"
 #include "Particle.h"
 #include "Trajectory.h"
+#include "ThreadPool.h"
+#include "Pipeline.h"
+#include "Shadow.h"
+#include "Transport.h"
+#include "Transitions.h"
+#include "Words.h"
+#include "Checkpoint.h"
+#include "Snapshot.h"
+
+constexpr size_t PARTICLE_CHUNK = 8;   // Particles per work-stealing chunk
+constexpr size_t PARTICLE_BATCH = 256; // Particles per thread held in memory before writing, for short trajectories
+constexpr size_t REGION_PASSES = 64;   // Independent passes of `WriteRegionPoints`
+constexpr size_t REDUCE_PASSES = 64;   // Blocks of particles reduced independently by `ReduceParticles`
+
+/**@brief Evolves and writes the trajectories of a sequence of initial conditions over a thread pool
+ *
+ * Particles are processed in batches, recorded into `EnsembleTrajectory` arenas that are reused
+ * from batch to batch. Batches hold `PARTICLE_BATCH` particles per thread, or fewer when longer 
+ * trajectories would take the arenas over `PIPELINE_BYTES` (`TrajectoryPipeline::MaxBatch`). 
+ * Within a batch, chunks of particles are shared between threads by work stealing. Completed 
+ * batches are handed to a `TrajectoryPipeline`, which writes them in their original order while
+ * the next batch is computed, so the output does not depend on the number of threads. Trajectories that reach a state in no region are cut short there 
+ * (label -1), and their initial conditions are listed at the end.
+ *
+ * Only the initial conditions in `slice` are written, the share of this process in a sharded
+ * run (see `getShardSlice`). The call starts from the initial condition `Progress.particle` when
+ * resuming, and saves `Progress` between batches when a checkpoint is due. On return it counts
+ * as a completed call of the run.
+ * @param Pool Thread pool
+ * @param nParticles Number of initial conditions
+ * @param getParticle Callable returning the `j`th initial condition as an `SParticle`
+ * @param iterates Iterates to record
+ * @param TrajWriters Writers for each member of `STrajectory`
+ * @param Progress State of the run (Checkpoint.h)
+ * @param slice Initial conditions [first, last) written
+ * @return Shadow runs in float_ of the first `config::shadowParticles` initial conditions over the
+ * last iterate, when T is a lower precision and this is the first shard. Empty otherwise. Also 
+ * added to `Progress.shadow`
+*/
+template <typename T, typename F>
+ShadowReport WriteTrajectories(ThreadPool& Pool, const size_t& nParticles, F&& getParticle, 
+			       const std::vector<size_t>& iterates, std::array<Writer,6>& TrajWriters, Checkpoint& Progress,
+			       const std::pair<size_t, size_t>& slice) {
+    std::vector<std::uint64_t>& Unresolved = Progress.unresolved; // Initial conditions of trajectories cut short
+    withGeometry([&](auto G) { // Map specialised for the selected width
+	ScatteringMap<T, decltype(G)> Map;
+	const size_t batchSize = std::min(PARTICLE_BATCH*Pool.size(), TrajectoryPipeline<T>::MaxBatch(iterates.size()));
+	TrajectoryPipeline<T> Pipeline(TrajWriters);
+	for (size_t b = std::max(slice.first, (size_t)Progress.particle); b < slice.second; b += batchSize) {
+	    const size_t e = std::min(b + batchSize, slice.second);
+	    EnsembleTrajectory<T>& Trajs = Pipeline.Acquire(e - b, iterates.size()); // Reused, not reallocated
+	    Pool.ParallelFor(e - b, PARTICLE_CHUNK, [&](size_t first, size_t last, size_t) {
+		for (size_t j = first; j < last; ++j) {
+		    SParticle<T> Particle = getParticle(b + j);
+		    Map.getTrajectory(Particle, iterates, Trajs[j]);
+		}
+	    });
+	    for (size_t j = 0; j < Trajs.size(); ++j)
+		if (!iterates.empty() && Trajs[j].Label.back() == -1)
+		    Unresolved.push_back(b + j);
+	    Pipeline.Push(); // Each member of the trajectories goes to its corresponding file
+	    if (Progress.Due()) {
+		Pipeline.Flush();
+		Progress.particle = e;
+		Progress.Save(TrajWriters);
+	    }
+	}
+	Pipeline.Close();
+    });
+    if (!Unresolved.empty()) {
+	std::cerr << "\nWARNING: " << Unresolved.size() << " trajectories reached a state in no region and were "
+		  << "cut short (label -1). Initial conditions:";
+	for (const auto& j : Unresolved) 
+	    std::cerr << " " << j;
+	std::cerr << "\n";
+    }
+    ShadowReport Shadow;
+    if constexpr (!std::is_same_v<T, float_>) {
+	std::vector<float_> h, theta;
+	const size_t nShadow = (config::shardIndex == 0) ? std::min(config::shadowParticles, nParticles) : 0; // Once per run
+	for (size_t j = 0; j < nShadow; ++j) {
+	    const SParticle<T> Particle = getParticle(j);
+	    h.push_back(Particle.H);
+	    theta.push_back(Particle.Theta);
+	}
+	if (!h.empty() && !iterates.empty())
+	    Shadow = ShadowRun<T>(h, theta, iterates.back());
+    }
+    Progress.shadow.Add(Shadow);
+    Progress.call++;
+    Progress.particle = 0;
+    Unresolved.clear();
+    return Shadow;
+}
+
+/**@brief Opens the trajectory files of a run and its progress
+ *
+ * Runs are numbered in the order the process opens them. When `config::resume` is set, the runs
+ * numbered before that of the study's checkpoint completed before the interruption and are 
+ * skipped. The run of the checkpoint, which must have been saved by the same driver, truncates its
+ * files back to it, restores its seed and clears `config::resume`, so later runs start afresh. 
+ * Otherwise the files are created afresh. Checkpoints are saved to the study's data directory, 
+ * one per shard.
+ * @param run Description of the driver and its arguments
+ * @return Writers for each member of `STrajectory`, and the progress of the run. Nothing when the
+ * run is skipped
+*/
+template <typename T>
+std::optional<std::pair<std::array<Writer,6>, Checkpoint>> openTrajectoryRun(const std::string& run) {
+    std::ostringstream key; // Everything the trajectories depend on besides the seed
+    key << std::setprecision(std::numeric_limits<float_>::max_digits10) << run << "; type " << typeid(T).name() 
+	<< "; study " << config::Study << "; format " << config::outputFormat << "; classifier " << (int)config::classifier 
+	<< "; shadow " << config::shadowParticles << "; shard " << config::shardIndex << "/" << config::shardCount
+	<< "; fast-forward " << config::fastForward;
+    const std::string fname = config::getShardName(config::DataPath + config::FILE_CHECKPOINT);
+    const size_t index = config::trajectoryRun++;
+    if (!config::resume) {
+	Checkpoint Progress;
+	Progress.run = key.str();
+	Progress.seed = config::seed;
+	Progress.index = index;
+	Progress.path = fname;
+	return std::make_pair(getTrajectoryWriters(), std::move(Progress));
+    }
+    Checkpoint Progress = Checkpoint::Read(fname);
+    config::seed = Progress.seed;
+    config::writeJSONConfig();
+    if (index < Progress.index) {
+	std::cout << "Skipping trajectory run " << index << ", completed before the checkpoint.\n";
+	return std::nullopt;
+    }
+    if (index > Progress.index || Progress.run != key.str())
+	throw std::invalid_argument("ERROR: Checkpoint " + fname + " is of a different run: " + Progress.run + ".");
+    config::resume = false;
+    std::cout << "Resuming from call " << Progress.call << ", initial condition " << Progress.particle 
+	      << " (seed " << Progress.seed << ").\n";
+    return std::make_pair(getTrajectoryWriters(Progress.writers), std::move(Progress));
+}
+
+/**@brief Share of this process of the initial conditions of one call of a sharded run
+ *
+ * The initial conditions of all calls of a run, in order, are split into `config::shardCount`
+ * contiguous ranges, so the files of the shards, concatenated in order, are those of a single
+ * process.
+ * @param offset Initial conditions of the run before this call
+ * @param nParticles Initial conditions of this call
+ * @param total Initial conditions of the run
+ * @return Initial conditions [first, last) of the call written by this process
+*/
+std::pair<size_t, size_t> getShardSlice(const size_t& offset, const size_t& nParticles, const size_t& total) {
+    const size_t first = total*config::shardIndex/config::shardCount;
+    const size_t last = total*(config::shardIndex + 1)/config::shardCount;
+    return { std::clamp(first, offset, offset + nParticles) - offset, std::clamp(last, offset, offset + nParticles) - offset };
+}
+
+/**@brief Removes the checkpoint of a completed run
+*/
+void closeTrajectoryRun(const Checkpoint& Progress) {
+    if (!Progress.path.empty())
+	std::filesystem::remove(Progress.path);
+}
+
+/**@brief Evolves a sequence of initial conditions over a thread pool, reducing them into an
+ * accumulator instead of writing their trajectories
+ *
+ * Particles are split into `REDUCE_PASSES` contiguous blocks. Each block is reduced in order 
+ * into its own copy of `Empty`, and the blocks are merged in order, so the result does not 
+ * depend on the number of threads.
+ * @param Pool Thread pool
+ * @param nParticles Number of initial conditions
+ * @param getParticle Callable returning the `j`th initial condition as an `SParticle`
+ * @param Empty Accumulator of no particles, with a member `Merge(const A&)`
+ * @param addParticle Callable void(A&, Map&, const SParticle<T>&) evolving a particle into an accumulator
+*/
+template <typename T, typename A, typename F, typename V>
+A ReduceParticles(ThreadPool& Pool, const size_t& nParticles, F&& getParticle, const A& Empty, V&& addParticle) {
+    std::vector<A> blocks(REDUCE_PASSES, Empty);
+    withGeometry([&](auto G) { // Map specialised for the selected width
+	ScatteringMap<T, decltype(G)> Map;
+	Pool.ParallelFor(REDUCE_PASSES, 1, [&](size_t first, size_t last, size_t) {
+	    for (size_t s = first; s < last; ++s) 
+		for (size_t j = nParticles*s/REDUCE_PASSES; j < nParticles*(s+1)/REDUCE_PASSES; ++j) 
+		    addParticle(blocks[s], Map, getParticle(j));
+	});
+    });
+    A Total = Empty;
+    for (const auto& block : blocks)
+	Total.Merge(block);
+    return Total;
+}
+
+/**@brief Prints a shadow report and writes it to the study's data directory
+*/
+void WriteShadowReport(const ShadowReport& Shadow) {
+    if (Shadow.empty()) {
+	if (config::shadowParticles > 0)
+	    std::cout << "No shadow runs: trajectories were computed in the reference precision.\n";
+	return;
+    }
+    Shadow.Print();
+    Shadow.WriteJSON(config::DataPath + config::FILE_SHADOW);
+}
 
 /**@brief Rejection samples points in a given region \beta_j, writing them to a file
  * 
@@ -27,23 +234,49 @@ void WriteRegionPoints(const int& nPoints, std::vector<int> myLabels, std::vecto
 	    throw std::invalid_argument("ERROR: Invalid `myLabels` argument in @WriteRegionPoints().");
 	}
     }
-    if (myWeights.size() == 0) { myWeights = config::regionAreas; } 
+    if (myWeights.size() == 0) { myWeights.assign(config::regionAreas.begin(), config::regionAreas.end()); } 
 
     nlohmann::json jsonFiles = config::getJSONFiles();
-    Writer region_heights(jsonFiles["Regions-H"]);
-    Writer region_angles(jsonFiles["Regions-Theta"]);
+    const std::string heightsFile = config::getShardName(jsonFiles["Regions-H"]);
+    const std::string anglesFile = config::getShardName(jsonFiles["Regions-Theta"]);
+    Writer region_heights(heightsFile);
+    Writer region_angles(anglesFile);
 
     std::cout << "Writing " << nPoints << " points in region(s) " << std::flush; 
-    for (size_t i = 0; i < myLabels.size(); ++i) {
+    for (size_t i = 0; i < myLabels.size(); ++i) 
 	(i == myLabels.size()-1) ? std::cout << std::to_string(myLabels[i]) : std::cout 
 					     << std::to_string(myLabels[i]) << ", " << std::flush;
+
+    // All regions are filled jointly in a fixed number of passes, each with its own stream and 
+    // share of every region, so the output does not depend on the number of threads. A shard
+    // fills a contiguous range of the passes, so its rows are pieces of the rows of a single run
+    std::vector<size_t> counts(myLabels.size());
+    for (size_t i = 0; i < myLabels.size(); ++i)
+	counts[i] = std::round(nPoints * myWeights[myLabels[i]]);
+    const size_t firstPass = REGION_PASSES*config::shardIndex/config::shardCount;
+    const size_t lastPass = REGION_PASSES*(config::shardIndex + 1)/config::shardCount;
+    std::vector<std::vector<std::tuple<std::vector<T>, std::vector<T>>>> passes(lastPass - firstPass);
+    ThreadPool Pool;
+    Pool.ParallelFor(passes.size(), 1, [&](size_t first, size_t last, size_t) {
+	for (size_t s = firstPass + first; s < firstPass + last; ++s) {
+	    std::vector<size_t> share(counts.size());
+	    for (size_t i = 0; i < counts.size(); ++i)
+		share[i] = counts[i]*(s+1)/REGION_PASSES - counts[i]*s/REGION_PASSES;
+	    Random<T> rng(config::seed, getStreamID(STREAM_REGION_PASS, s));
+	    passes[s - firstPass] = getPointsInRegions<T>(myLabels, share, rng);
+	}
+    });
+    for (size_t i = 0; i < myLabels.size(); ++i) {
 	std::vector<T> heights_in_region, angles_in_region;
-	size_t weightedPoints = std::round(nPoints * myWeights[myLabels[i]]);
-	std::tie(heights_in_region, angles_in_region) = getPointsInRegion<T>(myLabels[i],weightedPoints);
+	for (const auto& pass : passes) {
+	    const auto& [h, theta] = pass[i];
+	    heights_in_region.insert(heights_in_region.end(), h.begin(), h.end());
+	    angles_in_region.insert(angles_in_region.end(), theta.begin(), theta.end());
+	}
 	region_heights.WriteRowVector<T>(heights_in_region);
 	region_angles.WriteRowVector<T>(angles_in_region);
     }
-    std::cout << ".\nFiles written: " << jsonFiles["Regions-H"] << ", " << jsonFiles["Regions-Theta"] << "\n";
+    std::cout << ".\nFiles written: " << heightsFile << ", " << anglesFile << "\n";
 }
 
 /**
@@ -64,29 +297,43 @@ void WriteTrajectoryData(const size_t& nPoints, const size_t& nIterates, std::ve
 	    throw std::invalid_argument("Invalid myLabels argument in @WriteTrajectoryData()");
 	}
     }
-    if (myWeights.size() == 0) { myWeights = config::regionAreas; } 
+    if (myWeights.size() == 0) { myWeights.assign(config::regionAreas.begin(), config::regionAreas.end()); } 
     // Iterates start from 0
     std::vector<size_t> iterates(nIterates);
     std::iota(std::begin(iterates), std::end(iterates), 0);
 
-    auto TrajWriters = getTrajectoryWriters(); // Opens files for all trajectory data
-    size_t totalPoints = 0;
+    std::ostringstream run;
+    run << "regions " << nPoints << " " << nIterates << " labels";
+    for (const auto& label : myLabels)
+	run << " " << label << ":" << myWeights[label];
+    // Opens files for all trajectory data, or reopens them at the checkpoint when resuming
+    auto Run = openTrajectoryRun<T>(run.str());
+    if (!Run) return; // Completed before the checkpoint
+    auto& [TrajWriters, Progress] = *Run;
+    ThreadPool Pool;
+    std::vector<size_t> weightedPoints(myLabels.size());
+    for (size_t i = 0; i < myLabels.size(); ++i)
+	weightedPoints[i] = std::round(nPoints * myWeights[myLabels[i]]);
+    const size_t totalPoints = std::accumulate(weightedPoints.begin(), weightedPoints.end(), (size_t)0);
+    size_t offset = 0; // Initial conditions of the preceding regions
     std::cout << "Writing " << nIterates << " iterate trajectories from regions ";
-    for (size_t i = 0; i < myLabels.size(); ++i) {
+    for (size_t i = 0; i < myLabels.size(); offset += weightedPoints[i++]) {
 	(i == myLabels.size()-1) ? std::cout << std::to_string(myLabels[i]) : std::cout 
 					     << std::to_string(myLabels[i]) << ", " << std::flush;
-	std::vector<T> heights_in_region, angles_in_region;
-	size_t weightedPoints = std::round(nPoints * myWeights[myLabels[i]]);
-	totalPoints += weightedPoints;
-	std::tie(heights_in_region, angles_in_region) = getPointsInRegion<T>(myLabels[i],weightedPoints);
-	for (size_t j = 0; j < heights_in_region.size(); ++j) {
-	    ScatteringMap<T> Map(config::d);
-	    SParticle<T> Particle(heights_in_region[j],angles_in_region[j],0.,0);
-	    STrajectory<T> Traj = Map.getTrajectory(Particle, iterates);     
-	    Traj.Write(TrajWriters); // Writes each member of STrajectory to corresponding file
-	}
+	if (i < Progress.call) continue; // Written before the checkpoint
+	// Initial condition j of the region is reproducible from (config::seed, label, j)
+	WriteTrajectories<T>(Pool, weightedPoints[i], [&](const size_t& j) {
+	    auto [h, theta] = getSeededPointsInRegion<T>(myLabels[i], j, 1);
+	    return SParticle<T>(h[0], theta[0], 0., 0);
+	}, iterates, TrajWriters, Progress, getShardSlice(offset, weightedPoints[i], totalPoints));
     }
-    std::cout << ". Done!\n" << totalPoints << " total trajectories written.\n";
+    const auto [first, last] = getShardSlice(0, totalPoints, totalPoints);
+    std::cout << ". Done!\n" << last - first << " total trajectories written";
+    if (config::shardCount > 1) 
+	std::cout << " (shard " << config::shardIndex << " of " << config::shardCount << ", " << totalPoints << " in all)";
+    std::cout << ".\n";
+    WriteShadowReport(Progress.shadow);
+    closeTrajectoryRun(Progress);
 }
 
 /**
@@ -105,20 +352,363 @@ void WriteTrajectoryData(const size_t& nPoints, const size_t& nIterates,
     std::vector<size_t> iterates(nIterates);
     std::iota(std::begin(iterates), std::end(iterates), 0);
 
-    auto TrajWriters = getTrajectoryWriters(); // Opens files for all trajectory data
+    std::ostringstream run;
+    run << "rectangle " << nPoints << " " << nIterates << " [" << h_interval.first << ", " << h_interval.second 
+	<< "] x [" << theta_interval.first << ", " << theta_interval.second << "]";
+    // Opens files for all trajectory data, or reopens them at the checkpoint when resuming
+    auto Run = openTrajectoryRun<T>(run.str());
+    if (!Run) return; // Completed before the checkpoint
+    auto& [TrajWriters, Progress] = *Run;
+    ThreadPool Pool;
 
     std::cout << "Writing " << std::to_string(nPoints) << " trajectories (" << nIterates 
 	      << " iterates) from the region " << "[" << h_interval.first << ", " 
 	      << h_interval.second << "] x [" << theta_interval.first << ", " << theta_interval.second << "]";
-    // Generate initial condition in rectangle, produce trajectory and write
-    for (size_t i = 0; i < nPoints; ++i) {
-	ScatteringMap<T> Map(config::d);
-	SParticle<T> P = SParticle(h_interval, theta_interval);
-	STrajectory<T> Traj = Map.getTrajectory(P, iterates);     
-	Traj.Write(TrajWriters); // Writes each member of STrajectory to corresponding file
+    // Generate initial conditions in rectangle, produce trajectories and write.
+    // Initial condition j is reproducible from (config::seed, j)
+    if (Progress.call == 0) {
+	WriteTrajectories<T>(Pool, nPoints, [&](const size_t& j) {
+	    Random<T> rng(config::seed, getStreamID(STREAM_RECTANGLE, j));
+	    return SParticle<T>(h_interval, theta_interval, rng);
+	}, iterates, TrajWriters, Progress, getShardSlice(0, nPoints, nPoints));
+    }
+    std::cout << ". Done!\n";
+    WriteShadowReport(Progress.shadow);
+    closeTrajectoryRun(Progress);
+}
+
+/**@brief Initial conditions of `WriteTrajectoryData` in selected regions, as one sequence
+ * @param nPoints Number of points per region to generate
+ * @param myLabels User specified labels indicating which regions should be generated
+ * @param myWeights User specified weightings. Multiplies `nPoints` per region
+ * @return Number of initial conditions, and a callable returning the `j`th as an `SParticle`
+*/
+template <typename T>
+auto getRegionSequence(const size_t& nPoints, std::vector<int> myLabels, std::vector<T> myWeights) {
+    if (myLabels.size() == 0) {
+	myLabels = config::regionLabels;
+    } else { // Labels must be a subset of config::all_labels[widthSelection]
+	if (!std::ranges::includes(config::regionLabels, myLabels)) {
+	    throw std::invalid_argument("Invalid myLabels argument in @getRegionSequence()");
+	}
+    }
+    if (myWeights.size() == 0) { myWeights.assign(config::regionAreas.begin(), config::regionAreas.end()); }
+    std::vector<size_t> offsets = { 0 }; // Particles of region i are [offsets[i], offsets[i+1])
+    for (const auto& label : myLabels)
+	offsets.push_back(offsets.back() + (size_t)std::round(nPoints * myWeights[label]));
+    const size_t nParticles = offsets.back();
+    return std::make_pair(nParticles, [offsets = std::move(offsets), myLabels = std::move(myLabels)](const size_t& j) {
+	const size_t i = std::ranges::upper_bound(offsets, j) - offsets.begin() - 1;
+	auto [h, theta] = getSeededPointsInRegion<T>(myLabels[i], j - offsets[i], 1);
+	return SParticle<T>(h[0], theta[0], 0., 0);
+    });
+}
+
+/**
+ * @brief Writes transport statistics (Transport.h) of particles starting in selected regions,
+ * without writing their trajectories
+ *
+ * Initial conditions are those of `WriteTrajectoryData` for the same seed.
+ * @param nPoints Number of points per region to generate
+ * @param grid Iterates (`std::vector<size_t>`) or times (`std::vector<float_>`) at which the
+ * displacement moments are taken
+ * @param myLabels User specified labels indicating which regions should be generated
+ * @param myWeights User specified weightings. Multiplies `nPoints` per region
+*/
+template <typename T, typename G> 
+TransportStatistics WriteTransportData(const size_t& nPoints, const std::vector<G>& grid, 
+				       std::vector<int> myLabels, std::vector<T> myWeights) {
+    const auto [nParticles, getParticle] = getRegionSequence<T>(nPoints, myLabels, myWeights);
+    std::cout << "Accumulating transport statistics of " << nParticles << " particles" << std::flush;
+    ThreadPool Pool;
+    TransportStatistics Stats = ReduceParticles<T>(Pool, nParticles, getParticle, TransportStatistics(grid), 
+						   [](TransportStatistics& S, auto& Map, const SParticle<T>& SP) {
+	S.AddParticle(Map, SP);
+    });
+    std::cout << ". Done!\n";
+    Stats.Print();
+    Stats.WriteJSON(config::DataPath + config::FILE_TRANSPORT);
+    return Stats;
+}
+
+/**
+ * @brief Writes transport statistics for initial conditions in a rectangle [a,b]x[c,d] 
+ *
+ * Overloaded function
+*/
+template <typename T, typename G> 
+TransportStatistics WriteTransportData(const size_t& nPoints, const std::vector<G>& grid, 
+				       const std::pair<T,T>& h_interval, const std::pair<T,T>& theta_interval) {
+    if (h_interval.first < (T)0 || h_interval.second > config::d) {
+	throw std::invalid_argument("Invalid height interval in @WriteTransportData()");
+    }
+    std::cout << "Accumulating transport statistics of " << nPoints << " particles" << std::flush;
+    ThreadPool Pool;
+    TransportStatistics Stats = ReduceParticles<T>(Pool, nPoints, [&](const size_t& j) {
+	Random<T> rng(config::seed, getStreamID(STREAM_RECTANGLE, j));
+	return SParticle<T>(h_interval, theta_interval, rng);
+    }, TransportStatistics(grid), [](TransportStatistics& S, auto& Map, const SParticle<T>& SP) {
+	S.AddParticle(Map, SP);
+    });
+    std::cout << ". Done!\n";
+    Stats.Print();
+    Stats.WriteJSON(config::DataPath + config::FILE_TRANSPORT);
+    return Stats;
+}
+
+/**@brief Prints a summary of transition counts and writes them to the study's data directory
+ * 
+ * Counts are written as JSON, and also as a NumPy array when `config::outputFormat` is binary.
+*/
+void WriteTransitionCounts(const TransitionCounts& Counts) {
+    const std::string fname = config::DataPath + config::FILE_TRANSITIONS;
+    Counts.WriteJSON(fname);
+    if (config::outputFormat != "text")
+	Counts.WriteNPY(std::filesystem::path(fname).replace_extension(".npy").string());
+    std::uint64_t total = 0;
+    for (size_t i = 0; i < N_LABELS; ++i)
+	for (size_t j = 0; j < N_LABELS; ++j)
+	    total += Counts.Count(0, i, j);
+    std::cout << total << " transitions at lag " << Counts.lags[0] << " counted.\n";
+}
+
+/**
+ * @brief Writes region-to-region transition counts (Transitions.h) of particles starting in 
+ * selected regions, without writing their trajectories
+ *
+ * Initial conditions are those of `WriteTrajectoryData` for the same seed.
+ * @param nPoints Number of points per region to generate
+ * @param nSteps Number of iterations of the map
+ * @param lags Lags k of the transitions label(n) -> label(n+k) counted
+ * @param jumps Also count the position jump of each transition
+ * @param myLabels User specified labels indicating which regions should be generated
+ * @param myWeights User specified weightings. Multiplies `nPoints` per region
+*/
+template <typename T> 
+TransitionCounts WriteTransitionData(const size_t& nPoints, const size_t& nSteps, const std::vector<size_t>& lags,
+				     const bool& jumps, std::vector<int> myLabels, std::vector<T> myWeights) {
+    const auto [nParticles, getParticle] = getRegionSequence<T>(nPoints, myLabels, myWeights);
+    std::cout << "Counting transitions of " << nParticles << " particles over " << nSteps << " iterates" << std::flush;
+    ThreadPool Pool;
+    TransitionCounts Counts = ReduceParticles<T>(Pool, nParticles, getParticle, TransitionCounts(lags, jumps), 
+						 [&](TransitionCounts& C, auto& Map, const SParticle<T>& SP) {
+	C.AddParticle(Map, SP, nSteps);
+    });
+    std::cout << ". Done!\n";
+    WriteTransitionCounts(Counts);
+    return Counts;
+}
+
+/**
+ * @brief Writes transition counts for initial conditions in a rectangle [a,b]x[c,d] 
+ *
+ * Overloaded function
+*/
+template <typename T> 
+TransitionCounts WriteTransitionData(const size_t& nPoints, const size_t& nSteps, const std::vector<size_t>& lags,
+				     const bool& jumps, const std::pair<T,T>& h_interval, const std::pair<T,T>& theta_interval) {
+    if (h_interval.first < (T)0 || h_interval.second > config::d) {
+	throw std::invalid_argument("Invalid height interval in @WriteTransitionData()");
+    }
+    std::cout << "Counting transitions of " << nPoints << " particles over " << nSteps << " iterates" << std::flush;
+    ThreadPool Pool;
+    TransitionCounts Counts = ReduceParticles<T>(Pool, nPoints, [&](const size_t& j) {
+	Random<T> rng(config::seed, getStreamID(STREAM_RECTANGLE, j));
+	return SParticle<T>(h_interval, theta_interval, rng);
+    }, TransitionCounts(lags, jumps), [&](TransitionCounts& C, auto& Map, const SParticle<T>& SP) {
+	C.AddParticle(Map, SP, nSteps);
+    });
+    std::cout << ". Done!\n";
+    WriteTransitionCounts(Counts);
+    return Counts;
+}
+
+/**@brief Prints a summary of word statistics and writes them to the study's data directory
+ * 
+ * Statistics are written as JSON, and the counts also as a NumPy array when `config::outputFormat`
+ * is binary.
+*/
+void WriteWordStatistics(const WordStatistics& Words) {
+    const std::string fname = config::DataPath + config::FILE_WORDS;
+    Words.WriteJSON(fname);
+    if (config::outputFormat != "text")
+	Words.WriteNPY(std::filesystem::path(fname).replace_extension(".npy").string());
+    Words.Print();
+}
+
+/**
+ * @brief Writes the statistics of the words of region labels (Words.h) of particles starting in 
+ * selected regions, without writing their trajectories or itineraries
+ *
+ * Initial conditions are those of `WriteTrajectoryData` for the same seed.
+ * @param nPoints Number of points per region to generate
+ * @param nSteps Number of iterations of the map
+ * @param maxLength Longest word counted
+ * @param myLabels User specified labels indicating which regions should be generated
+ * @param myWeights User specified weightings. Multiplies `nPoints` per region
+*/
+template <typename T> 
+WordStatistics WriteWordData(const size_t& nPoints, const size_t& nSteps, const size_t& maxLength,
+			     std::vector<int> myLabels, std::vector<T> myWeights) {
+    const auto [nParticles, getParticle] = getRegionSequence<T>(nPoints, myLabels, myWeights);
+    std::cout << "Counting words of " << nParticles << " particles over " << nSteps << " iterates" << std::flush;
+    ThreadPool Pool;
+    WordStatistics Words = ReduceParticles<T>(Pool, nParticles, getParticle, WordStatistics(maxLength), 
+					      [&](WordStatistics& W, auto& Map, const SParticle<T>& SP) {
+	W.AddParticle(Map, SP, nSteps);
+    });
+    std::cout << ". Done!\n";
+    WriteWordStatistics(Words);
+    return Words;
+}
+
+/**
+ * @brief Writes word statistics for initial conditions in a rectangle [a,b]x[c,d] 
+ *
+ * Overloaded function
+*/
+template <typename T> 
+WordStatistics WriteWordData(const size_t& nPoints, const size_t& nSteps, const size_t& maxLength,
+			     const std::pair<T,T>& h_interval, const std::pair<T,T>& theta_interval) {
+    if (h_interval.first < (T)0 || h_interval.second > config::d) {
+	throw std::invalid_argument("Invalid height interval in @WriteWordData()");
     }
+    std::cout << "Counting words of " << nPoints << " particles over " << nSteps << " iterates" << std::flush;
+    ThreadPool Pool;
+    WordStatistics Words = ReduceParticles<T>(Pool, nPoints, [&](const size_t& j) {
+	Random<T> rng(config::seed, getStreamID(STREAM_RECTANGLE, j));
+	return SParticle<T>(h_interval, theta_interval, rng);
+    }, WordStatistics(maxLength), [&](WordStatistics& W, auto& Map, const SParticle<T>& SP) {
+	W.AddParticle(Map, SP, nSteps);
+    });
     std::cout << ". Done!\n";
+    WriteWordStatistics(Words);
+    return Words;
 }
 
+/**@brief Evolves a sequence of initial conditions over a thread pool in continuous time, handing 
+ * on a snapshot of the whole ensemble at each time of a grid
+ *
+ * Snapshot k holds the state of each particle at `Time[k]`, as recorded by 
+ * `ScatteringMap::getTrajectory(SP, Time)`. Only the ensemble and one snapshot are held in 
+ * memory, and no trajectory is stored. Snapshots do not depend on the number of threads.
+ * @param Pool Thread pool
+ * @param nParticles Number of initial conditions
+ * @param getParticle Callable returning the `j`th initial condition as an `SParticle`
+ * @param Time Increasing times of the snapshots
+ * @param onSnapshot Callable void(const EnsembleSnapshot<T>&) called with each snapshot in turn
+ * @return Initial conditions of the particles that reached a state in no region
+*/
+template <typename T, typename F, typename S>
+std::vector<size_t> EvolveSnapshots(ThreadPool& Pool, const size_t& nParticles, F&& getParticle, 
+				    const std::vector<T>& Time, S&& onSnapshot) {
+    if (!std::ranges::is_sorted(Time))
+	throw std::invalid_argument("ERROR: Times of snapshots must be increasing in @EvolveSnapshots().");
+    ParticleEnsemble<T> Initial(nParticles);
+    Pool.ParallelFor(nParticles, PARTICLE_CHUNK, [&](size_t first, size_t last, size_t) {
+	for (size_t j = first; j < last; ++j)
+	    Initial.Set(j, getParticle(j));
+    });
+    TimedEnsemble<T> Ensemble(std::move(Initial));
+    EnsembleSnapshot<T> Snapshot(nParticles);
+    withGeometry([&](auto G) { // Map specialised for the selected width
+	ScatteringMap<T, decltype(G)> Map;
+	for (size_t k = 0; k < Time.size(); ++k) {
+	    Pool.ParallelFor(nParticles, PARTICLE_CHUNK, [&](size_t first, size_t last, size_t) {
+		Map.AdvanceBatch(Ensemble, Time[k], first, last);
+		for (size_t i = first; i < last; ++i)
+		    Ensemble.Record(i, Time[k], Snapshot.State, Snapshot.Time);
+	    });
+	    Snapshot.index = k;
+	    Snapshot.t = Time[k];
+	    onSnapshot(std::as_const(Snapshot));
+	}
+    });
+    std::vector<size_t> Unresolved;
+    for (size_t i = 0; i < nParticles; ++i)
+	if (Ensemble.Current.Label[i] == -1)
+	    Unresolved.push_back(i);
+    return Unresolved;
+}
+
+/**@brief Writes snapshots of an ensemble, one row per time, to the study's data directory
+ *
+ * Files are `Snapshots-<field>.dat`, or .npy unless `config::outputFormat` is text. 
+ * `SnapshotOutput::States` writes the fields H, Theta, Labels, Positions and Time (at which each
+ * state was reached), `Positions` the positions only, and `Histogram` the counts of 
+ * `getPositionHistogram` as the field Histogram.
+ * @param maxDisplacement Largest |x| of the histograms
+*/
+template <typename T, typename F>
+void WriteSnapshots(const size_t& nParticles, F&& getParticle, const std::vector<T>& Time, 
+		    const SnapshotOutput& output, const int_ll& maxDisplacement) {
+    const std::string ext = (config::outputFormat == "text") ? ".dat" : ".npy";
+    auto open = [&](const std::string& field) { return Writer(config::DataPath + config::FILE_SNAPSHOTS + field + ext); };
+    std::vector<Writer> writers;
+    if (output == SnapshotOutput::States)
+	for (const std::string field : { "H", "Theta", "Labels", "Positions", "Time" })
+	    writers.push_back(open(field));
+    else
+	writers.push_back(open(output == SnapshotOutput::Positions ? "Positions" : "Histogram"));
+    ThreadPool Pool;
+    const std::vector<size_t> Unresolved = EvolveSnapshots<T>(Pool, nParticles, getParticle, Time, 
+							      [&](const EnsembleSnapshot<T>& Snapshot) {
+	const ParticleEnsemble<T>& S = Snapshot.State;
+	if (output == SnapshotOutput::States) {
+	    writers[0].WriteRowVector<T>(S.H);
+	    writers[1].WriteRowVector<T>(S.Theta);
+	    writers[2].WriteRowVector<int>(S.Label);
+	    writers[3].WriteRowVector<int_ll>(S.Position);
+	    writers[4].WriteRowVector<T>(Snapshot.Time);
+	} else if (output == SnapshotOutput::Positions) {
+	    writers[0].WriteRowVector<int_ll>(S.Position);
+	} else {
+	    writers[0].WriteRowVector<std::uint64_t>(getPositionHistogram(Snapshot, maxDisplacement));
+	}
+    });
+    if (!Unresolved.empty()) 
+	std::cerr << "\nWARNING: " << Unresolved.size() << " particles reached a state in no region and are "
+		  << "left out of later snapshots (label -1).";
+}
+
+/**
+ * @brief Writes snapshots (Snapshot.h) of particles starting in selected regions at each time of
+ * a grid, without writing their trajectories
+ *
+ * Initial conditions are those of `WriteTrajectoryData` for the same seed.
+ * @param nPoints Number of points per region to generate
+ * @param Time Increasing times of the snapshots
+ * @param output States, positions or position histograms
+ * @param maxDisplacement Largest |x| of the histograms
+ * @param myLabels User specified labels indicating which regions should be generated
+ * @param myWeights User specified weightings. Multiplies `nPoints` per region
+*/
+template <typename T> 
+void WriteSnapshotData(const size_t& nPoints, const std::vector<T>& Time, const SnapshotOutput& output, 
+		       const int_ll& maxDisplacement, std::vector<int> myLabels, std::vector<T> myWeights) {
+    const auto [nParticles, getParticle] = getRegionSequence<T>(nPoints, myLabels, myWeights);
+    std::cout << "Writing " << Time.size() << " snapshots of " << nParticles << " particles" << std::flush;
+    WriteSnapshots<T>(nParticles, getParticle, Time, output, maxDisplacement);
+    std::cout << ". Done!\n";
+}
+
+/**
+ * @brief Writes snapshots for initial conditions in a rectangle [a,b]x[c,d] 
+ *
+ * Overloaded function
+*/
+template <typename T> 
+void WriteSnapshotData(const size_t& nPoints, const std::vector<T>& Time, const SnapshotOutput& output, 
+		       const int_ll& maxDisplacement, const std::pair<T,T>& h_interval, const std::pair<T,T>& theta_interval) {
+    if (h_interval.first < (T)0 || h_interval.second > config::d) {
+	throw std::invalid_argument("Invalid height interval in @WriteSnapshotData()");
+    }
+    std::cout << "Writing " << Time.size() << " snapshots of " << nPoints << " particles" << std::flush;
+    WriteSnapshots<T>(nPoints, [&](const size_t& j) {
+	Random<T> rng(config::seed, getStreamID(STREAM_RECTANGLE, j));
+	return SParticle<T>(h_interval, theta_interval, rng);
+    }, Time, output, maxDisplacement);
+    std::cout << ". Done!\n";
+}
 
 #endif
@@ -4,8 +4,91 @@
 //#include <boost/multiprecision/cpp_dec_float.hpp>
 //#include <boost/multiprecision/cpp_int.hpp>
 //#include <boost/math/constants/constants.hpp>
+#include <atomic>
+#include <array>
+#include <cstdint>
 #include <random>
 #include <boost/random.hpp>
+#include "config.h"
+
+/**@brief Philox4x32-10 counter-based generator (Salmon et al., SC '11)
+ *
+ * Each output block is a keyed bijection of a 128-bit counter, so a generator costs four
+ * words of state and is created in O(1). The key is the run seed and the upper half of the
+ * counter is a stream ID, which gives independent, reproducible streams (e.g. one per
+ * particle) without replaying any other stream. Satisfies UniformRandomBitGenerator.
+ */
+class Philox
+{
+    public:
+	using result_type = std::uint64_t;
+
+	Philox(const std::uint64_t& seed, const std::uint64_t& stream) {
+	    key = { (std::uint32_t)seed, (std::uint32_t)(seed >> 32) };
+	    ctr = { 0, 0, (std::uint32_t)stream, (std::uint32_t)(stream >> 32) };
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	result_type operator()() {
+	    if (idx == 0) {
+		out = Block(ctr, key);
+		if (++ctr[0] == 0) ++ctr[1];
+	    }
+	    result_type r = (result_type)out[2*idx] | ((result_type)out[2*idx+1] << 32);
+	    idx ^= 1;
+	    return r;
+	}
+
+	/// Number of 64-bit outputs drawn from this stream so far
+	std::uint64_t getPosition() const {
+	    return 2*(((std::uint64_t)ctr[1] << 32 | ctr[0]) - (idx != 0)) + idx;
+	}
+
+	/// Resumes the stream after `n` outputs
+	void setPosition(const std::uint64_t& n) {
+	    const std::uint64_t block = n/2;
+	    ctr[0] = (std::uint32_t)block;
+	    ctr[1] = (std::uint32_t)(block >> 32);
+	    idx = 0;
+	    if (n % 2) (*this)();
+	}
+
+	/// Philox4x32 with 10 rounds
+	static std::array<std::uint32_t,4> Block(std::array<std::uint32_t,4> c, std::array<std::uint32_t,2> k) {
+	    for (size_t r = 0; r < 10; ++r) {
+		if (r > 0) {
+		    k[0] += 0x9E3779B9;
+		    k[1] += 0xBB67AE85;
+		}
+		const std::uint64_t p0 = (std::uint64_t)0xD2511F53 * c[0];
+		const std::uint64_t p1 = (std::uint64_t)0xCD9E8D57 * c[2];
+		c = { (std::uint32_t)(p1 >> 32) ^ c[1] ^ k[0], (std::uint32_t)p1,
+		      (std::uint32_t)(p0 >> 32) ^ c[3] ^ k[1], (std::uint32_t)p0 };
+	    }
+	    return c;
+	}
+
+    private:
+	std::array<std::uint32_t,2> key;
+	std::array<std::uint32_t,4> ctr;
+	std::array<std::uint32_t,4> out;
+	unsigned idx = 0;
+};
+
+/// Stream IDs are [8 bits purpose | 8 bits region label | 48 bits index]
+constexpr std::uint64_t STREAM_ANONYMOUS = 0; // Generators constructed without a stream ID
+constexpr std::uint64_t STREAM_REGION = 1;    // Initial condition `index` in a region
+constexpr std::uint64_t STREAM_RECTANGLE = 2; // Initial condition `index` in a rectangle
+constexpr std::uint64_t STREAM_REGION_PASS = 3; // Pass `index` of a joint fill of several regions
+
+inline std::uint64_t getStreamID(const std::uint64_t& purpose, const std::uint64_t& index, const int& label = 0) {
+    return (purpose << 56) | ((std::uint64_t)(label & 0xFF) << 48) | (index & 0xFFFFFFFFFFFF);
+}
+
+/// Counter handing out anonymous streams in order of construction
+inline std::atomic<std::uint64_t> anonymousStreams = 0;
 
 template <typename T>
 class Random
@@ -13,11 +96,13 @@ class Random
     public:
 	//using ibits = boost::random::independent_bits_engine;
 	//using genny = ibits<boost::mt19937, std::numeric_limits<T>::digits, boost::multiprecision::cpp_int>;
-	using genny = boost::random::mt19937;
-	Random() {
-    	    std::random_device rd;
-    	    gen = genny(rd());
-    	}
+	using genny = Philox;
+	// Next anonymous stream of the run seed
+	Random() : gen(config::seed, getStreamID(STREAM_ANONYMOUS, anonymousStreams++)) { }
+
+	// Stream `stream` of `seed`. Identical arguments reproduce the same numbers
+	Random(const std::uint64_t& seed, const std::uint64_t& stream) : gen(seed, stream) { }
+
     	T getUniformRandom(const T &a, const T &b) {
     	    ur = boost::random::uniform_real_distribution<T>(a, b);
     	    return ur(gen);
@@ -26,6 +111,7 @@ class Random
     	    norm = boost::random::normal_distribution<T>(mean, var);
     	    return norm(gen);
     	}
+	genny& getGenerator() { return gen; }
     private:
         boost::random::uniform_real_distribution<T> ur;
         boost::random::normal_distribution<T> norm;
@@ -41,7 +127,8 @@ T runif(const T &a, const T &b) {
 template<typename T>
 T random_vector_elem(std::vector<T>& v) {
    std::vector<T> result;
-   std::sample(v.begin(), v.end(), std::back_inserter(result), 1,std::mt19937{std::random_device{}()});
+   Random<double> x;
+   std::sample(v.begin(), v.end(), std::back_inserter(result), 1, x.getGenerator());
    return result[0];
 }
 
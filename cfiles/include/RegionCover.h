@@ -0,0 +1,191 @@
+/**
+ * @brief Coverings of each region by rectangles in (h,theta), used for rejection sampling
+ *
+ * Every region is bounded in theta by singular directions of the form atan(a*h + b), which
+ * are monotone in h. Over a strip [h0,h1] a region therefore lies between the smallest value
+ * of its lower bounds and the largest value of its upper bounds, both attained at h0 or h1.
+ * Stacking one such rectangle per strip covers the region exactly, with no tabulation error.
+ */
+
+#ifndef REGIONCOVER_H_INCLUDED
+#define REGIONCOVER_H_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <mutex>
+#include <vector>
+#include "config.h"
+#include "CoordinateSpace.h"
+#include "Random.h"
+
+using BoundaryFn = float_ (*)(const float_&, const float_&);
+
+/// Bounds that are not one of X1...X18
+float_ XL0(const float_&, const float_&) { return X0; }
+float_ XL19(const float_&, const float_&) { return X19; }
+float_ XG(const float_&, const float_& h) { return atan((DELTA-h)/DELTA); } // \Gamma_0 / \Gamma_2
+float_ XA0(const float_&, const float_& h) { return -atan(h); }		// Lower bound of IN_A
+float_ XA1(const float_&, const float_& h) { return atan((float_)1 - 2*h); }	// Upper bound of IN_A
+float_ XB19(const float_& d, const float_& h) { return atan(d-h); }		// Upper bound of \beta_19
+
+/**@brief Bounds of a region as they appear in its indicator function in CoordinateSpace.h
+ * The region is contained in hMin < h < hMax, max(lower) < theta < min(upper)
+ */
+struct RegionBounds {
+    int label;
+    float_ hMin, hMax;
+    std::vector<BoundaryFn> lower, upper;
+};
+
+/**@brief Bounds of all regions for the current `config::widthSelection`
+*/
+std::vector<RegionBounds> getRegionBounds() {
+    const float_ d = config::d;
+    // Regions on \Gamma_0, \Gamma_2 and \Gamma_3 (common to both widths)
+    std::vector<RegionBounds> bounds = {
+	{ 0,  0, d, { XL0 }, { X1, XG } },
+	{ 12, 0, d, { X12, XG }, { X13, X16 } },
+	{ 13, 0, d, { X13, XG }, { X14, X16 } },
+	{ 14, 0, d, { X14, XG }, { X15, X16 } },
+	{ 15, 0, d, { X15, XG }, { X16 } },
+	{ 16, 0, d, { X16 }, { X17 } },
+	{ 17, 0, d, { X17, X16 }, { X18 } },
+	{ 18, 0, d, { X18, X16 }, { XL19 } } };
+
+    if (config::widthSelection == 0) {
+	std::vector<RegionBounds> g0 = {
+	    { 1,  1/(float_)6, d, { X1 }, { X2, XG } },
+	    { 2,  1/(float_)8, d, { X2, X1 }, { X3, X4, XG } },
+	    { 3,  0, 1/(float_)3, { X3, X1 }, { X4, XG } },
+	    { 4,  0, d, { X4 }, { X5, XG } },
+	    { 5,  0, d, { X5 }, { X6, XG } },
+	    { 6,  0, d, { X6 }, { X7, XG } },
+	    { 7,  0, d, { X7 }, { X8, XG } },
+	    { 8,  0, d, { X8 }, { X9, XG } },
+	    { 9,  0, d, { X9 }, { X10, X12, XG } },
+	    { 10, 0, 1/(float_)3, { X10, X9 }, { X11, X12, XG } },
+	    { 11, 0, 1/(float_)4, { X11 }, { X12, XG } } };
+	bounds.insert(bounds.end(), g0.begin(), g0.end());
+    } else {
+	std::vector<RegionBounds> g0 = {
+	    { 4,  0, d, { X1, XA0 }, { X5, XA1, XG } },
+	    { 5,  0, 2/(float_)3, { X5, XA0 }, { X6, XA1, XG } },
+	    { 6,  0, 3/(float_)5, { X6, XA0 }, { X8, XA1, XG } },
+	    { 8,  0, 1/(float_)2, { X8, XA0 }, { X9, XA1, XG } },
+	    { 9,  0, 1/(float_)2, { X9, XA0 }, { X7, XA1, XG } },
+	    { 10, 0, 2/(float_)5, { X7, XA0 }, { X11, XA1, XG } },
+	    { 11, 0, 1/(float_)3, { X11, XA0 }, { XG, XA1 } },
+	    { 19, 0, d, { XG }, { XB19 } } };
+	bounds.insert(bounds.end(), g0.begin(), g0.end());
+    }
+    return bounds;
+}
+
+constexpr size_t COVER_STRIPS = 512; // Equal h-strips of [0,d] per covering
+
+/**@brief Stack of rectangles [hA,hB] x [thetaLo,thetaHi], at most one per h-strip
+ */
+struct RegionCover {
+
+    RegionCover() = default;
+
+    /**@brief Covering of a single region
+    * @param b Bounds of the region
+    * @param pad Margin added to every rectangle. Absorbs rounding in the bounds
+    */
+    RegionCover(const RegionBounds& b, const float_& pad = 64*EPSILON) {
+	const float_ d = config::d;
+	for (size_t k = 0; k < COVER_STRIPS; ++k) {
+	    const float_ h0 = std::max(d*k/COVER_STRIPS, b.hMin);
+	    const float_ h1 = std::min(d*(k+1)/COVER_STRIPS, b.hMax);
+	    if (!(h0 < h1)) continue;
+	    float_ lo = -PI2, hi = PI2;
+	    for (auto f : b.lower) lo = std::max(lo, std::min(f(d,h0), f(d,h1)));
+	    for (auto f : b.upper) hi = std::min(hi, std::max(f(d,h0), f(d,h1)));
+	    Add(k, h0, h1, std::max(lo - pad, -PI2), std::min(hi + pad, PI2));
+	}
+    }
+
+    void Add(const size_t& k, const float_& h0, const float_& h1, const float_& lo, const float_& hi) {
+	if (!(lo < hi)) return;
+	strip.push_back(k);
+	hA.push_back(h0);
+	hB.push_back(h1);
+	thetaLo.push_back(lo);
+	thetaHi.push_back(hi);
+	cumulArea.push_back(Area() + (h1 - h0)*(hi - lo));
+    }
+
+    /// Area of the covering, >= area of the region(s) covered
+    float_ Area() const { return cumulArea.empty() ? 0 : cumulArea.back(); }
+
+    /**@brief Draws a point uniformly from the covering
+    * @param rng Generator to draw from
+    * @param h, theta Sampled point
+    */
+    template <typename T>
+    void Sample(Random<T>& rng, T& h, T& theta) const {
+	const T a = rng.getUniformRandom(0, Area());
+	size_t k = std::upper_bound(cumulArea.begin(), cumulArea.end(), a) - cumulArea.begin();
+	k = std::min(k, cumulArea.size() - 1);
+	h = rng.getUniformRandom(hA[k], hB[k]);
+	theta = rng.getUniformRandom(thetaLo[k], thetaHi[k]);
+    }
+
+    std::vector<size_t> strip;
+    std::vector<float_> hA, hB, thetaLo, thetaHi, cumulArea;
+};
+
+/**@brief Coverings of all regions for the current width, indexed by label. Built once per width
+*
+* Rectangles are padded by 64 epsilon of T, the precision the predicates are evaluated in.
+*/
+template <typename T = float_>
+const std::vector<RegionCover>& getRegionCovers() {
+    static std::array<std::vector<RegionCover>, config::channel_widths.size()> covers;
+    static std::array<std::once_flag, config::channel_widths.size()> built;
+    const size_t w = config::widthSelection;
+    std::call_once(built[w], [w] {
+	covers[w].resize(config::all_itineraries[w].size());
+	for (const auto& b : getRegionBounds())
+	    covers[w][b.label] = RegionCover(b, 64*std::numeric_limits<T>::epsilon());
+    });
+    return covers[w];
+}
+
+/**@brief Covering of the union of several regions, used to fill them from one stream of proposals
+ *
+ * Overlapping theta intervals of the regions in each strip are merged, so every point of the
+ * union is proposed with the same density.
+ * @param labels Regions to cover
+*/
+template <typename T = float_>
+RegionCover getCoverUnion(const std::vector<int>& labels) {
+    const auto& covers = getRegionCovers<T>();
+    std::vector<std::vector<std::pair<float_,float_>>> intervals(COVER_STRIPS);
+    for (const auto& label : labels) {
+	const RegionCover& C = covers[label];
+	for (size_t r = 0; r < C.strip.size(); ++r)
+	    intervals[C.strip[r]].emplace_back(C.thetaLo[r], C.thetaHi[r]);
+    }
+    RegionCover U;
+    for (size_t k = 0; k < COVER_STRIPS; ++k) {
+	auto& I = intervals[k];
+	if (I.empty()) continue;
+	std::sort(I.begin(), I.end());
+	const float_ h0 = config::d*k/COVER_STRIPS, h1 = config::d*(k+1)/COVER_STRIPS;
+	float_ lo = I[0].first, hi = I[0].second;
+	for (size_t j = 1; j < I.size(); ++j) {
+	    if (I[j].first > hi) {
+		U.Add(k, h0, h1, lo, hi);
+		lo = I[j].first;
+	    }
+	    hi = std::max(hi, I[j].second);
+	}
+	U.Add(k, h0, h1, lo, hi);
+    }
+    return U;
+}
+
+#endif
@@ -6,9 +6,16 @@
 #define SMAPHELPER_H_INCLUDED
 
 #include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 #include "config.h"
 #include "CoordinateSpace.h"
 #include "Random.h"
+#include "Geometry.h"
+#include "RegionCover.h"
+#include "LabelIndex.h"
+#include "Instrument.h"
 
 /**@brief Ensures incoming angle is in (-pi/2, pi/2)
 */
@@ -19,6 +26,68 @@ T getThetaRHS(const T& theta) {
     return theta;
 }
 
+/**@brief Gets the itinerary code of a state: its region label and, for the bouncing sub-regions 
+ * \beta_1^(n), \beta_12^(n) and \beta_18^(n) (d = 1/2), its number of bounces n
+ *
+ * The code is label + N_LABELS*n, or -1 for a state in no region. Itineraries are held and 
+ * written as codes. Strings are made from them on demand with `getItineraryFromCode`.
+ * @param h
+ * @param theta
+ * @param label Region label
+ * @return Itinerary code
+*/
+template <typename T, typename Geometry>
+std::int64_t getItineraryCode(const T& h, const T& theta, const int& label) {
+    if (label < 0)
+	return -1;
+    if constexpr (Geometry::widthSelection == 0) { 
+	constexpr T d = Geometry::d;
+	const T theta_ = getThetaRHS(theta);
+	if (label == 1)
+	    return label + (std::int64_t)N_LABELS*std::max<int_ll>(0, alpha(d,h,theta_));
+	if (label == 12)
+	    return label + (std::int64_t)N_LABELS*std::max<int_ll>(0, kappa(d,h,theta_));
+	if (label == 18)
+	    return label + (std::int64_t)N_LABELS*std::max<int_ll>(0, gamma(d,h,theta_));
+    }
+    return label;
+}
+
+/**@brief As above, for the geometry of the current `config::widthSelection`
+*/
+template <typename T>
+std::int64_t getItineraryCode(const T& h, const T& theta, const int& label) {
+    if (config::widthSelection == 0) 
+	return getItineraryCode<T, HalfWidth>(h, theta, label);
+    else if (config::widthSelection == 1) 
+	return getItineraryCode<T, UnitWidth>(h, theta, label);
+    else
+	throw std::runtime_error("ERROR: Invalid `widthSelection`.");
+}
+
+/**@brief Gets the itinerary of an itinerary code, e.g. "L04" + "04"*n + "R" for \beta_1^(n)
+ *
+ * @param code Itinerary code of `getItineraryCode`
+ * @param widthSelection Width the code was made for
+ * @return string Itinerary belonging to config::itineraries, "NULL" for no region
+*/
+inline std::string getItineraryFromCode(const std::int64_t& code, const size_t& widthSelection = config::widthSelection) {
+    if (code < 0)
+	return "NULL";
+    const int label = code % N_LABELS;
+    const std::int64_t bounces = code / N_LABELS;
+    const std::string& itinerary = config::all_itineraries[widthSelection][label];
+    if (widthSelection != 0 || (label != 1 && label != 12 && label != 18))
+	return itinerary;
+    const char* bounce = (label == 1) ? "04" : "31";
+    std::string bouncing_itinerary;
+    bouncing_itinerary.reserve(itinerary.size() + 2*bounces + 1);
+    bouncing_itinerary = itinerary;
+    for (std::int64_t i = 0; i < bounces; ++i)
+	bouncing_itinerary += bounce;
+    return bouncing_itinerary + "R";
+}
+
 /**@brief Gets the itinerary 
  *
  * Finite horizon itineraries require (h,theta) at at runtime due to bouncing trajectories
@@ -27,34 +96,16 @@ T getThetaRHS(const T& theta) {
  * @param label Region label
  * @return string Itinerary belonging to config::itineraries
 */
-template <typename T>
+template <typename T, typename Geometry>
 std::string getItineraryFromLabel(const T& h, const T& theta, const int& label) {
+    return getItineraryFromCode(getItineraryCode<T, Geometry>(h, theta, label), Geometry::widthSelection);
+}
 
-    if (config::widthSelection == 0) { 
-    	std::string bouncing_itinerary = config::itineraries[label];
-	T theta_ = getThetaRHS(theta);
-
-	/// Sub-regions \beta_1^(n), \beta_12^(n), \beta_18^(n)
-	if (label == 1) {
-    	    for (int_ll i = 0; i < alpha(config::d,h,theta_); ++i)
-    	        bouncing_itinerary += "04"; 
-    	    return bouncing_itinerary + "R";
-    	} else if (label == 12) {
-    	    for (int_ll i = 0; i < kappa(config::d,h,theta_); ++i)
-    	        bouncing_itinerary += "31";
-    	    return bouncing_itinerary + "R";
-    	} else if (label == 18) {
-    	    for (int_ll i = 0; i < gamma(config::d,h,theta_); ++i)
-    	        bouncing_itinerary += "31"; 
-    	    return bouncing_itinerary + "R";
-    	} else {
-	    return config::itineraries[label];
-	}
-    } else if (config::widthSelection == 1) {
-	return config::itineraries[label];
-    } else {
-	throw std::runtime_error("ERROR: Invalid `widthSelection`.");
-    }
+/**@brief As above, for the geometry of the current `config::widthSelection`
+*/
+template <typename T>
+std::string getItineraryFromLabel(const T& h, const T& theta, const int& label) {
+    return getItineraryFromCode(getItineraryCode<T>(h, theta, label));
 }
 
 /**@brief Determines the region label corresponding to the point (h,\theta)
@@ -62,86 +113,366 @@ std::string getItineraryFromLabel(const T& h, const T& theta, const int& label)
 * @param theta Entrance angle in (-pi/2, pi/2)
 * @return Integer label for the region. -1 signals error elsewhere
 */
-template <typename T>
+template <typename T, typename Geometry>
 int whichRegion(const T& h, const T& theta) {
     T theta_ = getThetaRHS(theta);
+    constexpr T d = Geometry::d;
 
     // Special case for the unique region \beta_19
-    if (config::widthSelection == 1) 
-	if (IN_BETA19(config::d,h,theta_)) 
+    if constexpr (Geometry::widthSelection == 1) 
+	if (IN_BETA19(d,h,theta_)) 
 	    return 19; 
 
-    if (IN_G0(config::d,h,theta_)) {
-	if (config::widthSelection == 0) {
-	    if (IN_BETA0(config::d,h,theta_)) { return 0; } 
-	    else if (IN_BETA1(config::d,h,theta_)) { return 1; }
-	    else if (IN_BETA2(config::d,h,theta_)) { return 2; }
-	    else if (IN_BETA3(config::d,h,theta_)) { return 3; }
-	    else if (IN_BETA4(config::d,h,theta_)) { return 4; }
-	    else if (IN_BETA5(config::d,h,theta_)) { return 5; }
-	    else if (IN_BETA6(config::d,h,theta_)) { return 6; }
-	    else if (IN_BETA7(config::d,h,theta_)) { return 7; }
-	    else if (IN_BETA8(config::d,h,theta_)) { return 8; }
-	    else if (IN_BETA9(config::d,h,theta_)) { return 9; }
-	    else if (IN_BETA10(config::d,h,theta_)) { return 10; }
-	    else if (IN_BETA11(config::d,h,theta_)) { return 11; }
+    if (IN_G0(d,h,theta_)) {
+	if constexpr (Geometry::widthSelection == 0) {
+	    if (IN_BETA0(d,h,theta_)) { return 0; } 
+	    else if (IN_BETA1(d,h,theta_)) { return 1; }
+	    else if (IN_BETA2(d,h,theta_)) { return 2; }
+	    else if (IN_BETA3(d,h,theta_)) { return 3; }
+	    else if (IN_BETA4(d,h,theta_)) { return 4; }
+	    else if (IN_BETA5(d,h,theta_)) { return 5; }
+	    else if (IN_BETA6(d,h,theta_)) { return 6; }
+	    else if (IN_BETA7(d,h,theta_)) { return 7; }
+	    else if (IN_BETA8(d,h,theta_)) { return 8; }
+	    else if (IN_BETA9(d,h,theta_)) { return 9; }
+	    else if (IN_BETA10(d,h,theta_)) { return 10; }
+	    else if (IN_BETA11(d,h,theta_)) { return 11; }
 	    else { return -1; }
 	} else {
-	    if (IN_BETA0(config::d,h,theta_)) { return 0; } 
-	    else if (IN_ZJ0(config::d,h,theta_)) { return 4; }
-	    else if (IN_ZJ1(config::d,h,theta_)) { return 5; }
-	    else if (IN_ZJ2(config::d,h,theta_)) { return 6; }
-	    else if (IN_ZJ3(config::d,h,theta_)) { return 8; }
-	    else if (IN_ZJ4(config::d,h,theta_)) { return 9; }
-	    else if (IN_ZJ5(config::d,h,theta_)) { return 10; }
-	    else if (IN_ZJ6(config::d,h,theta_)) { return 11; }
+	    if (IN_BETA0(d,h,theta_)) { return 0; } 
+	    else if (IN_ZJ0(d,h,theta_)) { return 4; }
+	    else if (IN_ZJ1(d,h,theta_)) { return 5; }
+	    else if (IN_ZJ2(d,h,theta_)) { return 6; }
+	    else if (IN_ZJ3(d,h,theta_)) { return 8; }
+	    else if (IN_ZJ4(d,h,theta_)) { return 9; }
+	    else if (IN_ZJ5(d,h,theta_)) { return 10; }
+	    else if (IN_ZJ6(d,h,theta_)) { return 11; }
 	    else { return -1; }
 	}
-    } else if (IN_G2(config::d,h,theta_)) {
-	if (IN_BETA12(config::d,h,theta_)) { return 12; }
-    	else if (IN_BETA13(config::d,h,theta_)) { return 13; }
-    	else if (IN_BETA14(config::d,h,theta_)) { return 14; }
-    	else if (IN_BETA15(config::d,h,theta_)) { return 15; }
+    } else if (IN_G2(d,h,theta_)) {
+	if (IN_BETA12(d,h,theta_)) { return 12; }
+    	else if (IN_BETA13(d,h,theta_)) { return 13; }
+    	else if (IN_BETA14(d,h,theta_)) { return 14; }
+    	else if (IN_BETA15(d,h,theta_)) { return 15; }
     	else { return -1; }
-    } else if (IN_G3(config::d,h,theta_)) {
-	if (IN_BETA16(config::d,h,theta_)) { return 16; }
-    	else if (IN_BETA17(config::d,h,theta_)) { return 17; }
-    	else if (IN_BETA18(config::d,h,theta_)) { return 18; }
+    } else if (IN_G3(d,h,theta_)) {
+	if (IN_BETA16(d,h,theta_)) { return 16; }
+    	else if (IN_BETA17(d,h,theta_)) { return 17; }
+    	else if (IN_BETA18(d,h,theta_)) { return 18; }
     	else { return -1; }
     } else { return -1; }
 }
 
+/**@brief As above, for the geometry of the current `config::widthSelection`
+*/
+template <typename T>
+int whichRegion(const T& h, const T& theta) {
+    if (config::widthSelection == 0) 
+	return whichRegion<T, HalfWidth>(h, theta);
+    return whichRegion<T, UnitWidth>(h, theta);
+}
+
+/// Relative width, in units of the machine epsilon of the precision used, of the band around a 
+/// singular direction in which tangent-space comparisons are not trusted and the exact 
+/// predicates are used instead
+constexpr float_ TANGENT_GUARD = 512;
+
+/**@brief True when tan(theta) = t is too close to u for t < u to decide theta < atan(u) as 
+* the indicator functions would in precision T
+*/
+template <typename T>
+bool nearTangent(const T& t, const T& u) {
+    return !(std::abs(t - u) > (T)TANGENT_GUARD*std::numeric_limits<T>::epsilon()*(1 + u*u + std::abs(t)));
+}
+
+/**@brief `whichRegion` with every comparison made in tangent space
+*
+* Each singular direction is X = atan(u) with u rational in h, and tan is monotone on 
+* (-pi/2, pi/2), so theta < X is decided by tan(theta) < u. The chain of `whichRegion` is 
+* followed with one `tan` in place of its `atan` calls, evaluating each u only when its 
+* comparison is reached. If any comparison made falls within `TANGENT_GUARD` of its boundary 
+* the point is reclassified with `whichRegion<Fallback>`, so labels are identical to it when
+* `Fallback` is T.
+* @param h Entrance height
+* @param theta Entrance angle
+* @param th getThetaRHS(theta)
+* @param t tan(th)
+* @return Integer label for the region. -1 signals error elsewhere
+*/
+template <typename T, typename Geometry, typename Fallback = T>
+int whichRegionTangent(const T& h, const T& theta, const T& th, const T& t) {
+    const T H = h;
+    constexpr T d = Geometry::d;
+    if (!(H > 0 && H < d && th > X0 && th < X19))
+	return -1;
+
+    bool ambiguous = false;
+    // theta < atan(u) and theta > atan(u)
+    auto below = [&](const T& u) { ambiguous |= nearTangent(t, u); return t < u; };
+    auto above = [&](const T& u) { ambiguous |= nearTangent(t, u); return t > u; };
+    // Arguments of the singular directions exactly as in CoordinateSpace.h
+    const T u1 = -(H/d), u5 = -((H)/(d+1)), u6 = -((H)/(2*d+1)), u7 = (d-H)/(2*d+1),
+		 u8 = ((T)DELTA-H)/(2*d+(T)DELTA), u9 = ((T)DELTA-H)/(d+(T)DELTA), u11 = (1-H)/(d+1), u12 = (d-H)/d;
+    const T ug = ((T)DELTA-H)/(T)DELTA, u16 = (d+(T)DELTA-H)/(T)DELTA;
+    // Label found, unless a comparison made on the way was too close to call
+    auto result = [&](const int& label) { return ambiguous ? whichRegion<Fallback, Geometry>(h, theta) : label; };
+
+    if constexpr (Geometry::widthSelection == 1)
+	if (above(ug) && below(d-H))				// \beta_19
+	    return result(19);
+
+    if (below(ug)) {						// \Gamma_0
+	if constexpr (Geometry::widthSelection == 0) {
+	    const T u2 = -((H+d)/(4*d)), u3 = -((H+d)/(5*d)), u4 = -((H+d-(T)DELTA)/(d+(T)DELTA)), 
+			 u10 = (1-H)/(2*d+1);
+	    auto Y1 = [&] { return above(u1) && below(u4); };
+	    auto Y7 = [&] { return above(u9) && below(u12); };
+	    if (below(u1)) return result(0);
+	    if (H > (1/(float_)6) && below(u2)) return result(1);
+	    if (H > 1/(float_)8 && above(u2) && below(u3) && Y1()) return result(2);
+	    if (H < (1/(float_)3) && above(u3) && below(u4) && Y1()) return result(3);
+	    if (above(u4) && below(u5)) return result(4);
+	    if (above(u5) && below(u6)) return result(5);
+	    if (above(u6) && below(u7)) return result(6);
+	    if (above(u7) && below(u8)) return result(7);
+	    if (above(u8) && below(u9)) return result(8);
+	    if (above(u9) && below(u10) && Y7()) return result(9);
+	    if (H < 1/(float_)3 && above(u10) && below(u11) && Y7()) return result(10);
+	    if (H < 1/(float_)4 && above(u11) && below(u12)) return result(11);
+	} else {
+	    auto A = [&] { return above(-H) && below((T)1 - 2*H); }; // IN_A
+	    if (below(u1)) return result(0);
+	    if (below(u5) && A()) return result(4);
+	    if (H < 2/(float_)3 && above(u5) && below(u6) && A()) return result(5);
+	    if (H < 3/(float_)5 && above(u6) && below(u8) && A()) return result(6);
+	    if (H < 1/(float_)2 && above(u8) && below(u9) && A()) return result(8);
+	    if (H < 1/(float_)2 && above(u9) && below(u7) && A()) return result(9);
+	    if (H < 2/(float_)5 && above(u7) && below(u11) && A()) return result(10);
+	    if (H < 1/(float_)3 && above(u11) && A()) return result(11);
+	}
+    } else if (below(u16)) {					// \Gamma_2
+	const T u13 = (d+(T)DELTA-H)/(d+(T)DELTA), u14 = (d+1-H)/(d+1), u15 = d+1-H;
+	if (above(u12) && below(u13)) return result(12);
+	if (above(u13) && below(u14)) return result(13);
+	if (above(u14) && below(u15)) return result(14);
+	if (above(u15)) return result(15);
+    } else {							// \Gamma_3
+	const T u17 = 2*d+1-H, u18 = ((T)DELTA+2*d-H)/(T)DELTA;
+	if (below(u17)) return result(16);
+	if (above(u17) && below(u18)) return result(17);
+	if (above(u18)) return result(18);
+    }
+    return result(-1);
+}
+
+/**@brief As above, computing tan(theta)
+*/
+template <typename T, typename Geometry>
+int whichRegionTangent(const T& h, const T& theta) {
+    const T th = getThetaRHS(theta);
+    return whichRegionTangent<T, Geometry>(h, theta, th, tan(th));
+}
+
+/**@brief As above, for the geometry of the current `config::widthSelection`
+*/
+template <typename T>
+int whichRegionTangent(const T& h, const T& theta) {
+    if (config::widthSelection == 0) 
+	return whichRegionTangent<T, HalfWidth>(h, theta);
+    return whichRegionTangent<T, UnitWidth>(h, theta);
+}
+
+/**@brief As above, from th = getThetaRHS(theta) and t = tan(th)
+*/
+template <typename T>
+int whichRegionTangent(const T& h, const T& theta, const T& th, const T& t) {
+    if (config::widthSelection == 0) 
+	return whichRegionTangent<T, HalfWidth>(h, theta, th, t);
+    return whichRegionTangent<T, UnitWidth>(h, theta, th, t);
+}
+
+/**@brief Region label of (h,theta) in precision T, with ambiguous points re-evaluated in `float_wide`
+*
+* The tangent-space comparisons of `whichRegionTangent` measure how close tan(theta) is to each 
+* singular direction passed. Points within `TANGENT_GUARD` of one, and points that T places in 
+* no region (e.g. exactly on a boundary), are classified again with `whichRegion<float_wide>`.
+* @param th getThetaRHS(theta)
+* @param t tan(th)
+* @return Integer label for the region. -1 only if `float_wide` places the point in no region either
+*/
+template <typename T, typename Geometry>
+int whichRegionAdaptive(const T& h, const T& theta, const T& th, const T& t) {
+    const int label = whichRegionTangent<T, Geometry, float_wide>(h, theta, th, t);
+    return (label != -1) ? label : whichRegion<float_wide, Geometry>(h, theta);
+}
+
+/**@brief As above, computing tan(theta)
+*/
+template <typename T, typename Geometry>
+int whichRegionAdaptive(const T& h, const T& theta) {
+    const T th = getThetaRHS(theta);
+    return whichRegionAdaptive<T, Geometry>(h, theta, th, tan(th));
+}
+
+/**@brief As above, for the geometry of the current `config::widthSelection`
+*/
+template <typename T>
+int whichRegionAdaptive(const T& h, const T& theta) {
+    if (config::widthSelection == 0) 
+	return whichRegionAdaptive<T, HalfWidth>(h, theta);
+    return whichRegionAdaptive<T, UnitWidth>(h, theta);
+}
+
+/**@brief As above, from th = getThetaRHS(theta) and t = tan(th)
+*/
+template <typename T>
+int whichRegionAdaptive(const T& h, const T& theta, const T& th, const T& t) {
+    if (config::widthSelection == 0) 
+	return whichRegionAdaptive<T, HalfWidth>(h, theta, th, t);
+    return whichRegionAdaptive<T, UnitWidth>(h, theta, th, t);
+}
+
+/**@brief `whichRegion`, after checking that the tangent-space classifier and the label index agree
+*/
+template <typename T>
+int whichRegionValidated(const T& h, const T& theta) {
+    const int label = whichRegion<T>(h, theta);
+    auto fail = [&](const std::string& name, const int& other) {
+	std::ostringstream oss;
+	oss << std::setprecision(17) << "ERROR: " << name << " gives label " << other << " instead of " 
+	    << label << " at (h,theta) = (" << h << "," << theta << ").";
+	throw std::runtime_error(oss.str());
+    };
+    if (const int other = whichRegionTangent<T>(h, theta); other != label) 
+	fail("Tangent-space classifier", other);
+    if (const int other = getLabelIndex().Classify<T>(h, theta); other != label) 
+	fail("Label index", other);
+    return label;
+}
+
+/**@brief Region label of (h,theta) by the classifier selected in `config::classifier`
+*/
+template <typename T>
+int classifyRegion(const T& h, const T& theta) {
+    switch (config::classifier) {
+	case RegionClassifier::Index: return getLabelIndex().Classify<T>(h, theta);
+	case RegionClassifier::Tangent: return whichRegionTangent<T>(h, theta);
+	case RegionClassifier::Validate: return whichRegionValidated<T>(h, theta);
+	case RegionClassifier::Adaptive: return whichRegionAdaptive<T>(h, theta);
+	default: return whichRegion<T>(h, theta);
+    }
+}
 
-/**@brief Samples a given region via uniform rejection 
+/**@brief Throws unless `label` is a region of the current width
+*/
+inline void checkRegionLabel(const int& label) {
+    if (!std::ranges::binary_search(config::regionLabels, label))
+	throw std::invalid_argument("ERROR: Invalid region label " + std::to_string(label) + ".");
+}
+
+/**@brief Samples a given region uniformly
+*
+* Proposals are drawn uniformly from the region's covering in `RegionCover.h` and rejected
+* unless the region's label agrees, so accepted points are exactly uniform in the region.
 * @param label Numeric label for the region
 * @param N  Number of points to get
+* @param rng Generator to draw from
 * @param return Two-tuple of vectors, heights and angles
-* TODO: Wheels spin if label is invalid
-* TODO: Optimise with bounding boxes?
 */
 template <typename T>
-std::tuple<std::vector<T>, std::vector<T>> getPointsInRegion(const int& label, const size_t& N) {
-    Random<T> h, theta;
+std::tuple<std::vector<T>, std::vector<T>> getPointsInRegion(const int& label, const size_t& N, Random<T>& rng) {
+    checkRegionLabel(label);
+    const RegionCover& cover = getRegionCovers<T>()[label];
     std::vector<T> heights(N,0);
     std::vector<T> thetas(N,0);
 
     // Rejection sample
     for (size_t i = 0; i < N; ++i) {
-	int region_label = -1;
 	T h_test = 0;
 	T theta_test = 0;
 	do {
-	    h_test = h.getUniformRandom(0, config::d);
-	    theta_test = theta.getUniformRandom(-PI/(T)2, PI/(T)2);
-	    region_label = whichRegion<T>(h_test, theta_test);
-	    if (region_label == -1) {
-		throw std::runtime_error("ERROR: Failed to find test point in `getPointsInRegion()`.");
-	    }
-	} while (region_label != label);
+	    SMAP_COUNT_PROPOSAL(label);
+	    cover.Sample<T>(rng, h_test, theta_test);
+	} while (classifyRegion<T>(h_test, theta_test) != label);
+	SMAP_COUNT_ACCEPTED(label);
 	heights[i] = h_test;
 	thetas[i] = theta_test;
     }
     return { heights, thetas };
 }
 
+/**@brief Samples several regions from one stream of proposals
+*
+* Proposals are drawn from the union of the coverings of the regions that still need points, 
+* and each accepted point goes to the region it lands in. The union shrinks as regions fill.
+* @param labels Numeric labels for the regions
+* @param counts Number of points to get in each region
+* @param rng Generator to draw from
+* @return Heights and angles per region, in the order of `labels`
+*/
+template <typename T>
+std::vector<std::tuple<std::vector<T>, std::vector<T>>> getPointsInRegions(const std::vector<int>& labels, 
+									   const std::vector<size_t>& counts, Random<T>& rng) {
+    if (labels.size() != counts.size())
+	throw std::invalid_argument("ERROR: Mismatched `labels` and `counts` sizes in @getPointsInRegions().");
+    std::vector<std::tuple<std::vector<T>, std::vector<T>>> points(labels.size());
+    std::vector<int> slot(config::all_itineraries[config::widthSelection].size(), -1); // Label -> index into `labels`
+    std::vector<int> active;
+    for (size_t i = 0; i < labels.size(); ++i) {
+	checkRegionLabel(labels[i]);
+	slot[labels[i]] = i;
+	std::get<0>(points[i]).reserve(counts[i]);
+	std::get<1>(points[i]).reserve(counts[i]);
+	if (counts[i] > 0) active.push_back(labels[i]);
+    }
+    while (!active.empty()) {
+	const RegionCover cover = getCoverUnion<T>(active);
+	bool filled = false;
+	while (!filled) {
+	    T h_test = 0;
+	    T theta_test = 0;
+	    cover.Sample<T>(rng, h_test, theta_test);
+	    const int label = classifyRegion<T>(h_test, theta_test);
+	    if (label == -1 || slot[label] == -1) continue;
+	    auto& [heights, thetas] = points[slot[label]];
+	    if (heights.size() == counts[slot[label]]) continue;
+	    heights.push_back(h_test);
+	    thetas.push_back(theta_test);
+	    filled = (heights.size() == counts[slot[label]]);
+	}
+	std::erase_if(active, [&](const int& l) { return std::get<0>(points[slot[l]]).size() == counts[slot[l]]; });
+    }
+    return points;
+}
+
+/**@brief As `getPointsInRegion` above, drawing from the next anonymous stream
+*/
+template <typename T>
+std::tuple<std::vector<T>, std::vector<T>> getPointsInRegion(const int& label, const size_t& N) {
+    Random<T> rng;
+    return getPointsInRegion<T>(label, N, rng);
+}
+
+/**@brief Reproducible samples of a region
+*
+* Point `first + i` is drawn from its own stream of `config::seed`, so the result does not
+* depend on the order (or thread) in which points are generated and any point can be 
+* regenerated on its own.
+* @param label Numeric label for the region
+* @param first Index of the first point
+* @param N Number of points to get
+*/
+template <typename T>
+std::tuple<std::vector<T>, std::vector<T>> getSeededPointsInRegion(const int& label, const size_t& first, const size_t& N) {
+    std::vector<T> heights(N,0);
+    std::vector<T> thetas(N,0);
+    for (size_t i = 0; i < N; ++i) {
+	Random<T> rng(config::seed, getStreamID(STREAM_REGION, first + i, label));
+	auto [h, theta] = getPointsInRegion<T>(label, 1, rng);
+	heights[i] = h[0];
+	thetas[i] = theta[0];
+    }
+    return { heights, thetas };
+}
+
 #endif
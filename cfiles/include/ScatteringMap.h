@@ -1,49 +1,343 @@
 #ifndef SCATTERINGMAP_H_INCLUDED
 #define SCATTERINGMAP_H_INCLUDED
 
+#include <type_traits>
 #include "config.h"
+#include "Geometry.h"
 #include "CoordinateSpace.h"
 #include "Random.h"
 #include "SMapHelper.h"
 #include "Particle.h"
+#include "Ensemble.h"
 #include "Trajectory.h"
+#include "Instrument.h"
+#include "Cycle.h"
+
+/**@brief Channel width of a `ScatteringMap`, a compile-time constant when `Geometry` is given
+ */
+template <typename T, typename Geometry>
+struct MapWidth {
+	static constexpr T d = Geometry::d;
+
+	MapWidth() = default;
+
+	MapWidth(const T& channelWidth) {
+	    if (channelWidth != d)
+		throw std::invalid_argument("ERROR: Channel width does not match the geometry of @ScatteringMap().");
+	}
+};
 
 template <typename T>
-struct ScatteringMap {
+struct MapWidth<T, void> {
 	T d;
 
-	ScatteringMap(const T& channelWidth) : d(channelWidth) { }
+	MapWidth(const T& channelWidth) : d(channelWidth) { }
+};
+
+/**@brief The scattering map \hat{S}
+ *
+ * `ScatteringMap<T>` reads the channel width and region labels at runtime. `ScatteringMap<T, 
+ * Geometry>` (e.g. `Geometry = HalfWidth`, see Geometry.h) fixes them at compile time, so width
+ * constants and width-dependent branches fold in the inner loop. Both give identical results.
+ */
+template <typename T, typename Geometry = void>
+struct ScatteringMap : MapWidth<T, Geometry> {
+	using MapWidth<T, Geometry>::d;
+	using MapWidth<T, Geometry>::MapWidth;
 
 	/**@brief Updates the state of a particle through an iteration of the scattering map	 
 	 * 
 	 * @param SP Scattering particle
 	*/
 	void Evolve(SParticle<T>& SP) {
-	    bool dirFlag = false; // Flag for particle direction
-	    SHatMap(SP, dirFlag);
+	    Step(SP.H, SP.Theta, SP.Tau, SP.Position, SP.Label);
+	}
+
+	/**@brief Updates the state of every particle in an ensemble through `nSteps` iterations
+	 *
+	 * Each particle's state is loaded once, iterated `nSteps` times and stored, so the
+	 * inner loop works on locals rather than on `SParticle` objects. A particle that reaches 
+	 * a state in no region, even in `float_wide`, stops there with label -1.
+	 * @param PE Ensemble of scattering particles
+	 * @param nSteps Number of iterations of the map
+	 * @return Indices of the particles stopped without a region
+	*/
+	std::vector<size_t> EvolveBatch(ParticleEnsemble<T>& PE, const size_t& nSteps) {
+	    return EvolveBatch(PE, nSteps, 0, PE.size());
+	}
+
+	/**@brief As above, restricted to the particles [first, last) 
+	*/
+	std::vector<size_t> EvolveBatch(ParticleEnsemble<T>& PE, const size_t& nSteps, const size_t& first, const size_t& last) {
+	    std::vector<size_t> Unresolved;
+	    T* H = PE.H.data();
+	    T* Theta = PE.Theta.data();
+	    T* Tau = PE.Tau.data();
+	    int_ll* Position = PE.Position.data();
+	    int* Label = PE.Label.data();
+	    for (size_t i = first; i < last; ++i) {
+		T h = H[i], theta = Theta[i], tau = Tau[i];
+		int_ll x = Position[i];
+		int label = Label[i];
+		for (size_t n = 0; n < nSteps && label != -1; ++n)
+		    Step(h, theta, tau, x, label);
+		H[i] = h;
+		Theta[i] = theta;
+		Tau[i] = tau;
+		Position[i] = x;
+		Label[i] = label;
+		if (label == -1) 
+		    Unresolved.push_back(i);
+	    }
+	    return Unresolved;
+	}
+
+	/**@brief Advances every particle of a timed ensemble in [first, last) until it reaches time `t`
+	 *
+	 * Each particle steps, at least once, until its time is at least `t` or it is in no region,
+	 * as in `getTrajectory(SP, Time)`. Its last two states and their times are kept for 
+	 * `TimedEnsemble::Record`. Times `t` must not decrease between calls.
+	 * @return Indices of the particles stopped without a region by this call
+	*/
+	std::vector<size_t> AdvanceBatch(TimedEnsemble<T>& TE, const T& t, const size_t& first, const size_t& last) {
+	    std::vector<size_t> Unresolved;
+	    ParticleEnsemble<T>& C = TE.Current;
+	    ParticleEnsemble<T>& P = TE.Previous;
+	    for (size_t i = first; i < last; ++i) {
+		if (C.Label[i] == -1 || (TE.Steps[i] > 0 && TE.Clock[i] >= t)) 
+		    continue;
+		T h = C.H[i], theta = C.Theta[i], tau = C.Tau[i], clock = TE.Clock[i];
+		int_ll x = C.Position[i];
+		int label = C.Label[i];
+		T ph, ptheta, ptau, pclock;
+		int_ll px;
+		int plabel;
+		std::uint64_t steps = TE.Steps[i];
+		do {
+		    ph = h, ptheta = theta, ptau = tau, px = x, plabel = label, pclock = clock;
+		    Step(h, theta, tau, x, label);
+		    clock += tau;
+		    steps++;
+		} while (label != -1 && clock < t);
+		C.Set(i, h, theta, tau, x, label);
+		P.Set(i, ph, ptheta, ptau, px, plabel);
+		TE.Clock[i] = clock;
+		TE.PreviousClock[i] = pclock;
+		TE.Steps[i] = steps;
+		if (label == -1) 
+		    Unresolved.push_back(i);
+	    }
+	    return Unresolved;
+	}
+
+	/**@brief A single iteration of \hat{S} acting on a raw particle state 
+	 *
+	 * Fused equivalent of `SHatMap`, with identical results. The label of the state already 
+	 * determines the wall hit, so the branch of `Sg0`, `Sg2`, `Sg3` or `SR` is taken with one 
+	 * switch on it, without the `IN_BETA19`, `IN_G0` and `IN_G3` tests of `SMap`. tan(theta) 
+	 * and the integer functions alpha, kappa and gamma are evaluated once, and cos(theta) is 
+	 * known to be positive for branches that leave theta unchanged. With the tangent-space 
+	 * classifier the new label also reuses tan(theta) when theta is unchanged. 
+	 *
+	 * A new state in no region in T (on a boundary, or rounded onto the edge of the channel) 
+	 * is classified again in `float_wide`. If it has no region there either, the step is
+	 * repeated in `float_wide` from the state it started from, and the label is -1 only if
+	 * that fails too.
+	*/
+	void Step(T& h, T& theta, T& tau, int_ll& x, int& label) {
+	    SMAP_STEP_TIMER(label);
+	    const T h0 = h, theta0 = theta, tau0 = tau;
+	    const int_ll x0 = x;
+	    const int label0 = label;
+	    const bool dirFlag = !(theta > -PI2 && theta < PI2); // Flag for particle direction
+	    T th = dirFlag ? PI - theta : theta;
+	    const T t = tan(th);
+	    bool unchanged = false; // theta is unchanged, so cos(theta) > 0 and tan(theta) = t
+	    switch (label) {
+		case 0: {
+		    tau = -h / sin(th);
+		    h = -h * (1/t);
+		    th = PI2 - th;
+		} break;
+		case 1: {
+		    const int_ll ALPHA = alphaFromTan(d,h,t); 
+		    tau = d*(ALPHA+3) / cos(th);
+		    h = h + d*(ALPHA + 3)*t + d*(ALPHA + 1);
+		    unchanged = true;
+		} break;
+		case 2: {
+		    tau = -(h + d) / sin(th);
+		    h = (h+d)*(1/t) + 5*d;
+		    th = -(th + PI2);
+		} break;
+		case 3: {
+		    tau = (3*DX + 2*d)/cos(th);
+		    h = h + d*(1 + 5*t);
+		    unchanged = true;
+		} break;
+		case 4: {
+		    tau = (d + DX2)/cos(th);
+		    h = h + (d + DX2) * t + d;
+		    unchanged = true;
+		} break;
+		case 5: {
+		    tau = -h/sin(th);
+		    h = h*(1/t) + 2*d + DX2;
+		    th = -(th + PI2);
+		} break;
+		case 6: {
+		    tau = (DX2 + 2*d)/cos(th);
+		    h = h + (DX2 + 2*d)*t;
+		    unchanged = true;
+		} break;
+		case 7: {
+		    tau = (3*DX + 2*d)/cos(th);
+		    h = h + (2 + d)*t - d;
+		    unchanged = true;
+		} break;
+		case 8: 
+		case 9: {
+		    tau = (DX2 + 2*d)/cos(th);
+		    h = DX2 - (h + (DX2 + 2*d) * t);
+		    th = th + PI;
+		} break;
+		case 10: {
+		    tau = (DX2-h)/sin(th);
+		    h = DX2 + 2*d - (DX2 - h)/t;
+		    th = 3*PI2 - th;
+		} break;
+		case 11: {
+		    tau = (DX2 + d)/cos(th);
+		    h = d + DX2 - (h + (DX2 + d)*t);
+		    th = th + PI;
+		} break;
+		case 12: {
+		    const int_ll KAPPA = kappaFromTan(d,h,t);
+		    tau = (DX2+KAPPA*d)/cos(th);
+		    h = (h + (DX2 + KAPPA*d)*t) - d*KAPPA;
+		    unchanged = true;
+		} break;
+		case 13: {
+		    tau = (DX2 + d)/cos(th);
+		    h = d + 1 - (h + (DX2 + d)*t);
+		    th = th + PI;
+		} break;
+		case 14: {
+		    tau = (d + DX2 - h)/sin(th);
+		    h = (DX2 + d) - (1/t) * (d + DX2 - h);
+		    th = -th + 3*PI2;
+		} break;
+		case 15: 
+		case 16: {
+		    tau = DX2/cos(th);
+		    h = 1 + 2*d - (h + t);
+		    th = th + PI;
+		} break;
+		case 17: {
+		    tau = (1 + 2*d - h)/sin(th);
+		    h = DX2 - (1/t)*(1 + 2*d - h);
+		    th = (3*PI2) - th;
+		} break;
+		case 18: {
+		    const int_ll GAMMA = gammaFromTan(d,h,t);
+		    tau = (DX2 + d*(1 + GAMMA) - h)/sin(th);
+		    h = (1/t) * (DX2 + d*(1 + GAMMA) - h) - d*(GAMMA - 1);
+		    th = PI2 - th;
+		} break;
+		case 19: {			  // RIGHT EXIT, R
+		    tau = 1/cos(th);
+		    h = t + h;
+		    unchanged = true;
+		} break;
+		default:
+		    throw std::runtime_error("Label did not correspond to any region in `Step(...)`.");
+	    }
+	    if (unchanged) 
+		x = dirFlag ? x - 1 : x + 1;
+	    else
+		UpdatePosition(th, x, dirFlag);
+	    if (Classifier == RegionClassifier::Tangent || Classifier == RegionClassifier::Adaptive) {
+		const T thR = getThetaRHS(th);
+		const T tR = unchanged ? t : tan(thR);
+		const bool adaptive = (Classifier == RegionClassifier::Adaptive);
+		if constexpr (std::is_void_v<Geometry>) 
+		    label = adaptive ? whichRegionAdaptive<T>(h, th, thR, tR) : whichRegionTangent<T>(h, th, thR, tR);
+		else
+		    label = adaptive ? whichRegionAdaptive<T, Geometry>(h, th, thR, tR) 
+				     : whichRegionTangent<T, Geometry>(h, th, thR, tR);
+		SMAP_COUNT_CLASSIFIED(label);
+		if (label == -1) 
+		    label = Escalate(h, th);
+	    } else {
+		label = Classify(h, th);
+	    }
+	    theta = dirFlag ? PI - th : th;
+	    if constexpr (!std::is_same_v<T, float_wide>) {
+		if (label == -1) {
+		    h = h0, theta = theta0, tau = tau0, x = x0, label = label0;
+		    StepWide(h, theta, tau, x, label);
+		}
+	    }
+	}
+
+	/**@brief `Step` evaluated in `float_wide`, with the result rounded to T
+	*/
+	void StepWide(T& h, T& theta, T& tau, int_ll& x, int& label) const {
+	    SMAP_COUNT_WIDE_STEP();
+	    float_wide hW = h, thetaW = theta, tauW = tau;
+	    if constexpr (std::is_void_v<Geometry>)
+		ScatteringMap<float_wide>(d).Step(hW, thetaW, tauW, x, label);
+	    else
+		ScatteringMap<float_wide, Geometry>().Step(hW, thetaW, tauW, x, label);
+	    h = hW;
+	    theta = thetaW;
+	    tau = tauW;
 	}
 
 	/**
 	 * @brief Iterates the map and records particle state at selected iterates `N`
 	 *
+	 * With `FastForward`, whole periods of an exactly periodic orbit (Cycle.h) up to the next
+	 * iterate recorded are skipped in closed form.
 	 * @param SP Scattering particle
 	 * @param N Whole number sequence of iterates to be extracted
 	*/
 	STrajectory<T> getTrajectory(SParticle<T>& SP, const std::vector<size_t>& N) {
-	    size_t j = 0;
 	    STrajectory<T> DiscreteTrajectory(N.size());
+	    getTrajectory(SP, N, DiscreteTrajectory.View());
+	    return DiscreteTrajectory;
+	}
+
+	/**
+	 * @brief Iterates the map and records particle state at selected iterates `N` into
+	 * `DiscreteTrajectory`, e.g. a row of an `EnsembleTrajectory`
+	 *
+	 * Overloaded function. `DiscreteTrajectory` holds `N.size()` entries, none recorded yet
+	*/
+	void getTrajectory(SParticle<T>& SP, const std::vector<size_t>& N, TrajectoryView<T> DiscreteTrajectory) {
+	    size_t j = 0;
 	    T TAU = 0; // Total time
+	    CycleDetector<T> Cycle;
 	    for (size_t i = 0; i < N.back(); ++i) {
 
+		if (SP.Label == -1) // No region: the remaining iterates are left with label -1
+		    return;
 		if (N[j] == i) { // Record the state of the N[j] iterate
 		    DiscreteTrajectory.Update(SP,TAU); 
 		    j++;
 		}
 		Evolve(SP);
 		TAU += SP.Tau;
+		if (FastForward && Cycle.Push(SP.H, SP.Theta, SP.Label, SP.Position, TAU)) {
+		    const size_t periods = (N[j] - (i + 1)) / Cycle.Period(); // Whole periods before iterate N[j]
+		    SP.Position += (int_ll)periods * Cycle.Displacement();
+		    TAU += (T)periods * Cycle.Duration();
+		    i += periods * Cycle.Period();
+		    Cycle.Reset();
+		}
 	    }
-	    DiscreteTrajectory.Update(SP,TAU); 
-	    return DiscreteTrajectory;
+	    if (SP.Label != -1)
+		DiscreteTrajectory.Update(SP,TAU); 
 	}
 
 	/**
@@ -56,18 +350,33 @@ struct ScatteringMap {
 	 * NOTE 1: For d=1/2 the dwell time has no bound and the particle can be
 	 * localised to a cell an extended period. In this scenario the `STrajectory` 
 	 * is filled with replicates of `SP` spanning the localised time frame. 
+	 *
+	 * NOTE 2: With `FastForward`, whole periods of an exactly periodic orbit (Cycle.h) ending at
+	 * least one period before the next time recorded are skipped in closed form.
 	*/
 	STrajectory<T> getTrajectory(SParticle<T>& SP, const std::vector<T>& Time) {
+	    STrajectory<T> ContinuousTrajectory(Time.size()); 
+	    getTrajectory(SP, Time, ContinuousTrajectory.View());
+	    return ContinuousTrajectory;
+	}
+
+	/**
+	 * @brief Iterates the map and records particle state at selected times `Time` into
+	 * `ContinuousTrajectory`
+	 *
+	 * Overloaded function. `ContinuousTrajectory` holds `Time.size()` entries, none recorded yet
+	*/
+	void getTrajectory(SParticle<T>& SP, const std::vector<T>& Time, TrajectoryView<T> ContinuousTrajectory) {
     	
     	    // Evolve in continuous time
     	    size_t tidx = 0;  
     	    T TAU = SP.Tau;  // Current time
     	    T pTAU = TAU;    // Previous time
     	
-    	    STrajectory<T> ContinuousTrajectory(Time.size()); 
+	    CycleDetector<T> Cycle;
 
     	    // Evolve map until time exceeds target time
-    	    while (tidx < Time.size()) {
+    	    while (tidx < Time.size() && SP.Label != -1) {
     	
 		const SParticle<T> pSP = SP; // Particle state prior to update
     		Evolve(SP);
@@ -86,40 +395,113 @@ struct ScatteringMap {
 		}
 		//ContinuousTrajectory.UpdateTime(SP.Tau); // total time 
     		pTAU = TAU;
+		if (FastForward && tidx < Time.size() && Cycle.Push(SP.H, SP.Theta, SP.Label, SP.Position, TAU)
+		    && Cycle.Duration() > 0) {
+		    const T periods = std::floor((Time[tidx] - TAU) / Cycle.Duration()) - 1; // Leaves one to step
+		    if (periods > 0) {
+			SP.Position += (int_ll)periods * Cycle.Displacement();
+			TAU += periods * Cycle.Duration();
+			pTAU = TAU;
+			Cycle.Reset();
+		    }
+		}
     	    }
-    	    return ContinuousTrajectory;
     	}
 
 	// Eq. 1
 	// @brief Iterates the scattering map 
 	void SHatMap(SParticle<T>& SP, bool& dirFlag) {
-	    if (SP.Theta > -PI2 && SP.Theta < PI2) { // Moving in the positive direction
-		SMap(SP, dirFlag);
+	    SHatMap(SP.H, SP.Theta, SP.Tau, SP.Position, SP.Label, dirFlag);
+	}
+
+	void SHatMap(T& h, T& theta, T& tau, int_ll& x, int& label, bool& dirFlag) {
+	    if (theta > -PI2 && theta < PI2) { // Moving in the positive direction
+		SMap(h, theta, tau, x, label, dirFlag);
 	    } else {
 		dirFlag = true;	
-		SP.Theta = PI - SP.Theta;
-		SMap(SP, dirFlag);
-		SP.Theta = PI - SP.Theta; // Revert 
+		theta = PI - theta;
+		SMap(h, theta, tau, x, label, dirFlag);
+		theta = PI - theta; // Revert 
 	    }
 	}
 
 	// S(h,\theta) or S(h, \pi - \theta)
 	// Note: SP.Label must always be initialised
 	void SMap(SParticle<T>& SP, bool& dirFlag)  {
-	    if (IN_BETA19(d,SP.H,SP.Theta)) {           // RIGHT EXIT, R
-		SP.Label = 19;
-		SR(SP.H, SP.Theta, SP.Tau);
-	    } else if (IN_G0(d,SP.H,SP.Theta)) {        // BOTTOM LEFT, \Gamma_0
-		Sg0(SP.H, SP.Theta, SP.Tau, SP.Label);
-	    } else if (IN_G3(d,SP.H,SP.Theta)) {        // TOP LEFT, \Gamma_3
-		Sg3(SP.H, SP.Theta, SP.Tau, SP.Label);
-	    } else {					// TOP RIGHT, \Gamma_2
-		Sg2(SP.H, SP.Theta, SP.Tau, SP.Label);
+	    SMap(SP.H, SP.Theta, SP.Tau, SP.Position, SP.Label, dirFlag);
+	}
+
+	void SMap(T& h, T& theta, T& tau, int_ll& x, int& label, bool& dirFlag)  {
+	    SMAP_STEP_TIMER(label);
+	    if (ExitsRight(h, theta)) {           // RIGHT EXIT, R
+		label = 19;
+		SR(h, theta, tau);
+	    } else if (IN_G0(d,h,theta)) {        // BOTTOM LEFT, \Gamma_0
+		Sg0(h, theta, tau, label);
+	    } else if (IN_G3(d,h,theta)) {        // TOP LEFT, \Gamma_3
+		Sg3(h, theta, tau, label);
+	    } else {				  // TOP RIGHT, \Gamma_2
+		Sg2(h, theta, tau, label);
 	    }
-	    UpdatePosition(SP.Theta, SP.Position, dirFlag);
-	    SP.Label = whichRegion<T>(SP.H,SP.Theta);
+	    UpdatePosition(theta, x, dirFlag);
+	    label = Classify(h,theta);
 	 }
 
+	// @brief Region label of (h,theta) by the classifier selected in `config::classifier` at construction
+	// A point in no region in T is classified again in `float_wide`
+	int Classify(const T& h, const T& theta) const {
+	    const int label = [&] {
+		switch (Classifier) {
+		    case RegionClassifier::Index: 
+			return Index->Classify<T>(h,theta);
+		    case RegionClassifier::Validate: 
+			return whichRegionValidated<T>(h,theta);
+		    case RegionClassifier::Tangent:
+			if constexpr (std::is_void_v<Geometry>) 
+			    return whichRegionTangent<T>(h,theta);
+			else
+			    return whichRegionTangent<T, Geometry>(h,theta);
+		    case RegionClassifier::Adaptive:
+			if constexpr (std::is_void_v<Geometry>) 
+			    return whichRegionAdaptive<T>(h,theta);
+			else
+			    return whichRegionAdaptive<T, Geometry>(h,theta);
+		    default:
+			if constexpr (std::is_void_v<Geometry>) 
+			    return whichRegion<T>(h,theta);
+			else
+			    return whichRegion<T, Geometry>(h,theta);
+		}
+	    }();
+	    SMAP_COUNT_CLASSIFIED(label);
+	    return (label != -1) ? label : Escalate(h, theta);
+	}
+
+	// @brief Region label of (h,theta) in `float_wide`. -1 if the point is in no region there either
+	int Escalate(const T& h, const T& theta) const {
+	    SMAP_COUNT_ESCALATED();
+	    if constexpr (std::is_void_v<Geometry>) 
+		return whichRegion<float_wide>(h, theta);
+	    else
+		return whichRegion<float_wide, Geometry>(h, theta);
+	}
+
+	RegionClassifier Classifier = config::classifier;
+	/// Trajectories skip whole periods of exactly periodic orbits (Cycle.h)
+	bool FastForward = config::fastForward;
+	/// Label index of LabelIndex.h when selected
+	const LabelIndex* Index = (Classifier == RegionClassifier::Index) ? &getLabelIndex() : nullptr;
+
+	// \beta_19 is empty unless d = 1
+	bool ExitsRight(const T& h, const T& theta) const {
+	    if constexpr (std::is_void_v<Geometry>) 
+		return IN_BETA19(d,h,theta);
+	    else if constexpr (Geometry::widthSelection == 1)
+		return IN_BETA19(d,h,theta);
+	    else
+		return false;
+	}
+
 	// @brief Updates the position of a particle from its exit angle 
 	void UpdatePosition(const T& theta, int_ll& x, const bool& dirFlag) {
 	    if (dirFlag && (cos(theta) >= 0)) { 
@@ -0,0 +1,126 @@
+/**
+ * @brief Shadow runs of the map in a fast precision against a reference precision
+ *
+ * A sample of particles is started from identical states (representable in the fast precision)
+ * and iterated in both. The iterate at which the labels of a particle first differ bounds the
+ * horizon over which statistics computed in the fast precision can be trusted.
+ */
+
+#ifndef SHADOW_H_INCLUDED
+#define SHADOW_H_INCLUDED
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "SMapHelper.h"
+#include "ScatteringMap.h"
+
+/**@brief Iterates of first label divergence of a sample of shadowed particles
+ */
+struct ShadowReport {
+
+    size_t nSteps = 0;		         // Horizon of the shadow runs
+    std::vector<size_t> firstDivergence; // Per particle, nSteps + 1 when the labels agree throughout
+    std::string precision;		 // Fast precision, e.g. "float"
+
+    size_t size() const { return firstDivergence.size(); }
+
+    bool empty() const { return firstDivergence.empty(); }
+
+    /// Appends the particles of another report over the same horizon
+    void Add(const ShadowReport& other) {
+	if (other.empty()) return;
+	if (!empty() && other.nSteps != nSteps)
+	    throw std::invalid_argument("ERROR: Mismatched horizons in @ShadowReport::Add().");
+	nSteps = other.nSteps;
+	precision = other.precision;
+	firstDivergence.insert(firstDivergence.end(), other.firstDivergence.begin(), other.firstDivergence.end());
+    }
+
+    /// Fraction of particles whose labels differ at or before iterate n
+    float_ FractionDiverged(const size_t& n) const {
+	if (empty()) return 0;
+	return (float_)std::ranges::count_if(firstDivergence, [&n](const size_t& k) { return k <= n; })/size();
+    }
+
+    /**@brief Last iterate up to which at most a fraction `tolerance` of the particles have diverged
+    * @return nSteps when the tolerance holds over the whole horizon
+    */
+    size_t TrustedIterates(const float_& tolerance) const {
+	std::vector<size_t> sorted = firstDivergence;
+	std::ranges::sort(sorted);
+	const size_t allowed = tolerance*size(); // Particles that may have diverged
+	if (allowed >= size() || sorted[allowed] > nSteps) return nSteps;
+	return sorted[allowed] == 0 ? 0 : sorted[allowed] - 1;
+    }
+
+    /// q-quantile of the iterate of first divergence (nSteps + 1 beyond the horizon)
+    size_t Quantile(const float_& q) const {
+	std::vector<size_t> sorted = firstDivergence;
+	std::ranges::sort(sorted);
+	return sorted[std::min((size_t)(q*size()), size() - 1)];
+    }
+
+    void Print() const {
+	std::cout << "Shadow of " << size() << " particles in " << precision << " against double over "
+		  << nSteps << " iterates: labels agree for all but 1% of particles up to iterate "
+		  << TrustedIterates(0.01) << ", and for half of them up to iterate "
+		  << TrustedIterates(0.5) << ". " << 100*(1 - FractionDiverged(nSteps))
+		  << "% never diverge.\n";
+    }
+
+    void WriteJSON(const std::string& fname) const {
+	nlohmann::ordered_json j;
+	j["precision"] = precision;
+	j["particles"] = size();
+	j["iterates"] = nSteps;
+	j["trusted_iterates"]["0.01"] = TrustedIterates(0.01);
+	j["trusted_iterates"]["0.05"] = TrustedIterates(0.05);
+	j["trusted_iterates"]["0.5"] = TrustedIterates(0.5);
+	j["fraction_diverged"] = FractionDiverged(nSteps);
+	j["first_divergence"] = firstDivergence;
+	std::ofstream ofs(fname);
+	if (!ofs.is_open())
+	    throw std::runtime_error("ERROR: Could not open file: " + fname + ".");
+	ofs << j.dump(4);
+    }
+};
+
+/**@brief Iterates each initial condition in precisions `Lo` and `Hi` and records when their labels first differ
+ *
+ * Initial conditions are first rounded to `Lo`, so that both runs start from the same state.
+ * A state without a region (label -1) in both precisions ends a run, counted as a divergence.
+ * @param h Initial heights
+ * @param theta Initial angles
+ * @param nSteps Horizon
+*/
+template <typename Lo, typename Hi = float_>
+ShadowReport ShadowRun(const std::vector<Hi>& h, const std::vector<Hi>& theta, const size_t& nSteps) {
+    if (h.size() != theta.size())
+	throw std::invalid_argument("ERROR: Mismatched `h` and `theta` sizes in @ShadowRun().");
+    ScatteringMap<Lo> MapLo(config::d);
+    ScatteringMap<Hi> MapHi(config::d);
+    ShadowReport Report;
+    Report.nSteps = nSteps;
+    Report.precision = std::is_same_v<Lo, float> ? "float" : std::is_same_v<Lo, double> ? "double" : "long double";
+    Report.firstDivergence.resize(h.size());
+    for (size_t i = 0; i < h.size(); ++i) {
+	Lo hLo = (Lo)h[i], thetaLo = (Lo)theta[i], tauLo = 0;
+	Hi hHi = hLo, thetaHi = thetaLo, tauHi = 0;
+	int_ll xLo = 0, xHi = 0;
+	int labelLo = whichRegion<Lo>(hLo, thetaLo), labelHi = whichRegion<Hi>(hHi, thetaHi);
+	size_t n = 0;
+	for (; n <= nSteps && labelLo == labelHi; ++n) {
+	    if (n == nSteps) continue;
+	    if (labelLo == -1) break;
+	    MapLo.Step(hLo, thetaLo, tauLo, xLo, labelLo);
+	    MapHi.Step(hHi, thetaHi, tauHi, xHi, labelHi);
+	}
+	Report.firstDivergence[i] = n;
+    }
+    return Report;
+}
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * @brief Merging the files of a run split into shards with `--shard i/N`
+ *
+ * Shard i of a run writes a contiguous range of the initial conditions of the run, in order, to
+ * files named by `config::getShardName`. Merging the shards in order therefore gives the file of
+ * a single run with the same seed, byte for byte: text files are concatenated, .npy files get one
+ * header with the total number of rows, and encoded files keep the file header of the first shard.
+ * Region point files hold one row per region, of which each shard writes a piece, so their rows
+ * are joined instead.
+ */
+
+#ifndef SHARDS_H_INCLUDED
+#define SHARDS_H_INCLUDED
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "Writer.h"
+#include "Codec.h"
+
+namespace shards {
+
+    inline std::string ReadFile(const std::string& fname) {
+	std::ifstream ifs(fname, std::ios::binary);
+	if (!ifs.is_open())
+	    throw std::runtime_error("ERROR: Could not open file: " + fname + ".");
+	return std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    }
+
+    /// Value of `key` in the header dictionary of a .npy file, up to the first of `delimiters`
+    inline std::string NPYField(const std::string& header, const std::string& key, const std::string& delimiters,
+				const std::string& fname) {
+	const size_t p = header.find("'" + key + "': ");
+	if (p == std::string::npos)
+	    throw std::runtime_error("ERROR: No '" + key + "' in the header of " + fname + ".");
+	const size_t first = p + key.size() + 4;
+	return header.substr(first, header.find_first_of(delimiters, first) - first);
+    }
+
+    /**@brief Concatenates text files
+    */
+    inline void MergeText(const std::vector<std::string>& fnames, std::ofstream& ofs) {
+	for (const auto& fname : fnames)
+	    ofs << ReadFile(fname);
+    }
+
+    /**@brief Concatenates the rows of .npy files written by `Writer` under one header
+    *
+    * Shards with no rows are skipped, the others must have the same type and number of columns.
+    */
+    inline void MergeNPY(const std::vector<std::string>& fnames, std::ofstream& ofs) {
+	std::vector<std::string> data;
+	std::string descr;
+	size_t rows = 0, cols = 0;
+	for (const auto& fname : fnames) {
+	    const std::string bytes = ReadFile(fname);
+	    if (bytes.size() < NPY_HEADER_SIZE || bytes.compare(0, 8, std::string("\x93NUMPY\x01\x00", 8)) != 0)
+		throw std::runtime_error("ERROR: " + fname + " is not a .npy file written by Writer.");
+	    const std::string header = bytes.substr(0, NPY_HEADER_SIZE);
+	    const std::string shape = NPYField(header, "shape", ")", fname).substr(1);
+	    const size_t r = std::stoul(shape), c = std::stoul(shape.substr(shape.find(',') + 1));
+	    if (r == 0) continue;
+	    const std::string d = NPYField(header, "descr", ",", fname); // Quoted
+	    if (rows > 0 && (d != descr || c != cols))
+		throw std::runtime_error("ERROR: Rows of " + fname + " differ in type or length from the other shards.");
+	    descr = d;
+	    cols = c;
+	    rows += r;
+	    data.push_back(bytes.substr(NPY_HEADER_SIZE));
+	}
+	// Header as `Writer` writes it for the rows of all shards
+	ofs << npyHeader(rows ? descr.substr(1, descr.size() - 2) : npyDescr<double>(), rows, cols);
+	for (const auto& d : data)
+	    ofs << d;
+    }
+
+    /**@brief Concatenates the rows of encoded files (Codec.h), after the file header of the first
+    */
+    inline void MergeEncoded(const std::vector<std::string>& fnames, std::ofstream& ofs) {
+	for (size_t i = 0; i < fnames.size(); ++i) {
+	    const std::string bytes = ReadFile(fnames[i]);
+	    const size_t headerSize = CodecHeader(Codec{}).size();
+	    if (bytes.size() < headerSize || bytes.compare(0, CODEC_MAGIC.size(), CODEC_MAGIC) != 0)
+		throw std::runtime_error("ERROR: " + fnames[i] + " is not an encoded trajectory file.");
+	    if (i > 0 && bytes.compare(0, headerSize, ReadFile(fnames[0]), 0, headerSize) != 0)
+		throw std::runtime_error("ERROR: " + fnames[i] + " is encoded differently from the other shards.");
+	    ofs << (i == 0 ? bytes : bytes.substr(headerSize));
+	}
+    }
+
+    /**@brief Joins row k of every text file into row k of the merged file, skipping empty pieces
+    */
+    inline void MergeRows(const std::vector<std::string>& fnames, std::ofstream& ofs) {
+	std::vector<std::vector<std::string>> pieces;
+	for (const auto& fname : fnames) {
+	    std::ifstream ifs(fname);
+	    if (!ifs.is_open())
+		throw std::runtime_error("ERROR: Could not open file: " + fname + ".");
+	    std::vector<std::string> lines;
+	    for (std::string line; std::getline(ifs, line);)
+		lines.push_back(line);
+	    if (!pieces.empty() && lines.size() != pieces[0].size())
+		throw std::runtime_error("ERROR: " + fname + " has a different number of rows from the other shards.");
+	    pieces.push_back(lines);
+	}
+	for (size_t k = 0; !pieces.empty() && k < pieces[0].size(); ++k) {
+	    std::string row;
+	    for (const auto& lines : pieces) {
+		if (lines[k].empty()) continue;
+		row += (row.empty() ? "" : " ") + lines[k];
+	    }
+	    ofs << row << "\n";
+	}
+    }
+}
+
+/**@brief Writes `fname` from its N shard files `config::getShardName(fname, i, N)`
+ *
+ * @param fname Data file of a single run
+ * @param N Number of shards
+ * @param joinRows Join the rows of the shards, for region point files, instead of appending them
+*/
+inline void MergeShards(const std::string& fname, const size_t& N, const bool& joinRows = false) {
+    std::vector<std::string> fnames;
+    for (size_t i = 0; i < N; ++i) {
+	fnames.push_back(config::getShardName(fname, i, N));
+	if (!std::filesystem::exists(fnames.back()))
+	    throw std::runtime_error("ERROR: Missing shard " + fnames.back() + ".");
+    }
+    Codec codec;
+    const bool npy = fname.ends_with(".npy"), encoded = getCodec(fname, codec);
+    std::ofstream ofs(fname, std::ios::binary);
+    if (!ofs.is_open())
+	throw std::runtime_error("ERROR: Could not open file: " + fname + ".");
+    if (npy)
+	shards::MergeNPY(fnames, ofs);
+    else if (encoded)
+	shards::MergeEncoded(fnames, ofs);
+    else if (joinRows)
+	shards::MergeRows(fnames, ofs);
+    else
+	shards::MergeText(fnames, ofs);
+    if (!ofs.flush())
+	throw std::runtime_error("ERROR: Could not write to file: " + fname + ".");
+}
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @brief Time-synchronous snapshots of an ensemble: the state of every particle at each time of a
+ * grid, as `ScatteringMap::getTrajectory(SP, Time)` records them particle by particle
+ *
+ * The ensemble is advanced to one time after another (`TimedEnsemble`, `AdvanceBatch`), and each
+ * snapshot is handed on before the next is taken, so memory grows with the ensemble and not with
+ * the grid. Snapshots are written whole, as their positions only, or as histograms of position.
+ */
+
+#ifndef SNAPSHOT_H_INCLUDED
+#define SNAPSHOT_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+#include "config.h"
+#include "Ensemble.h"
+
+/// What `WriteSnapshotData` writes of each snapshot
+enum class SnapshotOutput { States, Positions, Histogram };
+
+template <typename T>
+struct EnsembleSnapshot {
+
+    EnsembleSnapshot(const size_t& n) : State(n), Time(n, (T)0) { }
+
+    size_t size() const { return State.size(); }
+
+    size_t index = 0;	       // Index of the snapshot in the time grid
+    T t = 0;		       // Time of the snapshot
+    ParticleEnsemble<T> State; // State of each particle nearest in time to `t`
+    std::vector<T> Time;       // Time at which each state was reached
+};
+
+/**@brief Histogram of the positions of a snapshot
+ *
+ * @param Snapshot Snapshot of an ensemble
+ * @param maxDisplacement Largest |x| binned
+ * @return Counts of x = -maxDisplacement...maxDisplacement, followed by the count of particles
+ * further out or in no region
+*/
+template <typename T>
+std::vector<std::uint64_t> getPositionHistogram(const EnsembleSnapshot<T>& Snapshot, const int_ll& maxDisplacement) {
+    std::vector<std::uint64_t> counts(2*maxDisplacement + 2, 0);
+    const ParticleEnsemble<T>& S = Snapshot.State;
+    for (size_t i = 0; i < Snapshot.size(); ++i) {
+	const int_ll x = S.Position[i];
+	if (S.Label[i] == -1 || x < -maxDisplacement || x > maxDisplacement)
+	    counts.back()++;
+	else
+	    counts[x + maxDisplacement]++;
+    }
+    return counts;
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef THREADPOOL_H_INCLUDED
+#define THREADPOOL_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "config.h"
+
+/**@brief Persistent pool of worker threads that share chunks of an index range by work stealing
+ *
+ * Each worker is handed a contiguous block of chunks and works through it from the front. A
+ * worker whose own queue is empty steals from the back of another worker's queue, so regions
+ * with expensive particles (e.g. bouncing or localised orbits) do not leave the others idle.
+ * The calling thread takes part as worker 0.
+ */
+class ThreadPool
+{
+    public:
+	ThreadPool() : ThreadPool(config::nThreads) { }
+
+	ThreadPool(const size_t& nThreads) {
+	    nWorkers = std::max<size_t>(nThreads, 1);
+	    for (size_t i = 0; i < nWorkers; ++i)
+		queues.push_back(std::make_unique<ChunkQueue>());
+	    for (size_t i = 1; i < nWorkers; ++i)
+		workers.emplace_back([this, i] { WorkerLoop(i); });
+	}
+
+	~ThreadPool() {
+	    {
+		std::lock_guard<std::mutex> lock(poolMutex);
+		stop = true;
+	    }
+	    wake.notify_all();
+	    for (auto& w : workers)
+		w.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	size_t size() const { return nWorkers; }
+
+	/**@brief Calls `func(first, last, threadID)` over [0,n) in chunks of `chunkSize` and waits
+	 *
+	 * The first exception thrown by `func` is rethrown on the calling thread once all
+	 * chunks have been processed.
+	 * @param n Number of items
+	 * @param chunkSize Number of items per chunk
+	 * @param func Callable void(size_t first, size_t last, size_t threadID)
+	*/
+	template <typename F>
+	void ParallelFor(const size_t& n, const size_t& chunkSize, F&& func) {
+	    if (n == 0) return;
+	    chunk = std::max<size_t>(chunkSize, 1);
+	    nItems = n;
+	    job = std::forward<F>(func);
+	    error = nullptr;
+
+	    // Contiguous blocks of chunks per worker
+	    const size_t nChunks = (n + chunk - 1)/chunk;
+	    remaining.store(nChunks);
+	    for (size_t w = 0; w < nWorkers; ++w) {
+		std::lock_guard<std::mutex> lock(queues[w]->m);
+		for (size_t c = w*nChunks/nWorkers; c < (w+1)*nChunks/nWorkers; ++c)
+		    queues[w]->chunks.push_back(c);
+	    }
+	    {
+		std::lock_guard<std::mutex> lock(poolMutex);
+		generation++;
+	    }
+	    wake.notify_all();
+
+	    RunChunks(0);
+	    std::unique_lock<std::mutex> lock(poolMutex);
+	    finished.wait(lock, [this] { return remaining.load() == 0; });
+	    if (error)
+		std::rethrow_exception(error);
+	}
+
+    private:
+	struct ChunkQueue {
+	    std::mutex m;
+	    std::deque<size_t> chunks;
+	};
+
+	void WorkerLoop(const size_t& id) {
+	    size_t seen = 0;
+	    while (true) {
+		{
+		    std::unique_lock<std::mutex> lock(poolMutex);
+		    wake.wait(lock, [this, &seen] { return stop || generation != seen; });
+		    if (stop) return;
+		    seen = generation;
+		}
+		RunChunks(id);
+	    }
+	}
+
+	// Own chunks from the front, then steal from the back of the others
+	void RunChunks(const size_t& id) {
+	    size_t c;
+	    while (PopFront(id, c) || Steal(id, c)) {
+		const size_t first = c*chunk;
+		const size_t last = std::min(first + chunk, nItems);
+		try {
+		    job(first, last, id);
+		} catch (...) {
+		    std::lock_guard<std::mutex> lock(poolMutex);
+		    if (!error) error = std::current_exception();
+		}
+		if (remaining.fetch_sub(1) == 1) {
+		    std::lock_guard<std::mutex> lock(poolMutex);
+		    finished.notify_all();
+		}
+	    }
+	}
+
+	bool PopFront(const size_t& id, size_t& c) {
+	    std::lock_guard<std::mutex> lock(queues[id]->m);
+	    if (queues[id]->chunks.empty()) return false;
+	    c = queues[id]->chunks.front();
+	    queues[id]->chunks.pop_front();
+	    return true;
+	}
+
+	bool Steal(const size_t& id, size_t& c) {
+	    for (size_t k = 1; k < nWorkers; ++k) {
+		ChunkQueue& victim = *queues[(id + k) % nWorkers];
+		std::lock_guard<std::mutex> lock(victim.m);
+		if (!victim.chunks.empty()) {
+		    c = victim.chunks.back();
+		    victim.chunks.pop_back();
+		    return true;
+		}
+	    }
+	    return false;
+	}
+
+	size_t nWorkers;
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<ChunkQueue>> queues;
+
+	std::function<void(size_t, size_t, size_t)> job;
+	size_t nItems = 0;
+	size_t chunk = 1;
+	std::atomic<size_t> remaining = 0;
+	std::exception_ptr error;
+
+	std::mutex poolMutex;
+	std::condition_variable wake, finished;
+	size_t generation = 0;
+	bool stop = false;
+};
+
+#endif
@@ -1,6 +1,12 @@
 #ifndef TRAJECTORY_H_INCLUDED
 #define TRAJECTORY_H_INCLUDED
 
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <span>
 #include <vector>
 #include "config.h"
 #include "Particle.h"
@@ -8,6 +14,110 @@
 #include "Writer.h"
 #include "json.hpp" // https://github.com/nlohmann/json
 
+/**@brief Prints the first `nToPrint` entries of a vector on one line, after its name
+ */
+template <typename T>
+void PrintVector(const std::string& name, const std::vector<T>& v, const size_t& nToPrint) {
+    std::cout << "    " << name << ": ";
+    for (size_t i = 0; i < std::min(nToPrint, v.size()); ++i)
+	std::cout << v[i] << " ";
+    std::cout << (nToPrint < v.size() ? "...\n" : "\n");
+}
+
+/**@brief Itinerary codes (see `getItineraryCode`) of the recorded states of a trajectory, an
+ * `STrajectory` or a `TrajectoryView`, -1 elsewhere
+ */
+template <typename Traj>
+std::vector<std::int64_t> getTrajectoryItineraryCodes(const Traj& traj) {
+    std::vector<std::int64_t> codes(traj.N,-1);
+    for (size_t i = 0; i < traj.nIterations; ++i) 
+	codes[i] = getItineraryCode<typename Traj::value_type>(traj.H[i], traj.Theta[i], traj.Label[i]);
+    return codes;
+}
+
+/**@brief Writes selected field members of a trajectory, an `STrajectory` or a `TrajectoryView`
+ * @param trajWriters Fixed array of writer objects 
+ * @param idx Members written: 0 H, 1 Time, 2 Theta, 3 Label, 4 Position, else itinerary codes
+ */ 
+template <typename Traj>
+void WriteTrajectorySelected(const Traj& traj, std::array<Writer,6>& trajWriters, const std::vector<size_t>& idx) {
+    using T = typename Traj::value_type;
+    for (size_t i = 0; i < idx.size(); ++i) {
+	if (idx[i] == 0) { trajWriters[0].WriteRowVector<T>(std::span<const T>(traj.H)); }
+	else if (idx[i] == 1) { trajWriters[1].WriteRowVector<T>(std::span<const T>(traj.Time)); }
+	else if (idx[i] == 2) { trajWriters[2].WriteRowVector<T>(std::span<const T>(traj.Theta)); }
+	else if (idx[i] == 3) { trajWriters[3].WriteRowVector<int>(std::span<const int>(traj.Label)); }
+	else if (idx[i] == 4) { trajWriters[4].WriteRowVector<int_ll>(std::span<const int_ll>(traj.Position)); }
+	else { trajWriters[5].WriteRowVector<std::int64_t>(getTrajectoryItineraryCodes(traj)); }
+    }
+}
+
+/**@brief Trajectory stored in memory it does not own, such as a row of an `EnsembleTrajectory`
+ *
+ * Same members and accessors as `STrajectory`, with spans in place of vectors. Copies refer to
+ * the same storage.
+ */
+template <typename T>
+struct TrajectoryView {
+
+    using value_type = T;
+
+    TrajectoryView(std::span<T> h, std::span<T> theta, std::span<T> tau, std::span<T> time, 
+		   std::span<int> label, std::span<int_ll> position, size_t& n)
+	: H(h), Theta(theta), Tau(tau), Time(time), Label(label), Position(position), nIterations(n), N(h.size()) { }
+
+    /// Update trajectory data with an raw elements
+    void Update(const T& h, const T& theta, const T& tau, const int_ll& position, const int& label) {
+	H[nIterations] = h;
+	Theta[nIterations] = theta;
+	Tau[nIterations] = tau;
+	Position[nIterations] = position;
+	Label[nIterations] = label;
+	UpdateTime(tau);
+	nIterations++;
+    }
+
+    /// Update trajectory data with an `SParticle`
+    void Update(const SParticle<T>& SP) { Update(SP.H, SP.Theta, SP.Tau, SP.Position, SP.Label); }
+
+    void Update(const SParticle<T>& SP, const T& cumulTime) {
+	H[nIterations] = SP.H;
+	Theta[nIterations] = SP.Theta;
+	Tau[nIterations] = SP.Tau;
+	Position[nIterations] = SP.Position;  
+	Label[nIterations] = SP.Label;
+	Time[nIterations] = cumulTime;
+	nIterations++;
+    }
+
+    void UpdateTime(const T& tau) {
+	if (nIterations > 0 && nIterations < N)
+	    Time[nIterations] = Time[nIterations-1] + tau;
+    }
+
+    std::vector<std::int64_t> getItineraryCodes() const { return getTrajectoryItineraryCodes(*this); }
+
+    std::vector<std::string> getItinerary() const {
+	std::vector<std::string> itineraries(N,"NULL");
+	for (size_t i = 0; i < nIterations; ++i) 
+	    itineraries[i] = getItineraryFromCode(getItineraryCode<T>(H[i], Theta[i], Label[i]));
+	return itineraries;
+    }
+
+    void Write(std::array<Writer,6>& trajWriters) const { WriteSelected(trajWriters, { 0, 1, 2, 3, 4, 5 }); }
+
+    void WriteSelected(std::array<Writer,6>& trajWriters, const std::vector<size_t>& idx) const {
+	WriteTrajectorySelected(*this, trajWriters, idx);
+    }
+
+    std::span<T> H, Theta, Tau;	   // Entrance heights, angles and dwell times
+    std::span<T> Time;		   // Running sum of dwell times
+    std::span<int> Label;	   // Region label
+    std::span<int_ll> Position;	   // Lifted position of particle
+    size_t& nIterations;	   // Index to each member (current size), held by the storage
+    size_t N;			   // Final size
+};
+
 /**@brief Low cost equivalent of std::vector<SParticle>
  * 
  * TODO: Currently overspecified. 
@@ -15,6 +125,8 @@
 template <typename T>
 struct STrajectory {
 
+    using value_type = T;
+
     STrajectory(const size_t& n) {
 	N = n;
 	nIterations = 0;
@@ -64,12 +176,16 @@ struct STrajectory {
 	    Time[nIterations] = Time[nIterations-1] + tau;
     }
 
-    /**@brief Gets currently available itineraries  
+    /**@brief Gets the itinerary codes (see `getItineraryCode`) of the available states, -1 elsewhere
+     */
+    std::vector<std::int64_t> getItineraryCodes() const { return getTrajectoryItineraryCodes(*this); }
+
+    /**@brief Gets currently available itineraries, as strings for printing
      */
     std::vector<std::string> getItinerary() const {
         std::vector<std::string> itineraries(N,"NULL");
         for (size_t i = 0; i < nIterations; ++i) 
-	    itineraries[i] = getItineraryFromLabel<T>(H[i], Theta[i], Label[i]);
+	    itineraries[i] = getItineraryFromCode(getItineraryCode<T>(H[i], Theta[i], Label[i]));
         return itineraries;
     }
 
@@ -99,31 +215,18 @@ struct STrajectory {
     /**@brief Writes all field members
      * @param trajWriters Fixed array of writer objects 
      */ 
-    void Write(std::array<Writer,6>& trajWriters) const {
-	trajWriters[0].WriteRowVector<T>(H);
-	trajWriters[1].WriteRowVector<T>(Time);
-	trajWriters[2].WriteRowVector<T>(Theta);
-	trajWriters[3].WriteRowVector<int>(Label);
-	trajWriters[4].WriteRowVector<int_ll>(Position);
-	trajWriters[5].WriteRowVector<std::string>(getItinerary());
-    }    
+    void Write(std::array<Writer,6>& trajWriters) const { WriteSelected(trajWriters, { 0, 1, 2, 3, 4, 5 }); }
 
     /**@brief Writes selected field members
      * @param trajWriters Fixed array of writer objects 
      */ 
     void WriteSelected(std::array<Writer,6>& trajWriters, const std::vector<size_t>& idx) const {
-	//idx.erase(std::unique(idx.begin(), idx.end()),idx.end());
-	//
-	for (size_t i = 0; i < idx.size(); ++i) {
-	    if (idx[i] == 0) { trajWriters[0].WriteRowVector<T>(H); }
-	    else if (idx[i] == 1) { trajWriters[1].WriteRowVector<T>(Time); }
-	    else if (idx[i] == 2) { trajWriters[2].WriteRowVector<T>(Theta); }
-	    else if (idx[i] == 3) { trajWriters[3].WriteRowVector<int>(Label); }
-	    else if (idx[i] == 4) { trajWriters[4].WriteRowVector<int_ll>(Position); }
-	    else { trajWriters[5].WriteRowVector<std::string>(getItinerary()); }
-	}
+	WriteTrajectorySelected(*this, trajWriters, idx);
     }
 
+    /// View of the members, to record into with `ScatteringMap::getTrajectory`
+    TrajectoryView<T> View() { return TrajectoryView<T>(H, Theta, Tau, Time, Label, Position, nIterations); }
+
     /**@brief Summarises 
      * @param Traj An STrajectory
      * @param nToPrint Number of entries to print in trajectory vectors
@@ -168,8 +271,114 @@ struct STrajectory {
     size_t N;			   // Final size
 };
 
+/**@brief Trajectories of a batch of particles, each member stored as one contiguous
+ * particles x entries block of a single arena
+ *
+ * `Reset` grows the arena only when a batch needs more room than any before, so refilling it
+ * batch after batch allocates nothing. Row i is handed out as a `TrajectoryView`.
+ */
+template <typename T>
+class EnsembleTrajectory
+{
+    public:
+	EnsembleTrajectory() = default;
+	EnsembleTrajectory(const size_t& n, const size_t& N) { Reset(n, N); }
+
+	EnsembleTrajectory(const EnsembleTrajectory&) = delete;
+	EnsembleTrajectory& operator=(const EnsembleTrajectory&) = delete;
+	EnsembleTrajectory(EnsembleTrajectory&&) = default;
+	EnsembleTrajectory& operator=(EnsembleTrajectory&&) = default;
+
+	/**@brief Clears to `n` trajectories of `N` entries, each as a new `STrajectory(N)`
+	*/
+	void Reset(const size_t& n, const size_t& N) {
+	    rows = n;
+	    cols = N;
+	    const size_t cells = rows*cols;
+	    size_t bytes = 0;
+	    const size_t offsetH = Carve<T>(bytes, cells), offsetTheta = Carve<T>(bytes, cells);
+	    const size_t offsetTau = Carve<T>(bytes, cells), offsetTime = Carve<T>(bytes, cells);
+	    const size_t offsetLabel = Carve<int>(bytes, cells), offsetPosition = Carve<int_ll>(bytes, cells);
+	    if (bytes > capacity) {
+		arena = std::make_unique<std::byte[]>(bytes);
+		capacity = bytes;
+	    }
+	    H = Fill<T>(offsetH, cells, (T)0);
+	    Theta = Fill<T>(offsetTheta, cells, (T)0);
+	    Tau = Fill<T>(offsetTau, cells, (T)0);
+	    Time = Fill<T>(offsetTime, cells, (T)0);
+	    Label = Fill<int>(offsetLabel, cells, -1);
+	    Position = Fill<int_ll>(offsetPosition, cells, 0);
+	    nIterations.assign(rows, 0);
+	}
+
+	size_t size() const { return rows; }
+	size_t Entries() const { return cols; } // Entries per trajectory
+	size_t Capacity() const { return capacity; } // Bytes of the arena
+
+	/// Bytes of the arena per entry of a trajectory, besides alignment
+	static constexpr size_t BytesPerEntry() { return 4*sizeof(T) + sizeof(int) + sizeof(int_ll); }
+
+	/// Trajectory i
+	TrajectoryView<T> operator[](const size_t& i) {
+	    return TrajectoryView<T>(Row(H, i), Row(Theta, i), Row(Tau, i), Row(Time, i), Row(Label, i), Row(Position, i),
+				     nIterations[i]);
+	}
+
+	/**@brief Writes selected field members of every trajectory, one row each, as
+	* `STrajectory::WriteSelected` would trajectory by trajectory
+	* @param trajWriters Fixed array of writer objects 
+	*/
+	void WriteSelected(std::array<Writer,6>& trajWriters, const std::vector<size_t>& idx) const {
+	    const size_t cells = rows*cols;
+	    for (size_t i = 0; i < idx.size(); ++i) {
+		if (idx[i] == 0) { trajWriters[0].WriteRows<T>(std::span<const T>(H, cells), rows); }
+		else if (idx[i] == 1) { trajWriters[1].WriteRows<T>(std::span<const T>(Time, cells), rows); }
+		else if (idx[i] == 2) { trajWriters[2].WriteRows<T>(std::span<const T>(Theta, cells), rows); }
+		else if (idx[i] == 3) { trajWriters[3].WriteRows<int>(std::span<const int>(Label, cells), rows); }
+		else if (idx[i] == 4) { trajWriters[4].WriteRows<int_ll>(std::span<const int_ll>(Position, cells), rows); }
+		else { 
+		    std::vector<std::int64_t> codes(cells, -1);
+		    for (size_t r = 0; r < rows; ++r)
+			for (size_t k = r*cols; k < r*cols + nIterations[r]; ++k)
+			    codes[k] = getItineraryCode<T>(H[k], Theta[k], Label[k]);
+		    trajWriters[5].WriteRows<std::int64_t>(codes, rows);
+		}
+	    }
+	}
+
+	void Write(std::array<Writer,6>& trajWriters) const { WriteSelected(trajWriters, { 0, 1, 2, 3, 4, 5 }); }
+
+    private:
+	// Reserves an aligned block of `cells` values of U at the end of `bytes`, returning its offset
+	template <typename U>
+	static size_t Carve(size_t& bytes, const size_t& cells) {
+	    const size_t offset = (bytes + alignof(U) - 1)/alignof(U)*alignof(U);
+	    bytes = offset + cells*sizeof(U);
+	    return offset;
+	}
+
+	template <typename U>
+	U* Fill(const size_t& offset, const size_t& cells, const U& value) {
+	    U* p = reinterpret_cast<U*>(arena.get() + offset);
+	    std::uninitialized_fill_n(p, cells, value);
+	    return p;
+	}
+
+	template <typename U>
+	std::span<U> Row(U* block, const size_t& i) const { return std::span<U>(block + i*cols, cols); }
+
+	std::unique_ptr<std::byte[]> arena;
+	size_t capacity = 0;
+	size_t rows = 0, cols = 0;
+	T *H = nullptr, *Theta = nullptr, *Tau = nullptr, *Time = nullptr;
+	int* Label = nullptr;
+	int_ll* Position = nullptr;
+	std::vector<size_t> nIterations; // Entries recorded in each trajectory
+};
+
 /**@brief Gets writer objects for each field member
- * Main purpose is to reduce IOPS when looping
+ * Main purpose is to reduce IOPS when looping. Sharded runs write to the files of their shard
  */ 
 std::array<Writer,6> getTrajectoryWriters() {
     nlohmann::json jfiles = config::getJSONFiles();
@@ -177,7 +386,21 @@ std::array<Writer,6> getTrajectoryWriters() {
 					   jfiles["Positions"], jfiles["Itineraries"] };
     std::array<Writer,6> TrajWriters;
     for (size_t i = 0; i < TrajWriters.size(); ++i)
-	TrajWriters[i] = Writer(filenames[i]);
+	TrajWriters[i] = Writer(config::getShardName(filenames[i]));
+    return TrajWriters;
+}
+
+/**@brief Reopens the files of each field member to continue writing from `states`
+ *
+ * Overloaded function
+ */ 
+std::array<Writer,6> getTrajectoryWriters(const std::array<WriterState,6>& states) {
+    nlohmann::json jfiles = config::getJSONFiles();
+    std::array<std::string,6> filenames = { jfiles["H"], jfiles["Time"], jfiles["Theta"], jfiles["Labels"], 
+					   jfiles["Positions"], jfiles["Itineraries"] };
+    std::array<Writer,6> TrajWriters;
+    for (size_t i = 0; i < TrajWriters.size(); ++i)
+	TrajWriters[i] = Writer(config::getShardName(filenames[i]), states[i]);
     return TrajWriters;
 }
 
@@ -0,0 +1,166 @@
+/**
+ * @brief Counts of region-to-region transitions of an ensemble, accumulated during evolution
+ *
+ * For each lag k the dense matrix of counts of label(n) -> label(n+k) is kept, and optionally
+ * the joint counts with the position jump x(n+k) - x(n), which lies in [-k, k]. Each lag only
+ * stores its own 2k + 1 jumps. Accumulators of disjoint sets of particles are merged by adding
+ * their counts.
+ */
+
+#ifndef TRANSITIONS_H_INCLUDED
+#define TRANSITIONS_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "Particle.h"
+#include "Writer.h"
+
+struct TransitionCounts {
+
+    TransitionCounts() = default;
+
+    /**@brief Empty counts
+    * @param lags_ Lags k of the transitions label(n) -> label(n+k) counted
+    * @param jumps_ Also count the position jump of each transition
+    */
+    TransitionCounts(const std::vector<size_t>& lags_, const bool& jumps_ = false) : lags(lags_), jumps(jumps_) {
+	if (lags.empty() || std::ranges::find(lags, 0) != lags.end())
+	    throw std::invalid_argument("ERROR: Lags must be positive in @TransitionCounts().");
+	maxLag = std::ranges::max(lags);
+	offsets.assign(1, 0);
+	for (const auto& k : lags)
+	    offsets.push_back(offsets.back() + N_LABELS*N_LABELS*Width(k));
+	counts.assign(offsets.back(), 0);
+    }
+
+    /// Jumps counted per transition at lag k: [-k, k], or their total without jumps
+    size_t Width(const size_t& k) const { return jumps ? 2*k + 1 : 1; }
+
+    /// Index into `counts` of the transition i -> j at lag index l with jump dx
+    size_t Index(const size_t& l, const int& i, const int& j, const int_ll& dx = 0) const {
+	return offsets[l] + (i*N_LABELS + j)*Width(lags[l]) + (jumps ? dx + (int_ll)lags[l] : 0);
+    }
+
+    /// Count of transitions i -> j at lag index l, over all jumps
+    std::uint64_t Count(const size_t& l, const int& i, const int& j) const {
+	const auto first = counts.begin() + Index(l, i, j, -(int_ll)lags[l]*jumps);
+	return std::accumulate(first, first + Width(lags[l]), (std::uint64_t)0);
+    }
+
+    /// Count of transitions i -> j at lag index l with position jump dx
+    std::uint64_t Count(const size_t& l, const int& i, const int& j, const int_ll& dx) const {
+	if (!jumps)
+	    throw std::invalid_argument("ERROR: Jumps were not counted in @TransitionCounts::Count().");
+	return (std::abs(dx) > (int_ll)lags[l]) ? 0 : counts[Index(l, i, j, dx)];
+    }
+
+    /// Fraction of the transitions from i at lag index l that go to j
+    float_ Probability(const size_t& l, const int& i, const int& j) const {
+	std::uint64_t total = 0;
+	for (size_t k = 0; k < N_LABELS; ++k)
+	    total += Count(l, i, k);
+	return total ? (float_)Count(l, i, j)/total : 0;
+    }
+
+    /// Adds the counts of another accumulator with the same lags
+    void Merge(const TransitionCounts& other) {
+	if (other.lags != lags || other.jumps != jumps)
+	    throw std::invalid_argument("ERROR: Mismatched lags in @TransitionCounts::Merge().");
+	for (size_t i = 0; i < counts.size(); ++i)
+	    counts[i] += other.counts[i];
+    }
+
+    /**@brief Evolves a particle `nSteps` times, counting its transitions
+    *
+    * Counting stops if the particle reaches a state in no region.
+    * @param Map Scattering map
+    * @param SP Initial condition
+    * @param nSteps Number of iterations of the map
+    */
+    template <typename T, typename M>
+    void AddParticle(M& Map, const SParticle<T>& SP, const size_t& nSteps) {
+	T h = SP.H, theta = SP.Theta, tau = SP.Tau;
+	int_ll x = SP.Position;
+	int label = SP.Label;
+	if (label == -1) return;
+	// Labels and positions of the last maxLag + 1 iterates, by iterate modulo maxLag + 1
+	history.resize(maxLag + 1);
+	history[0] = { label, x };
+	for (size_t n = 1; n <= nSteps; ++n) {
+	    Map.Step(h, theta, tau, x, label);
+	    if (label == -1) return;
+	    history[n % (maxLag + 1)] = { label, x };
+	    for (size_t l = 0; l < lags.size(); ++l) {
+		if (lags[l] > n) continue;
+		const auto& [from, x0] = history[(n - lags[l]) % (maxLag + 1)];
+		if (jumps && std::abs(x - x0) > (int_ll)lags[l])
+		    throw std::runtime_error("ERROR: Position jump exceeds its lag in @TransitionCounts::AddParticle().");
+		counts[Index(l, from, label, x - x0)]++;
+	    }
+	}
+    }
+
+    /**@brief Writes the counts as JSON, with a 20x20 matrix per lag (and a 20x20x(2k+1) array
+    * of joint counts with the jump when counted)
+    */
+    void WriteJSON(const std::string& fname) const {
+	nlohmann::ordered_json j;
+	j["labels"] = N_LABELS;
+	j["lags"] = lags;
+	j["jumps"] = jumps;
+	for (size_t l = 0; l < lags.size(); ++l) {
+	    std::vector<std::vector<std::uint64_t>> matrix(N_LABELS, std::vector<std::uint64_t>(N_LABELS));
+	    for (size_t a = 0; a < N_LABELS; ++a)
+		for (size_t b = 0; b < N_LABELS; ++b)
+		    matrix[a][b] = Count(l, a, b);
+	    j["counts"][std::to_string(lags[l])] = matrix;
+	    if (!jumps) continue;
+	    const int_ll k = lags[l];
+	    std::vector<std::vector<std::vector<std::uint64_t>>> joint(N_LABELS,
+		std::vector<std::vector<std::uint64_t>>(N_LABELS, std::vector<std::uint64_t>(2*k + 1)));
+	    for (size_t a = 0; a < N_LABELS; ++a)
+		for (size_t b = 0; b < N_LABELS; ++b)
+		    for (int_ll dx = -k; dx <= k; ++dx)
+			joint[a][b][dx + k] = counts[Index(l, a, b, dx)];
+	    j["jump_counts"][std::to_string(lags[l])] = joint;
+	}
+	std::ofstream ofs(fname);
+	if (!ofs.is_open())
+	    throw std::runtime_error("ERROR: Could not open file: " + fname + ".");
+	ofs << j.dump();
+    }
+
+    /**@brief Writes the counts as a NumPy uint64 array of shape (lags*20*20, 2*maxLag + 1), or
+    * (lags*20*20, 1) without jumps, to be reshaped to (lags, 20, 20, -1). Column dx + maxLag
+    * holds jump dx, zero beyond the lag
+    */
+    void WriteNPY(const std::string& fname) const {
+	Writer W(fname);
+	std::vector<std::uint64_t> row(Width(maxLag));
+	for (size_t l = 0; l < lags.size(); ++l) {
+	    const size_t w = Width(lags[l]), pad = (row.size() - w)/2;
+	    for (size_t r = offsets[l]; r < offsets[l+1]; r += w) {
+		std::ranges::copy(counts.begin() + r, counts.begin() + r + w, row.begin() + pad);
+		W.WriteRowVector<std::uint64_t>(row);
+	    }
+	}
+    }
+
+    std::vector<size_t> lags;
+    bool jumps = false;
+    size_t maxLag = 0;
+    std::vector<size_t> offsets;       // Start of the counts of lag index l in `counts`
+    std::vector<std::uint64_t> counts; // Transition i -> j at lag index l with jump dx at Index(l,i,j,dx)
+
+private:
+    std::vector<std::pair<int, int_ll>> history;
+};
+
+#endif
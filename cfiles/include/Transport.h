@@ -0,0 +1,209 @@
+/**
+ * @brief Streaming transport statistics of an ensemble: moments of the displacement and the
+ * diffusion coefficient
+ *
+ * Particles are evolved one at a time and their displacements x - x0 added to power sums at
+ * each point of a grid of iterates or times, so no trajectory is stored or written.
+ * Accumulators of disjoint sets of particles are merged by adding their sums.
+ */
+
+#ifndef TRANSPORT_H_INCLUDED
+#define TRANSPORT_H_INCLUDED
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "Particle.h"
+
+constexpr size_t TRANSPORT_MOMENTS = 4; // Moments <(x-x0)^k>, k = 1...TRANSPORT_MOMENTS, reported
+
+struct TransportStatistics {
+
+    TransportStatistics() = default;
+
+    /// Statistics at the given iterates of the map
+    TransportStatistics(const std::vector<size_t>& iterates) :
+	grid(iterates.begin(), iterates.end()), inTime(false) { Resize(); }
+
+    /// Statistics at the given times
+    TransportStatistics(const std::vector<float_>& times) : grid(times), inTime(true) { Resize(); }
+
+    /// Adds the displacement `dx` of one particle at grid point `g`, reached at time `t`
+    void Add(const size_t& g, const float_& dx, const float_& t) {
+	count[g]++;
+	float_wide p = 1;
+	for (auto& s : sums[g]) {
+	    p *= dx;
+	    s += p;
+	}
+	timeSums[g] += t;
+    }
+
+    /// Adds the particles of another accumulator over the same grid
+    void Merge(const TransportStatistics& other) {
+	if (other.grid != grid || other.inTime != inTime)
+	    throw std::invalid_argument("ERROR: Mismatched grids in @TransportStatistics::Merge().");
+	for (size_t g = 0; g < grid.size(); ++g) {
+	    count[g] += other.count[g];
+	    for (size_t p = 0; p < sums[g].size(); ++p)
+		sums[g][p] += other.sums[g][p];
+	    timeSums[g] += other.timeSums[g];
+	}
+    }
+
+    /**@brief Evolves a particle through the grid, adding its displacements
+    *
+    * On a grid of times, the displacement at time t is that of the last collision before t.
+    * A particle that reaches a state in no region is not counted at later grid points.
+    * @param Map Scattering map
+    * @param SP Initial condition
+    */
+    template <typename T, typename M>
+    void AddParticle(M& Map, const SParticle<T>& SP) {
+	T h = SP.H, theta = SP.Theta, tau = SP.Tau;
+	int_ll x = SP.Position;
+	int label = SP.Label;
+	const int_ll x0 = x;
+	float_ clock = 0; // Time of the last collision
+	if (!inTime) {
+	    size_t n = 0;
+	    for (size_t g = 0; g < grid.size(); ++g) {
+		for (; n < (size_t)grid[g] && label != -1; ++n) {
+		    Map.Step(h, theta, tau, x, label);
+		    clock += tau;
+		}
+		if (n < (size_t)grid[g])
+		    return;
+		Add(g, x - x0, clock);
+	    }
+	} else {
+	    for (size_t g = 0; g < grid.size() && label != -1; ) {
+		const int_ll xPrev = x;
+		Map.Step(h, theta, tau, x, label);
+		const float_ next = clock + tau;
+		for (; g < grid.size() && grid[g] < next; ++g)
+		    Add(g, xPrev - x0, grid[g]);
+		clock = next;
+	    }
+	}
+    }
+
+    size_t size() const { return grid.size(); }
+
+    /// <(x-x0)^k> at grid point g
+    float_ Moment(const size_t& g, const size_t& k) const {
+	return count[g] ? (float_)(sums[g][k-1]/count[g]) : std::numeric_limits<float_>::quiet_NaN();
+    }
+
+    /// Standard error of `Moment(g,k)`
+    float_ MomentError(const size_t& g, const size_t& k) const {
+	if (count[g] < 2)
+	    return std::numeric_limits<float_>::quiet_NaN();
+	const float_wide m = sums[g][k-1]/count[g], m2 = sums[g][2*k-1]/count[g];
+	return std::sqrt((float_)std::max(m2 - m*m, (float_wide)0)/(count[g] - 1));
+    }
+
+    /// Mean time of the particles at grid point g. Equal to the grid point on a grid of times
+    float_ MeanTime(const size_t& g) const {
+	return count[g] ? (float_)(timeSums[g]/count[g]) : std::numeric_limits<float_>::quiet_NaN();
+    }
+
+    /// <(x-x0)^2> - <x-x0>^2 at grid point g
+    float_ Variance(const size_t& g) const {
+	if (!count[g])
+	    return std::numeric_limits<float_>::quiet_NaN();
+	const float_wide m = sums[g][0]/count[g];
+	return (float_)(sums[g][1]/count[g] - m*m);
+    }
+
+    /**@brief Diffusion coefficient D and its standard error, from a least squares fit of
+    * Variance = 2Dt + c over the second half of the grid
+    */
+    std::pair<float_, float_> Diffusion() const {
+	std::vector<float_> t, v;
+	for (size_t g = size()/2; g < size(); ++g) {
+	    if (count[g] < 2) continue;
+	    t.push_back(MeanTime(g));
+	    v.push_back(Variance(g));
+	}
+	const size_t m = t.size();
+	if (m < 2)
+	    return { std::numeric_limits<float_>::quiet_NaN(), std::numeric_limits<float_>::quiet_NaN() };
+	float_ tMean = 0, vMean = 0;
+	for (size_t i = 0; i < m; ++i) {
+	    tMean += t[i]/m;
+	    vMean += v[i]/m;
+	}
+	float_ Stt = 0, Stv = 0;
+	for (size_t i = 0; i < m; ++i) {
+	    Stt += (t[i] - tMean)*(t[i] - tMean);
+	    Stv += (t[i] - tMean)*(v[i] - vMean);
+	}
+	const float_ slope = Stv/Stt;
+	if (m < 3)
+	    return { slope/2, std::numeric_limits<float_>::quiet_NaN() };
+	float_ Sres = 0;
+	for (size_t i = 0; i < m; ++i) {
+	    const float_ r = v[i] - vMean - slope*(t[i] - tMean);
+	    Sres += r*r;
+	}
+	return { slope/2, std::sqrt(Sres/(m - 2)/Stt)/2 };
+    }
+
+    void Print() const {
+	const auto [D, error] = Diffusion();
+	std::cout << "Transport of " << (size() ? count[0] : 0) << " particles over " << size() << (inTime ? " times" : " iterates")
+		  << ": D = " << D << " +- " << error << "\n";
+    }
+
+    void WriteJSON(const std::string& fname) const {
+	nlohmann::ordered_json j;
+	j["grid"] = inTime ? "times" : "iterates";
+	j["points"] = grid;
+	j["particles"] = count;
+	std::vector<float_> times(size()), variance(size());
+	for (size_t g = 0; g < size(); ++g) {
+	    times[g] = MeanTime(g);
+	    variance[g] = Variance(g);
+	}
+	j["mean_time"] = times;
+	for (size_t k = 1; k <= TRANSPORT_MOMENTS; ++k) {
+	    std::vector<float_> moment(size()), error(size());
+	    for (size_t g = 0; g < size(); ++g) {
+		moment[g] = Moment(g, k);
+		error[g] = MomentError(g, k);
+	    }
+	    j["moments"][std::to_string(k)] = moment;
+	    j["moment_errors"][std::to_string(k)] = error;
+	}
+	j["variance"] = variance;
+	const auto [D, error] = Diffusion();
+	j["diffusion"] = { { "D", D }, { "error", error } };
+	std::ofstream ofs(fname);
+	if (!ofs.is_open())
+	    throw std::runtime_error("ERROR: Could not open file: " + fname + ".");
+	ofs << j.dump(4);
+    }
+
+    std::vector<float_> grid;	 // Iterates or times, ascending
+    bool inTime = false;
+    std::vector<size_t> count;	 // Particles counted at each grid point
+    std::vector<std::array<float_wide, 2*TRANSPORT_MOMENTS>> sums; // sums[g][p] = sum of (x-x0)^(p+1)
+    std::vector<float_wide> timeSums;
+
+private:
+    void Resize() {
+	if (!std::ranges::is_sorted(grid))
+	    throw std::invalid_argument("ERROR: Grid must be ascending in @TransportStatistics().");
+	count.assign(grid.size(), 0);
+	sums.assign(grid.size(), {});
+	timeSums.assign(grid.size(), 0);
+    }
+};
+
+#endif
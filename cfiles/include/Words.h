@@ -0,0 +1,238 @@
+/**
+ * @brief Streaming symbolic dynamics of an ensemble: counts of the words of region labels of
+ * length k = 1...K, accumulated during evolution, and the entropies estimated from them
+ *
+ * The alphabet is that of `config::all_itineraries`, one letter per region label. A word of
+ * length k is coded as the base-N_LABELS number of its labels, first label most significant,
+ * and counted in a hash table per length. Accumulators of disjoint sets of particles are merged
+ * by adding their counts. Words never seen are "forbidden" in the sense of the sample only.
+ */
+
+#ifndef WORDS_H_INCLUDED
+#define WORDS_H_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "config.h"
+#include "Particle.h"
+#include "Writer.h"
+
+constexpr size_t WORDS_MAX_LENGTH = 14; // Longest word counted, as N_LABELS^14 < 2^64
+
+struct WordStatistics {
+
+    WordStatistics() = default;
+
+    /**@brief Empty counts
+    * @param maxLength_ Longest word counted
+    */
+    WordStatistics(const size_t& maxLength_) : maxLength(maxLength_), counts(maxLength_) {
+	if (maxLength == 0 || maxLength > WORDS_MAX_LENGTH)
+	    throw std::invalid_argument("ERROR: Word length must be in [1, " + std::to_string(WORDS_MAX_LENGTH)
+					+ "] in @WordStatistics().");
+	powers.resize(maxLength + 1, 1);
+	for (size_t k = 1; k <= maxLength; ++k)
+	    powers[k] = powers[k-1]*N_LABELS;
+    }
+
+    /// Labels of the word of length k with code `word`
+    static std::vector<int> Decode(std::uint64_t word, const size_t& k) {
+	std::vector<int> labels(k);
+	for (size_t i = k; i-- > 0; word /= N_LABELS)
+	    labels[i] = word % N_LABELS;
+	return labels;
+    }
+
+    /// Word of length k with code `word`, e.g. "4-17-3"
+    static std::string toString(const std::uint64_t& word, const size_t& k) {
+	std::string s;
+	for (const auto& label : Decode(word, k)) {
+	    if (!s.empty())
+		s += "-";
+	    s += std::to_string(label);
+	}
+	return s;
+    }
+
+    /// Count of the word of length k with code `word`
+    std::uint64_t Count(const size_t& k, const std::uint64_t& word) const {
+	const auto it = counts[k-1].find(word);
+	return it == counts[k-1].end() ? 0 : it->second;
+    }
+
+    /// Number of distinct words of length k seen
+    size_t Words(const size_t& k) const { return counts[k-1].size(); }
+
+    /// Number of words of length k counted
+    std::uint64_t Total(const size_t& k) const {
+	std::uint64_t total = 0;
+	for (const auto& [word, c] : counts[k-1])
+	    total += c;
+	return total;
+    }
+
+    /// Block entropy H_k = -sum p(w) log p(w) over words w of length k, in nats
+    float_ BlockEntropy(const size_t& k) const {
+	const std::uint64_t total = Total(k);
+	if (total == 0) return 0;
+	float_wide sum = 0;
+	for (const auto& [word, c] : counts[k-1])
+	    sum += c*std::log((float_wide)c);
+	return std::log((float_wide)total) - sum/total;
+    }
+
+    /// Entropy rate estimate H_k - H_{k-1} (H_0 = 0)
+    float_ EntropyRate(const size_t& k) const { return BlockEntropy(k) - (k > 1 ? BlockEntropy(k-1) : 0); }
+
+    /// Topological entropy estimate log(N_k/N_{k-1}) from the numbers of distinct words (N_0 = 1)
+    float_ TopologicalEntropy(const size_t& k) const {
+	const size_t previous = k > 1 ? Words(k-1) : 1;
+	return (Words(k) && previous) ? std::log((float_)Words(k)/previous) : 0;
+    }
+
+    /**@brief Minimal forbidden words of length k >= 2: words a..b not seen whose prefix a.. and
+    * suffix ..b of length k-1 were both seen
+    * @return Sorted codes of the words
+    */
+    std::vector<std::uint64_t> ForbiddenWords(const size_t& k) const {
+	std::vector<std::uint64_t> forbidden;
+	if (k < 2) return forbidden;
+	for (const auto& [prefix, c] : counts[k-2]) {
+	    for (std::uint64_t b = 0; b < N_LABELS; ++b) {
+		const std::uint64_t word = prefix*N_LABELS + b;
+		if (counts[k-2].contains(word % powers[k-1]) && !counts[k-1].contains(word))
+		    forbidden.push_back(word);
+	    }
+	}
+	std::ranges::sort(forbidden);
+	return forbidden;
+    }
+
+    /// Adds the counts of another accumulator with the same longest word
+    void Merge(const WordStatistics& other) {
+	if (other.maxLength != maxLength)
+	    throw std::invalid_argument("ERROR: Mismatched word lengths in @WordStatistics::Merge().");
+	for (size_t k = 0; k < maxLength; ++k)
+	    for (const auto& [word, c] : other.counts[k])
+		counts[k][word] += c;
+    }
+
+    /**@brief Counts the words of a sequence of labels, up to its first label -1
+    */
+    void AddSequence(const std::vector<int>& labels) {
+	std::uint64_t code = 0;
+	size_t n = 0;
+	for (const auto& label : labels) {
+	    if (label == -1) return;
+	    Push(label, code, n);
+	}
+    }
+
+    /**@brief Evolves a particle `nSteps` times, counting the words of its labels
+    *
+    * Counting stops if the particle reaches a state in no region.
+    * @param Map Scattering map
+    * @param SP Initial condition
+    * @param nSteps Number of iterations of the map
+    */
+    template <typename T, typename M>
+    void AddParticle(M& Map, const SParticle<T>& SP, const size_t& nSteps) {
+	T h = SP.H, theta = SP.Theta, tau = SP.Tau;
+	int_ll x = SP.Position;
+	int label = SP.Label;
+	if (label == -1) return;
+	std::uint64_t code = 0;
+	size_t n = 0;
+	Push(label, code, n);
+	for (size_t s = 1; s <= nSteps; ++s) {
+	    Map.Step(h, theta, tau, x, label);
+	    if (label == -1) return;
+	    Push(label, code, n);
+	}
+    }
+
+    void Print() const {
+	std::cout << Words(maxLength) << " words of length " << maxLength << " seen: entropy rate " << EntropyRate(maxLength)
+		  << ", topological entropy " << TopologicalEntropy(maxLength) << "\n";
+    }
+
+    /**@brief Writes the entropies, the minimal forbidden words and the counts of every word seen
+    * as JSON. Words are written as their labels, e.g. "4-17-3"
+    */
+    void WriteJSON(const std::string& fname) const {
+	nlohmann::ordered_json j;
+	j["labels"] = N_LABELS;
+	j["alphabet"] = config::itineraries;
+	j["max_length"] = maxLength;
+	std::vector<size_t> words(maxLength);
+	std::vector<std::uint64_t> totals(maxLength);
+	std::vector<float_> entropy(maxLength), rate(maxLength), topological(maxLength);
+	for (size_t k = 1; k <= maxLength; ++k) {
+	    words[k-1] = Words(k);
+	    totals[k-1] = Total(k);
+	    entropy[k-1] = BlockEntropy(k);
+	    rate[k-1] = EntropyRate(k);
+	    topological[k-1] = TopologicalEntropy(k);
+	}
+	j["words"] = words;
+	j["total"] = totals;
+	j["block_entropy"] = entropy;
+	j["entropy_rate"] = rate;
+	j["topological_entropy"] = topological;
+	for (size_t k = 2; k <= maxLength; ++k) {
+	    std::vector<std::string> forbidden;
+	    for (const auto& word : ForbiddenWords(k))
+		forbidden.push_back(toString(word, k));
+	    j["forbidden"][std::to_string(k)] = forbidden;
+	}
+	for (size_t k = 1; k <= maxLength; ++k) {
+	    nlohmann::ordered_json c = nlohmann::ordered_json::object();
+	    for (const auto& [word, count] : Sorted(k))
+		c[toString(word, k)] = count;
+	    j["counts"][std::to_string(k)] = c;
+	}
+	std::ofstream ofs(fname);
+	if (!ofs.is_open())
+	    throw std::runtime_error("ERROR: Could not open file: " + fname + ".");
+	ofs << j.dump();
+    }
+
+    /**@brief Writes the counts as a NumPy uint64 array with a row (k, code, count) per word seen,
+    * by length and then code
+    */
+    void WriteNPY(const std::string& fname) const {
+	Writer W(fname);
+	for (size_t k = 1; k <= maxLength; ++k)
+	    for (const auto& [word, count] : Sorted(k))
+		W.WriteRowVector<std::uint64_t>(std::vector<std::uint64_t>{ k, word, count });
+    }
+
+    size_t maxLength = 0;
+    std::vector<std::unordered_map<std::uint64_t, std::uint64_t>> counts; // Count of each word of length k in counts[k-1]
+
+private:
+    /// Appends a label to the last `maxLength` labels `code`, after n labels, and counts the words ending with it
+    void Push(const int& label, std::uint64_t& code, size_t& n) {
+	code = (code % powers[maxLength-1])*N_LABELS + label;
+	n = std::min(n + 1, maxLength);
+	for (size_t k = 1; k <= n; ++k)
+	    counts[k-1][code % powers[k]]++;
+    }
+
+    /// Words of length k and their counts, by code
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> Sorted(const size_t& k) const {
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> sorted(counts[k-1].begin(), counts[k-1].end());
+	std::ranges::sort(sorted);
+	return sorted;
+    }
+
+    std::vector<std::uint64_t> powers; // N_LABELS^k, k = 0...maxLength
+};
+
+#endif
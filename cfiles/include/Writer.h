@@ -1,10 +1,58 @@
 #ifndef WRITER_H_INCLUDED
 #define WRITER_H_INCLUDED
 
+#include <bit>
+#include <cstdint>
+#include <filesystem>
 #include <iomanip>
 #include <fstream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Codec.h"
+
+/// Bytes reserved for the header of .npy files, patched with the final shape on close
+constexpr size_t NPY_HEADER_SIZE = 128;
+
+/**@brief NumPy type string of `T`, e.g. '<f8' for double
+*/
+template <typename T>
+std::string npyDescr() {
+    static_assert(std::endian::native == std::endian::little, "NumPy output assumes a little-endian host.");
+    if constexpr (std::is_floating_point_v<T> && (sizeof(T) == 4 || sizeof(T) == 8)) 
+	return "<f" + std::to_string(sizeof(T));
+    else if constexpr (std::is_integral_v<T>) 
+	return (std::is_signed_v<T> ? "<i" : "<u") + std::to_string(sizeof(T));
+    else
+	throw std::invalid_argument("ERROR: Type has no NumPy equivalent in @npyDescr().");
+}
+
+/**@brief Header of a C-ordered 2D NumPy array of `rows` x `cols` elements of type `descr`,
+ * padded to NPY_HEADER_SIZE
+*/
+inline std::string npyHeader(const std::string& descr, const size_t& rows, const size_t& cols) {
+    std::string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (" 
+		     + std::to_string(rows) + ", " + std::to_string(cols) + "), }";
+    dict.resize(NPY_HEADER_SIZE - 11, ' ');
+    dict += '\n';
+    const unsigned short len = dict.size();
+    return std::string("\x93NUMPY\x01\x00", 8) + (char)(len & 0xFF) + (char)(len >> 8) + dict;
+}
+
+/**@brief Position of a `Writer` in its file, from which writing resumes (see `Checkpoint.h`)
+*/
+struct WriterState {
+    std::uint64_t bytes = 0;	      // Bytes written
+    std::uint64_t rows = 0, cols = 0; // Shape of .npy files
+    std::string descr;		      // NumPy type of .npy files
+};
 
 /*@brief Minimal wrapper class for writing data 
+ *
+ * Files ending in .npy are written as a NumPy 2D array (one row per call to `WriteRowVector`)
+ * of raw little-endian data. Files ending in .rle, .delta or .dod are written with the 
+ * corresponding encoding in `Codec.h`. Every other file is written as plain text.
 */ 
 class Writer
 {
@@ -12,48 +60,195 @@ class Writer
 	std::ofstream WriteStream;
 	std::string filename; // should include full path
 	bool append;	      // append to file
+	bool npy = false;     // NumPy binary format
+	bool encoded = false; // Compressed with `codec`
+	Codec codec;
+	std::string descr;    // NumPy type of the rows written so far
+	size_t rows = 0, cols = 0;
+
+	// Header of the rows written so far
+	std::string NPYHeader() const {
+	    return npyHeader(descr.empty() ? npyDescr<double>() : descr, rows, cols);
+	}
+
+	// Checks a row of n values against the shape and type of the rows already written
+	template <typename T>
+	void CheckNPYRow(const size_t& n) {
+	    if (rows == 0) {
+		descr = npyDescr<T>();
+		cols = n;
+	    } else if (n != cols || descr != npyDescr<T>()) {
+		throw std::invalid_argument("ERROR: Rows of " + filename + " must have the same length and type.");
+	    }
+	}
 
     public:
 	Writer() = default;
         Writer(const std::string& fname) : filename(fname)
         {
 	    append = false;
-	    WriteStream.open(filename.c_str(), std::ios::out);
+	    npy = filename.ends_with(".npy");
+	    encoded = getCodec(filename, codec);
+	    WriteStream.open(filename.c_str(), (npy || encoded) ? std::ios::out | std::ios::binary : std::ios::out);
 	    if (!WriteStream.is_open()) 
 		throw std::runtime_error("ERROR: Could not open file: " + filename + 
 					 ". Check that the directory exists.");
 	    //WriteStream << std::setprecision(std::numeric_limits<T>::digits10) << std::showpoint;
+	    if (npy) 
+		WriteStream << NPYHeader();
+	    if (encoded)
+		WriteStream << CodecHeader(codec);
 	    setStreamPrecision<double>();
         }
 
         Writer(const std::string& fname, const bool& app) : filename(fname), append(app)
         {
+	    npy = filename.ends_with(".npy");
+	    encoded = getCodec(filename, codec);
+	    if ((npy || encoded) && append)
+		throw std::invalid_argument("ERROR: Cannot append to " + filename + ".");
 	    if (append)
 		WriteStream.open(filename.c_str(), std::ios::out | std::ios::app);
 	    else                                             
-		WriteStream.open(filename.c_str(), std::ios::out);
+		WriteStream.open(filename.c_str(), (npy || encoded) ? std::ios::out | std::ios::binary : std::ios::out);
 
 	    if (!WriteStream.is_open()) 
 		throw std::runtime_error("ERROR: Could not open file: " + filename + 
 					 ". Check that the directory exists.");
+	    if (npy) 
+		WriteStream << NPYHeader();
+	    if (encoded)
+		WriteStream << CodecHeader(codec);
 	    setStreamPrecision<double>();
         }
 
+	/**@brief Reopens a file to continue writing from `state`, truncating anything written after it
+	*/
+	Writer(const std::string& fname, const WriterState& state) : filename(fname)
+	{
+	    append = false;
+	    npy = filename.ends_with(".npy");
+	    encoded = getCodec(filename, codec);
+	    descr = state.descr;
+	    rows = state.rows;
+	    cols = state.cols;
+	    if (!std::filesystem::exists(filename) || std::filesystem::file_size(filename) < state.bytes)
+		throw std::runtime_error("ERROR: " + filename + " is shorter than its checkpoint.");
+	    std::filesystem::resize_file(filename, state.bytes);
+	    WriteStream.open(filename.c_str(), (npy || encoded) ? std::ios::in | std::ios::out | std::ios::binary 
+							       : std::ios::in | std::ios::out);
+	    if (!WriteStream.is_open()) 
+		throw std::runtime_error("ERROR: Could not open file: " + filename + ".");
+	    WriteStream.seekp(0, std::ios::end);
+	    setStreamPrecision<double>();
+	}
+
+	Writer(const Writer&) = delete;
+	Writer& operator=(const Writer&) = delete;
+	Writer(Writer&& other) = default;
+
+	Writer& operator=(Writer&& other) {
+	    if (this != &other) {
+		Close();
+		WriteStream = std::move(other.WriteStream);
+		filename = std::move(other.filename);
+		append = other.append;
+		npy = other.npy;
+		encoded = other.encoded;
+		codec = other.codec;
+		descr = std::move(other.descr);
+		rows = other.rows;
+		cols = other.cols;
+	    }
+	    return *this;
+	}
+
+	~Writer() { Close(); }
+
+	/// Patches the header of .npy files with the number of rows written, then closes
+	void Close() {
+	    if (!WriteStream.is_open()) return;
+	    if (npy) {
+		WriteStream.seekp(0);
+		WriteStream << NPYHeader();
+	    }
+	    WriteStream.close();
+	}
+
+	/// Flushes the file, with the header of .npy files patched, and returns the position to resume from
+	WriterState State() {
+	    if (npy) {
+		const auto end = WriteStream.tellp();
+		WriteStream.seekp(0);
+		WriteStream << NPYHeader();
+		WriteStream.seekp(end);
+	    }
+	    WriteStream.flush();
+	    if (!WriteStream)
+		throw std::runtime_error("ERROR: Could not write to file: " + filename + ".");
+	    return { (std::uint64_t)WriteStream.tellp(), rows, cols, descr };
+	}
+
 	template <typename T>
 	void setStreamPrecision() {
 	    WriteStream << std::setprecision(std::numeric_limits<T>::digits10) << std::showpoint;
 	}
 
 	template <typename T>
-	void WriteRowVector(const std::vector<T>& v) {
+	void WriteRowVector(std::span<const T> v) {
+	    if (npy) {
+		CheckNPYRow<T>(v.size());
+		WriteStream.write(reinterpret_cast<const char*>(v.data()), v.size()*sizeof(T));
+		rows++;
+		return;
+	    }
+	    if (encoded) {
+		if constexpr (std::is_arithmetic_v<T>) {
+		    const std::string bytes = Encode<T>(codec, v);
+		    std::string frame;
+		    putVarint(frame, v.size());
+		    putVarint(frame, bytes.size());
+		    WriteStream << frame << bytes;
+		    return;
+		} else {
+		    throw std::invalid_argument("ERROR: Only numeric rows can be encoded in " + filename + ".");
+		}
+	    }
+	    if (v.empty()) { // e.g. a region with no points in this shard
+		WriteStream << std::endl;
+		return;
+	    }
 	    for (size_t i = 0; i < v.size()-1; ++i)
 		WriteStream << v[i] << " ";
 	    WriteStream << v.back() << std::endl;
 	}
 
+	template <typename T>
+	void WriteRowVector(const std::vector<T>& v) { WriteRowVector<T>(std::span<const T>(v)); }
+
+	/**@brief Writes `v` as `nRows` rows of equal length, as that many calls to `WriteRowVector`
+	* would. NumPy files take the whole block in one write
+	*/
+	template <typename T>
+	void WriteRows(std::span<const T> v, const size_t& nRows) {
+	    const size_t n = nRows ? v.size()/nRows : 0;
+	    if (nRows*n != v.size())
+		throw std::invalid_argument("ERROR: Rows of " + filename + " must have the same length.");
+	    if (npy && nRows) {
+		CheckNPYRow<T>(n);
+		WriteStream.write(reinterpret_cast<const char*>(v.data()), v.size()*sizeof(T));
+		rows += nRows;
+		return;
+	    }
+	    for (size_t r = 0; r < nRows; ++r)
+		WriteRowVector<T>(v.subspan(r*n, n));
+	}
+
 	// TODO: Handrails
 	template <typename... Vectors>
 	void WriteVectorsByRow(const Vectors&... v) {
+	    if (npy || encoded) 
+		throw std::invalid_argument("ERROR: Only `WriteRowVector` supports binary files.");
 	    ([&]
     	    {
 	        for (const auto& elem: v) {
@@ -66,6 +261,8 @@ class Writer
 	// TODO: Handrails. Vectors must be same size
 	template <typename... Vectors>
 	void WriteVectorsByCol(const Vectors&... v) {
+	    if (npy || encoded) 
+		throw std::invalid_argument("ERROR: Only `WriteRowVector` supports binary files.");
     	    const size_t size = std::get<0>(std::forward_as_tuple(v...)).size();
 	    constexpr size_t pack_size = sizeof...(v);
     	    for (size_t i = 0; i < size; ++i) {
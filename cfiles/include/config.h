@@ -9,9 +9,12 @@
 
 #include <boost/math/constants/constants.hpp>
 #include <vector>
+#include <iostream>
 #include <sstream>
 #include <fstream>
 #include <filesystem>
+#include <thread>
+#include <random>
 #include "json.hpp" // https://github.com/nlohmann/json
 //#include <boost/multiprecision/cpp_dec_float.hpp>
 //#include <boost/multiprecision/cpp_int.hpp>
@@ -19,9 +22,13 @@
 
 //typedef float_50 float_;
 using float_ = double;
+using float_wide = long double; /// Precision in which steps too close to a boundary for float_ are re-evaluated
 using int_ll = std::int32_t;
 using cid_int = std::uint32_t;
 
+/// How region labels are computed in the map and the samplers
+enum class RegionClassifier { Exact, Index, Tangent, Validate, Adaptive };
+
 /// Ubiquitous consts
 constexpr float_ EPSILON = std::numeric_limits<float_>::epsilon();
 constexpr float_ PI = boost::math::constants::pi<float_>();
@@ -30,6 +37,8 @@ constexpr float_ PI2 = boost::math::constants::half_pi<float_>();
 constexpr float_ DELTA = boost::math::constants::half<float_>(); 
 constexpr float_ DX = DELTA; // \delta_x 
 constexpr float_ DX2 = 1; 
+/// Labels 0...19 of every width
+constexpr size_t N_LABELS = 20;
 
 namespace config {
 
@@ -44,6 +53,13 @@ namespace config {
 					{ "L0L", "", "", "", "L04R", "L043R", "L0431R", "", "L0430L", 
 					  "L0340L", "L034L", "L03L", "L31R", "L30L", "L3L", "L34L", 
 					  "L43L", "L430L", "L431L", "LR" }};
+    // Whether the particle carries on in its direction of travel ("R") or turns back ("L") after each region,
+    // as used to lift positions from labels. The bouncing itineraries 1, 12 and 18 of d = 1/2, 12 and 18 of
+    // d = 1 and the right exit 19 carry on
+    const std::vector<std::vector<std::string>> all_lastChars = {{ "L", "R", "R", "R", "R", "R", "R", "R", "L", "L", 
+								  "L", "L", "R", "L", "L", "L", "L", "L", "R", "R" },
+								{ "L", "", "", "", "R", "R", "R", "", "L", "L", 
+								  "L", "L", "R", "L", "L", "L", "L", "L", "R", "R" }};
     // Labelling convention for regions. TODO: refactor coordinatespace.h
     const std::vector<std::vector<int>> all_labels = {{ 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18 },
 						      { 0,4,5,6,8,9,10,11,12,13,14,15,16,17,18,19 }};
@@ -66,21 +82,39 @@ namespace config {
     const std::string FILE_THETA        = "Theta.dat";
     const std::string FILE_LABELS       = "Labels.dat";
     const std::string FILE_POSITIONS    = "Positions.dat";
-    const std::string FILE_ITINERARIES  = "Itineraries.dat";
+    const std::string FILE_ITINERARIES  = "Itineraries.dat";   // Itinerary codes (getItineraryCode in SMapHelper.h)
     const std::string FILE_REGION_H     = "Regions-H.dat";     // Hoizontal cspace coords
     const std::string FILE_REGION_THETA = "Regions-Theta.dat"; // Vertical cspace coords
+    const std::string FILE_LABEL_INDEX  = "LabelIndex.bin";    // Cache of LabelIndex.h
+    const std::string FILE_SHADOW       = "Shadow.json";       // Report of Shadow.h
+    const std::string FILE_TRANSPORT    = "Transport.json";    // Summary of Transport.h
+    const std::string FILE_TRANSITIONS  = "Transitions.json";  // Counts of Transitions.h (also .npy with --format npy or packed)
+    const std::string FILE_WORDS        = "Words.json";        // Word statistics of Words.h (also .npy with --format npy or packed)
+    const std::string FILE_CHECKPOINT   = "Checkpoint.bin";    // Progress of an unfinished trajectory run (Checkpoint.h)
+    const std::string FILE_SNAPSHOTS    = "Snapshots-";        // Prefix of the files of Snapshot.h, e.g. Snapshots-Positions.dat
     
     /// ================= CONFIGURABLE VARIABLES ========================
     size_t widthSelection = 0; /// Default parameter selection is d = 1/2 
     size_t angleSelection = 0; /// and alpha = pi/2
     size_t studyID = widthSelection*channel_angles.size()+angleSelection;
     std::vector<std::string> itineraries = all_itineraries[widthSelection];
+    std::vector<std::string> lastChars = all_lastChars[widthSelection];
     std::vector<int> regionLabels = all_labels[widthSelection];
     std::vector<float_> regionAreas = all_areas[widthSelection];
     float_ d = channel_widths[widthSelection];
     float_ alpha = channel_angles[angleSelection];
     std::string Study = STUDY_PREFIX + std::to_string(studyID); 
     std::string DataPath = BaseDataPath + Study + "/";	
+    size_t nThreads = std::max(std::thread::hardware_concurrency(), 1u); /// Threads used by production drivers
+    std::uint64_t seed = ((std::uint64_t)std::random_device{}() << 32) | std::random_device{}(); /// Run seed of all random streams
+    std::string outputFormat = "text"; /// "text", "npy" or "packed". Set before initialise() so that config.json lists the right files
+    RegionClassifier classifier = RegionClassifier::Exact; /// `whichRegion`, the index of LabelIndex.h, `whichRegionTangent`, all three checked against each other, or `whichRegionAdaptive`
+    size_t shadowParticles = 0; /// Particles per call shadowed in float_ by drivers running in a lower precision
+    double checkpointSeconds = 0; /// Wall-clock seconds between checkpoints of trajectory drivers (0 = none)
+    bool resume = false; /// Trajectory drivers continue from the study's checkpoint. Cleared by the run resumed
+    size_t trajectoryRun = 0; /// Trajectory runs opened by this process, one per call of a trajectory driver
+    size_t shardIndex = 0, shardCount = 1; /// This process writes shard `shardIndex` of `shardCount` of each run (Shards.h)
+    bool fastForward = false; /// Trajectories skip whole periods of exactly periodic orbits (Cycle.h)
     /// ==================================================================
     
     void writeJSONConfig();
@@ -102,6 +136,7 @@ namespace config {
 	alpha = channel_angles[angleSelection];
 	regionLabels = all_labels[widthSelection];
 	itineraries = all_itineraries[widthSelection];
+	lastChars = all_lastChars[widthSelection];
 	regionAreas = all_areas[widthSelection];
 	
 	// Study id is an integer parameterising all (alpha,d) combinations
@@ -126,6 +161,19 @@ namespace config {
 					       FILE_REGION_THETA };
 
 	nlohmann::ordered_json jsonSTUDY;
+	// Trajectory members (and itinerary codes) have a fixed number of columns, so can be written 
+	// as NumPy arrays, or with the compressed encodings of Codec.h where these apply
+	if (outputFormat == "npy" || outputFormat == "packed") {
+	    for (size_t k = 0; k < 6; ++k)
+		fileNames[k] = std::filesystem::path(fileNames[k]).replace_extension(".npy").string();
+	}
+	if (outputFormat == "packed") {
+	    fileNames[1] = std::filesystem::path(FILE_TIME).replace_extension(".dod").string();
+	    fileNames[3] = std::filesystem::path(FILE_LABELS).replace_extension(".rle").string();
+	    fileNames[4] = std::filesystem::path(FILE_POSITIONS).replace_extension(".delta").string();
+	    fileNames[5] = std::filesystem::path(FILE_ITINERARIES).replace_extension(".delta").string();
+	}
+
 	for (size_t i = 0; i < channel_widths.size(); ++i) {
 	    for (size_t j = 0; j < channel_angles.size(); ++j) {
 		std::string study = STUDY_PREFIX + std::to_string(i*channel_angles.size()+j);
@@ -133,13 +181,17 @@ namespace config {
 	    	jsonSTUDY[study]["parameters"]["width"] = channel_widths[i];
 		//jsonstudy[study]["parameters"]["region_labels"] = nlohmann::json(all_labels[i]).dump();
 		jsonSTUDY[study]["parameters"]["region_labels"] = all_labels[i];
+		jsonSTUDY[study]["parameters"]["itineraries"] = all_itineraries[i]; // Decodes itinerary codes
+		// The running study's files are in `DataPath`, which may have been pointed elsewhere
+		const std::string path = (study == Study) ? DataPath : BaseDataPath + study + "/";
 		for (size_t k = 0; k < fileNames.size(); ++k) {
-		    std::string str = fileNames[k];
-		    str = str.erase(fileNames[k].length() - 4);
-		    jsonSTUDY[study]["files"][str] = BaseDataPath + study + "/" + fileNames[k];
+		    std::string str = std::filesystem::path(fileNames[k]).stem().string();
+		    jsonSTUDY[study]["files"][str] = path + fileNames[k];
 		}
 	    }
 	}
+	jsonSTUDY[Study]["run"]["seed"] = seed; // Reproduces the initial conditions of this run
+	jsonSTUDY[Study]["run"]["format"] = outputFormat;
 	//std::cout << "Writing ../config.json.\n";
 	std::ofstream JSONWriter(FILE_JSON);
 	JSONWriter << jsonSTUDY.dump(4); 
@@ -148,9 +200,27 @@ namespace config {
     /**@brief Configuration for runtime args
      * @param widthSelection Index to the available widths
      * @param angleSelection "                   "  angles
+     * Optional flags following the two selections:
+     *     --threads N  Number of threads used by production drivers (0 = all available)
+     *     --seed S     Run seed. Initial conditions are reproducible for a given seed
+     *     --format F   Trajectory output format, text (default), npy or packed
+     *     --classifier C  Region labels from the exact predicates (exact, default), the label index (index),
+     *                     tangent-space comparisons (tangent), or the exact labels after checking that 
+     *                     the other two agree (validate), or tangent-space comparisons with the points 
+     *                     too close to a boundary re-evaluated in float_wide (adaptive)
+     *     --shadow N   When trajectories are computed in float, also iterate the first N initial conditions
+     *                  of each region (or rectangle) in float_ and report when their labels diverge (Shadow.h)
+     *     --checkpoint S  Save the progress of trajectory drivers every S seconds of wall-clock time (Checkpoint.h)
+     *     --resume     Continue an interrupted run of the same driver from its checkpoint, with the seed of the
+     *                  checkpoint. Trajectory driver calls completed before the checkpoint are skipped, and 
+     *                  those after it run afresh. Takes no value
+     *     --shard i/N  Write only shard i (0...N-1) of the initial conditions of each run, to shard files that
+     *                  `merge_shards` combines. Every shard must be given the same --seed
+     *     --fast-forward  Skip whole periods of exactly periodic orbits in trajectories (Cycle.h). Times may
+     *                  then differ in the last bits from those of stepping. Takes no value
     */ 
     void configure_runtime(int argc, char *argv[]) {
-	if (argc != 3) 
+	if (argc < 3) 
 	    throw std::invalid_argument("ERROR: Expected two arguments.");
 	try {
 	    std::stoi(argv[1]);
@@ -159,12 +229,74 @@ namespace config {
 	    std::cerr << "ERROR: Invalid arguments. Expected two integers but received: " 
 		<< argv[1] << " " << argv[2] << ".\n";
 	}
+	bool seedGiven = false;
+	for (int i = 3; i < argc; ++i) {
+	    const std::string flag = argv[i];
+	    if (flag == "--resume") {
+		resume = true;
+		continue;
+	    }
+	    if (flag == "--fast-forward") {
+		fastForward = true;
+		continue;
+	    }
+	    if (i + 1 >= argc)
+		throw std::invalid_argument("ERROR: Missing value for argument " + flag + ".");
+	    if (flag == "--threads") {
+		nThreads = std::stoul(argv[++i]);
+		if (nThreads == 0) 
+		    nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	    } else if (flag == "--seed") {
+		seed = std::stoull(argv[++i]);
+		seedGiven = true;
+	    } else if (flag == "--format") {
+		outputFormat = argv[++i];
+		if (outputFormat != "text" && outputFormat != "npy" && outputFormat != "packed")
+		    throw std::invalid_argument("ERROR: Output format must be text, npy or packed.");
+	    } else if (flag == "--classifier") {
+		const std::string name = argv[++i];
+		if (name == "exact") classifier = RegionClassifier::Exact;
+		else if (name == "index") classifier = RegionClassifier::Index;
+		else if (name == "tangent") classifier = RegionClassifier::Tangent;
+		else if (name == "validate") classifier = RegionClassifier::Validate;
+		else if (name == "adaptive") classifier = RegionClassifier::Adaptive;
+		else throw std::invalid_argument("ERROR: Classifier must be exact, index, tangent, validate or adaptive.");
+	    } else if (flag == "--shadow") {
+		shadowParticles = std::stoul(argv[++i]);
+	    } else if (flag == "--checkpoint") {
+		checkpointSeconds = std::stod(argv[++i]);
+		if (checkpointSeconds < 0)
+		    throw std::invalid_argument("ERROR: Checkpoint interval must be non-negative.");
+	    } else if (flag == "--shard") {
+		const std::string shard = argv[++i];
+		const size_t slash = shard.find('/');
+		if (slash == std::string::npos)
+		    throw std::invalid_argument("ERROR: Shard must be given as i/N.");
+		shardIndex = std::stoul(shard.substr(0, slash));
+		shardCount = std::stoul(shard.substr(slash + 1));
+		if (shardCount == 0 || shardIndex >= shardCount)
+		    throw std::invalid_argument("ERROR: Shard i/N must have 0 <= i < N.");
+	    } else {
+		throw std::invalid_argument("ERROR: Unrecognised argument " + flag + ".");
+	    }
+	}
+	if (shardCount > 1 && !seedGiven && !resume)
+	    throw std::invalid_argument("ERROR: Sharded runs need the same --seed in every shard.");
 	initialise(std::stoi(argv[1]), std::stoi(argv[2]));
     }    
     void configure_compiletime(const size_t& angleSelect, const size_t& widthSelect) {
 	initialise(angleSelect, widthSelect);
     }
 
+    /**@brief Name of shard i of N of a data file, e.g. H.shard-1-of-4.npy for H.npy. The file itself when N = 1
+    */ 
+    std::string getShardName(const std::string& fname, const size_t& i = shardIndex, const size_t& N = shardCount) {
+	if (N == 1) return fname;
+	std::filesystem::path path(fname);
+	const std::string ext = path.extension().string();
+	return path.replace_extension().string() + ".shard-" + std::to_string(i) + "-of-" + std::to_string(N) + ext;
+    }
+
     /**@brief Gets files list from json object for the currently running study 
      * @return A nlohmann::json object
     */ 
@@ -0,0 +1,48 @@
+/**
+ * @brief Merges the shard files of a run split with `--shard i/N` into the files of a single run
+ *
+ * Usage: merge_shards <angle> <width> --shards N [config flags]
+ *     --shards N  Number of shards the run was split into
+ * Remaining flags are those of `config::configure_runtime`. Give the --format of the run, so the
+ * data files of `config.json` are those the shards wrote. Every data file of the study with shard
+ * files is merged (Shards.h). The shard files are kept.
+ * From cfiles/: make run TARGET=merge_shards ARGS="0 1 --shards 4 --format npy"
+ */
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "Shards.h"
+
+int main(int argc, char *argv[]) {
+    size_t nShards = 0;
+    std::vector<char*> args = { argv[0] }; // Flags left for config::configure_runtime
+    for (int i = 1; i < argc; ++i) {
+	const std::string flag = argv[i];
+	if (flag == "--shards") {
+	    if (i + 1 >= argc)
+		throw std::invalid_argument("ERROR: Missing value for argument " + flag + ".");
+	    nShards = std::stoul(argv[++i]);
+	} else {
+	    args.push_back(argv[i]);
+	}
+    }
+    if (nShards < 2)
+	throw std::invalid_argument("ERROR: Expected --shards N with N >= 2.");
+    config::configure_runtime(args.size(), args.data());
+
+    size_t merged = 0;
+    const nlohmann::json jsonFiles = config::getJSONFiles();
+    for (const auto& [key, value] : jsonFiles.items()) {
+	const std::string fname = value;
+	if (!std::filesystem::exists(config::getShardName(fname, 0, nShards))) continue;
+	MergeShards(fname, nShards, key == "Regions-H" || key == "Regions-Theta");
+	std::cout << "Merged " << nShards << " shards into " << fname << "\n";
+	merged++;
+    }
+    if (merged == 0)
+	std::cerr << "WARNING: No shard files of " << nShards << " shards in " << config::DataPath << ".\n";
+}
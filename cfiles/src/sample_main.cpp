@@ -22,6 +22,7 @@ int main(int argc, char *argv[])
 
     // Example usage below - 
     ScatteringMap<float_> Map(config::d);	   // <--- Implements Eq. 10,12,14,15, \hat{S}(h,\theta)
+    //ScatteringMap<float_, HalfWidth> Map;	   // <--- Width fixed at compile time (d = 1/2). See Geometry.h
     //SParticle<float_> myParticle(0.25,PI/3.);	   // <--- Manual initialisation: (h,\theta) = (1/4,pi/3)
     //SParticle<float_> myParticle();		   // <--- Random initialisation in coordinate space
     SParticle<float_> myParticle(6);		   // <--- Random initialisation in region 6
@@ -33,6 +34,11 @@ int main(int argc, char *argv[])
     Map.Evolve(myParticle); 			   // <--- \hat{S}^2(h,\theta)
     myParticle.Print();							   
 
+    // Or, evolve an ensemble of particles held as contiguous arrays
+    auto [h0, theta0] = getPointsInRegion<float_>(6, 100);
+    ParticleEnsemble<float_> myEnsemble(h0, theta0);				    // <--- 100 particles in region 6
+    Map.EvolveBatch(myEnsemble, 10);						    // <--- \hat{S}^10(h,\theta) for every particle
+
     // Or, get a 'discrete' trajectory 
     myParticle = SParticle<float_>();
     std::vector<size_t> iterates = {0,5,10,15};
@@ -61,6 +67,15 @@ int main(int argc, char *argv[])
     std::pair<float_, float_> h_int(0.1, 0.4);
     std::pair<float_, float_> theta_int(-PI2 + EPSILON, PI/3.);	    
     WriteTrajectoryData<float_>(nPoints, nIterates, h_int, theta_int);      // <--- Initial conditions form a rectangle [0.1,0.4] x [-pi/2, pi/3]
+
+    // Accumulate transport statistics without writing trajectories
+    std::vector<size_t> transportIterates(11);
+    for (size_t i = 0; i < transportIterates.size(); ++i) 
+	transportIterates[i] = 100*i;						    // <--- Every 100 iterates up to 1000
+    WriteTransportData<float_>(nPoints, transportIterates, myLabels, myWeights); // <--- Moments of x - x0 and D, written to Transport.json
+    WriteTransitionData<float_>(nPoints, 1000, {1, 10}, true, myLabels, myWeights); // <--- Region transition counts at lags 1 and 10, written to Transitions.json
+    WriteWordData<float_>(nPoints, 1000, 6, myLabels, myWeights);	    // <--- Counts of label words up to length 6 and block entropies, written to Words.json
+    WriteSnapshotData<float_>(nPoints, std::vector<float_>{10., 100., 1000.}, SnapshotOutput::Histogram, 200, myLabels, myWeights); // <--- P(x,t) at t = 10, 100, 1000, written to Snapshots-Histogram.dat
     
     // Write coordinate space points 
     myLabels = {5,9,11};						    
@@ -0,0 +1,200 @@
+/*@brief Tests of checkpoints and resumed trajectory runs
+*/
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "Writer.h"
+#include "ThreadPool.h"
+#include "Production.h"
+#include "Checkpoint.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Checkpoint
+#include <boost/test/unit_test.hpp>
+#include "utils_TEST.h"
+
+const std::string dir = std::filesystem::temp_directory_path().string() + "/Checkpoint_TEST_";
+
+/**@brief Trajectory file names of a run, with the extensions of an output format
+ */
+std::array<std::string,6> getFileNames(const std::string& tag, const std::array<std::string,6>& extensions) {
+    std::array<std::string,6> fnames;
+    for (size_t k = 0; k < fnames.size(); ++k)
+	fnames[k] = dir + tag + std::to_string(k) + extensions[k];
+    return fnames;
+}
+
+/**@brief A run interrupted after a checkpoint and resumed, on a different number of threads,
+ * writes the same bytes as an uninterrupted run
+ */
+BOOST_AUTO_TEST_CASE(resume_is_bit_identical) {
+    config::configure_compiletime(0, 0);
+    const std::vector<size_t> iterates = { 0, 1, 2, 5, 10, 50 };
+    const size_t nParticles = 1000, crash = 700;
+    for (const auto& extensions : { std::array<std::string,6>{ ".dat", ".dat", ".dat", ".dat", ".dat", ".dat" },
+				    std::array<std::string,6>{ ".npy", ".npy", ".npy", ".npy", ".npy", ".dat" },
+				    std::array<std::string,6>{ ".npy", ".dod", ".npy", ".rle", ".delta", ".dat" } }) {
+	const auto reference = getFileNames("reference", extensions), resumed = getFileNames("resumed", extensions);
+	{
+	    std::array<Writer,6> writers;
+	    for (size_t k = 0; k < writers.size(); ++k)
+		writers[k] = Writer(reference[k]);
+	    ThreadPool Pool(2);
+	    Checkpoint Progress; // Never saved
+	    WriteTrajectories<float_>(Pool, nParticles, getTestParticle, iterates, writers, Progress, { 0, nParticles });
+	}
+	config::checkpointSeconds = 1e-9; // Every batch
+	{
+	    std::array<Writer,6> writers;
+	    for (size_t k = 0; k < writers.size(); ++k)
+		writers[k] = Writer(resumed[k]);
+	    ThreadPool Pool(1);
+	    Checkpoint Progress;
+	    Progress.run = "test";
+	    Progress.path = dir + "checkpoint.bin";
+	    BOOST_CHECK_THROW(WriteTrajectories<float_>(Pool, nParticles, [](const size_t& j) {
+		if (j == crash) throw std::runtime_error("Interrupted");
+		return getTestParticle(j);
+	    }, iterates, writers, Progress, { 0, nParticles }), std::runtime_error);
+	}
+	// Anything written after the checkpoint is discarded on resume
+	for (const auto& fname : resumed)
+	    std::ofstream(fname, std::ios::app | std::ios::binary) << "partial row";
+	Checkpoint Progress = Checkpoint::Read(dir + "checkpoint.bin");
+	BOOST_TEST(Progress.run == "test");
+	BOOST_TEST(Progress.call == 0u);
+	BOOST_TEST(Progress.particle == 2*PARTICLE_BATCH);
+	{
+	    std::array<Writer,6> writers;
+	    for (size_t k = 0; k < writers.size(); ++k)
+		writers[k] = Writer(resumed[k], Progress.writers[k]);
+	    ThreadPool Pool(3);
+	    WriteTrajectories<float_>(Pool, nParticles, getTestParticle, iterates, writers, Progress, { 0, nParticles });
+	}
+	config::checkpointSeconds = 0;
+	BOOST_TEST(Progress.call == 1u);
+	BOOST_TEST(Progress.particle == 0u);
+	for (size_t k = 0; k < reference.size(); ++k) {
+	    BOOST_TEST(readFile(reference[k]).size() > 0u);
+	    BOOST_TEST((readFile(reference[k]) == readFile(resumed[k])), reference[k] + " differs when resumed");
+	    std::filesystem::remove(reference[k]);
+	    std::filesystem::remove(resumed[k]);
+	}
+	std::filesystem::remove(dir + "checkpoint.bin");
+    }
+}
+
+/**@brief A process calling a driver of trajectory runs twice, the second time with other initial
+ * conditions. Initial condition `crash` of call `crashCall` interrupts it
+ * @return Trajectory files after each call that was not skipped
+ */
+std::vector<std::array<std::string,6>> runTwoCalls(const size_t& crashCall, const size_t& crash) {
+    const nlohmann::json jfiles = config::getJSONFiles();
+    const std::array<std::string,6> fnames = { jfiles["H"], jfiles["Time"], jfiles["Theta"], jfiles["Labels"],
+					       jfiles["Positions"], jfiles["Itineraries"] };
+    std::vector<std::array<std::string,6>> outputs;
+    config::trajectoryRun = 0; // A new process
+    for (size_t call = 0; call < 2; ++call) {
+	auto Run = openTrajectoryRun<float_>("two calls " + std::to_string(call));
+	if (!Run) continue;
+	auto& [writers, Progress] = *Run;
+	ThreadPool Pool(2);
+	WriteTrajectories<float_>(Pool, 1000, [&](const size_t& j) {
+	    if (call == crashCall && j == crash) throw std::runtime_error("Interrupted");
+	    return getTestParticle(1000*call + j);
+	}, { 0, 1, 5, 20 }, writers, Progress, { 0, 1000 });
+	closeTrajectoryRun(Progress);
+	std::array<std::string,6> output;
+	for (size_t k = 0; k < writers.size(); ++k) {
+	    writers[k].Close();
+	    output[k] = readFile(fnames[k]);
+	}
+	outputs.push_back(output);
+    }
+    return outputs;
+}
+
+/**@brief A process of two trajectory runs resumes bit-identically whichever run was interrupted:
+ * the runs completed before the checkpoint are skipped and those after it run afresh
+ */
+BOOST_AUTO_TEST_CASE(resume_two_calls) {
+    config::configure_compiletime(0, 0);
+    config::DataPath = dir + "data/";
+    std::filesystem::create_directories(config::DataPath);
+    config::writeJSONConfig();
+    const std::string checkpoint = config::DataPath + config::FILE_CHECKPOINT;
+    const auto reference = runTwoCalls(2, 0);
+    BOOST_TEST(reference.size() == 2u);
+    BOOST_TEST((reference[0] != reference[1]));
+    config::checkpointSeconds = 1e-9; // Every batch
+    for (const size_t crashCall : { 0, 1 }) {
+	BOOST_CHECK_THROW(runTwoCalls(crashCall, 700), std::runtime_error);
+	BOOST_TEST(Checkpoint::Read(checkpoint).index == crashCall);
+	config::resume = true;
+	const auto resumed = runTwoCalls(2, 0);
+	BOOST_TEST(!config::resume);
+	BOOST_TEST(resumed.size() == 2 - crashCall);
+	for (size_t i = 0; i < resumed.size(); ++i)
+	    BOOST_TEST((resumed[i] == reference[crashCall + i]), "call " << crashCall + i << " differs when resumed");
+	BOOST_TEST(!std::filesystem::exists(checkpoint));
+    }
+    config::checkpointSeconds = 0;
+    std::filesystem::remove_all(config::DataPath);
+    config::DataPath = config::BaseDataPath + config::Study + "/";
+    config::writeJSONConfig();
+}
+
+/**@brief Checkpoints read back as saved, and damaged ones are rejected
+ */
+BOOST_AUTO_TEST_CASE(round_trip) {
+    const std::string fname = dir + "round_trip.bin", data = dir + "round_trip.npy";
+    std::array<Writer,6> writers;
+    for (size_t k = 0; k < writers.size(); ++k) {
+	writers[k] = Writer(data + std::to_string(k) + ".npy");
+	writers[k].WriteRowVector<int>({ 1, 2, (int)k });
+    }
+    Checkpoint Saved;
+    Saved.run = "regions 10 5";
+    Saved.seed = 123456789123456789ull;
+    Saved.index = 3;
+    Saved.call = 2;
+    Saved.particle = 512;
+    Saved.unresolved = { 3, 400 };
+    Saved.shadow.nSteps = 50;
+    Saved.shadow.precision = "float";
+    Saved.shadow.firstDivergence = { 7, 51 };
+    Saved.path = fname;
+    Saved.Save(writers);
+    const Checkpoint Read = Checkpoint::Read(fname);
+    BOOST_TEST(Read.run == Saved.run);
+    BOOST_TEST(Read.seed == Saved.seed);
+    BOOST_TEST(Read.index == Saved.index);
+    BOOST_TEST(Read.call == Saved.call);
+    BOOST_TEST(Read.particle == Saved.particle);
+    BOOST_TEST(Read.unresolved == Saved.unresolved);
+    BOOST_TEST(Read.shadow.precision == "float");
+    BOOST_TEST(Read.shadow.firstDivergence == Saved.shadow.firstDivergence);
+    for (size_t k = 0; k < writers.size(); ++k) {
+	BOOST_TEST(Read.writers[k].bytes == NPY_HEADER_SIZE + 3*sizeof(int));
+	BOOST_TEST(Read.writers[k].rows == 1u);
+	BOOST_TEST(Read.writers[k].descr == npyDescr<int>());
+    }
+    // The header of .npy files is valid at the checkpoint
+    BOOST_TEST(readFile(data + "0.npy").find("'shape': (1, 3)") != std::string::npos);
+    for (size_t k = 0; k < writers.size(); ++k) {
+	writers[k].Close();
+	std::filesystem::remove(data + std::to_string(k) + ".npy");
+    }
+    BOOST_CHECK_THROW(Writer(data + "0.npy", Read.writers[0]), std::runtime_error);
+    std::filesystem::resize_file(fname, std::filesystem::file_size(fname) - 1);
+    BOOST_CHECK_THROW(Checkpoint::Read(fname), std::runtime_error);
+    std::ofstream(fname, std::ios::binary) << "SMPK";
+    BOOST_CHECK_THROW(Checkpoint::Read(fname), std::runtime_error);
+    std::filesystem::remove(fname);
+    BOOST_CHECK_THROW(Checkpoint::Read(fname), std::runtime_error);
+}
@@ -0,0 +1,145 @@
+/*@brief Batched region classifiers must agree with `whichRegion`
+*/ 
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+#include "json.hpp"	   // https://github.com/nlohmann/json
+#include "config.h"        
+#include "Random.h"        
+#include "SMapHelper.h"    
+#include "Classifier.h"    
+#include "RegionCover.h"
+#include "ScatteringMap.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Classifier
+#include <boost/test/unit_test.hpp>
+
+/**@brief Uniform random points plus a grid that lands exactly on h = 0, d and theta = +-pi/2
+ */
+std::tuple<std::vector<float_>, std::vector<float_>> getTestPoints(const size_t& nRandom, const size_t& nGrid) {
+    std::vector<float_> h, theta;
+    for (size_t i = 0; i < nRandom; ++i) {
+	h.push_back(runif<float_>(0, config::d));
+	theta.push_back(runif<float_>(-PI, PI));
+    }
+    for (size_t i = 0; i <= nGrid; ++i) {
+	for (size_t j = 0; j <= nGrid; ++j) {
+	    h.push_back(config::d*i/(float_)nGrid);
+	    theta.push_back(-PI2 + PI*j/(float_)nGrid);
+	}
+    }
+    return { h, theta };
+}
+
+BOOST_AUTO_TEST_CASE(batch_matches_whichRegion) {
+    for (size_t i = 0; i < config::channel_widths.size(); ++i) {
+	config::configure_compiletime(0, i);
+	auto [h, theta] = getTestPoints(100000, 240);
+	std::vector<int> labels = whichRegionBatch<float_>(h, theta);
+	size_t nMismatch = 0;
+	for (size_t j = 0; j < h.size(); ++j) 
+	    nMismatch += (labels[j] != whichRegion<float_>(h[j], theta[j]));
+	BOOST_TEST(nMismatch == 0);
+    }
+}
+
+/**@brief The tangent-space classifier agrees with `whichRegion`, including next to every boundary
+ */
+BOOST_AUTO_TEST_CASE(tangent_matches_whichRegion) {
+    const std::vector<BoundaryFn> curves = { X1, X2, X3, X4, X5, X6, X7, X8, X9, X10, X11, X12, X13,
+					     X14, X15, X16, X17, X18, XG, XA0, XA1, XB19 };
+    for (size_t i = 0; i < config::channel_widths.size(); ++i) {
+	config::configure_compiletime(0, i);
+	auto [h, theta] = getTestPoints(100000, 240);
+	for (size_t j = 0; j < 20000; ++j) {
+	    const float_ H = runif<float_>(0, config::d);
+	    for (auto f : curves) {
+		float_ th = f(config::d, H);
+		for (int k = 0; k < 2; ++k) th = std::nextafter(th, -PI);
+		for (int k = 0; k < 5; ++k, th = std::nextafter(th, PI)) {
+		    h.push_back(H);
+		    theta.push_back(th);
+		}
+	    }
+	}
+	size_t nMismatch = 0;
+	for (size_t j = 0; j < 20000; ++j) { // Boundaries as evaluated in float
+	    const float H = runif<float_>(0, config::d);
+	    for (auto f : curves) {
+		float th = f(config::d, H);
+		for (int k = 0; k < 4; ++k) th = std::nextafter(th, -4.f);
+		for (int k = 0; k < 9; ++k, th = std::nextafter(th, 4.f)) {
+		    nMismatch += (whichRegionTangent<float>(H, th) != whichRegion<float>(H, th));
+		    nMismatch += (whichRegionBatch<float>({ H }, { th })[0] != whichRegion<float>(H, th));
+		}
+	    }
+	}
+	for (size_t j = 0; j < h.size(); ++j) {
+	    const int label = whichRegion<float_>(h[j], theta[j]);
+	    nMismatch += (whichRegionTangent<float_>(h[j], theta[j]) != label);
+	    nMismatch += (whichRegionTangent<float_>(h[j], PI - theta[j]) != whichRegion<float_>(h[j], PI - theta[j]));
+	    nMismatch += (whichRegionTangent<float>(h[j], theta[j]) != whichRegion<float>(h[j], theta[j]));
+	}
+	BOOST_TEST(nMismatch == 0);
+    }
+}
+
+/**@brief Trajectories are unchanged by the classifier selected, and validation passes
+ */
+BOOST_AUTO_TEST_CASE(selected_classifier) {
+    for (size_t i = 0; i < config::channel_widths.size(); ++i) {
+	config::configure_compiletime(0, i);
+	ParticleEnsemble<float_> Exact;
+	for (size_t j = 0; j < 500; ++j) 
+	    Exact.Add(SParticle<float_>());
+	ParticleEnsemble<float_> Tangent = Exact, Validated = Exact;
+	ScatteringMap<float_>(config::d).EvolveBatch(Exact, 200);
+	config::classifier = RegionClassifier::Tangent;
+	ScatteringMap<float_>(config::d).EvolveBatch(Tangent, 200);
+	config::classifier = RegionClassifier::Validate;
+	BOOST_CHECK_NO_THROW(ScatteringMap<float_>(config::d).EvolveBatch(Validated, 200));
+	config::classifier = RegionClassifier::Exact;
+	BOOST_TEST(Tangent.H == Exact.H);
+	BOOST_TEST(Tangent.Label == Exact.Label);
+	BOOST_TEST(Validated.H == Exact.H);
+    }
+}
+
+/**@brief The adaptive classifier agrees with `whichRegion` away from boundaries and with 
+ * `whichRegion<float_wide>` next to them, where float places some points in no region
+ */
+BOOST_AUTO_TEST_CASE(adaptive_near_boundaries) {
+    const std::vector<BoundaryFn> curves = { X1, X2, X3, X4, X5, X6, X7, X8, X9, X10, X11, X12, X13,
+					     X14, X15, X16, X17, X18, XG, XA0, XA1, XB19 };
+    for (size_t i = 0; i < config::channel_widths.size(); ++i) {
+	config::configure_compiletime(0, i);
+	size_t nMismatch = 0, nNoRegionFloat = 0, nNoRegionAdaptive = 0;
+	for (size_t j = 0; j < 100000; ++j) {
+	    const float_ H = runif<float_>(0, config::d), th = runif<float_>(-PI, PI);
+	    nMismatch += (whichRegionAdaptive<float_>(H, th) != whichRegion<float_>(H, th));
+	}
+	for (size_t j = 0; j < 20000; ++j) {
+	    const float_ H = runif<float_>(0, config::d);
+	    for (auto f : curves) {
+		float_ th = f(config::d, H);
+		for (int k = 0; k < 2; ++k) th = std::nextafter(th, -PI);
+		for (int k = 0; k < 5; ++k, th = std::nextafter(th, PI))
+		    nMismatch += (whichRegionAdaptive<float_>(H, th) != whichRegion<float_wide>(H, th));
+		float thF = f(config::d, H);
+		for (int k = 0; k < 4; ++k) thF = std::nextafter(thF, -4.f);
+		for (int k = 0; k < 9; ++k, thF = std::nextafter(thF, 4.f)) {
+		    const int label = whichRegionAdaptive<float>((float)H, thF);
+		    nMismatch += (label != whichRegion<float_wide>((float)H, thF));
+		    nNoRegionFloat += (whichRegion<float>((float)H, thF) == -1);
+		    nNoRegionAdaptive += (label == -1);
+		}
+	    }
+	}
+	BOOST_TEST(nMismatch == 0u);
+	BOOST_TEST(nNoRegionFloat > 0u);
+	BOOST_TEST(nNoRegionAdaptive == 0u);
+    }
+}
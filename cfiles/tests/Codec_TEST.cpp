@@ -0,0 +1,81 @@
+/*@brief Tests of the compressed trajectory encodings
+*/
+
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+#include "config.h"
+#include "Codec.h"
+#include "Writer.h"
+#include "Trajectory.h"
+#include "ScatteringMap.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Codec
+#include <boost/test/unit_test.hpp>
+
+template <typename T>
+std::vector<T> roundTrip(const Codec& codec, const std::vector<T>& v) {
+    const std::string bytes = Encode<T>(codec, v);
+    return Decode<T>(codec, bytes.data(), bytes.data() + bytes.size(), v.size());
+}
+
+/**@brief Every codec reproduces its input exactly, including extreme values
+ */
+BOOST_AUTO_TEST_CASE(round_trip) {
+    std::vector<int> labels = { -1, 0, 0, 0, 19, 19, 7, 7, 7, 7, 30 };
+    std::vector<int_ll> positions = { 0, 1, 0, -1, -2, 5, std::numeric_limits<int_ll>::max(), std::numeric_limits<int_ll>::min(), 3 };
+    std::vector<double> times = { 0., 1.5, 3., 4.5, 6.000000000000001, 1e300, std::numeric_limits<double>::denorm_min(), 7. };
+    BOOST_TEST(roundTrip<int>(Codec::RLE, labels) == labels);
+    BOOST_TEST(roundTrip<int_ll>(Codec::Delta, positions) == positions);
+    BOOST_TEST(roundTrip<double>(Codec::DoD, times) == times);
+    BOOST_TEST(roundTrip<double>(Codec::DoD, {}) == std::vector<double>{});
+    BOOST_TEST(roundTrip<double>(Codec::DoD, { 2.5 }) == std::vector<double>{ 2.5 });
+    BOOST_CHECK_THROW(Encode<int>(Codec::RLE, { 31 }), std::invalid_argument);
+    std::vector<int> run(100000, 6);
+    BOOST_TEST(Encode<int>(Codec::RLE, run).size() <= 4u);
+}
+
+/**@brief Trajectories written with codecs are read back exactly and take less space than text
+ */
+BOOST_AUTO_TEST_CASE(trajectory_files) {
+    config::configure_compiletime(0, 0);
+    ScatteringMap<float_> Map(config::d);
+    std::vector<size_t> iterates(1000);
+    std::iota(iterates.begin(), iterates.end(), 0);
+    std::vector<STrajectory<float_>> Trajs;
+    for (size_t j = 0; j < 50; ++j) {
+	SParticle<float_> SP(6);
+	Trajs.push_back(Map.getTrajectory(SP, iterates));
+    }
+    const std::string base = std::filesystem::temp_directory_path().string() + "/Codec_TEST";
+    {
+	Writer wLabels(base + ".rle"), wPositions(base + ".delta"), wTime(base + ".dod");
+	Writer tLabels(base + "Labels.dat"), tPositions(base + "Positions.dat"), tTime(base + "Time.dat");
+	for (const auto& Traj : Trajs) {
+	    wLabels.WriteRowVector<int>(Traj.Label);
+	    wPositions.WriteRowVector<int_ll>(Traj.Position);
+	    wTime.WriteRowVector<float_>(Traj.Time);
+	    tLabels.WriteRowVector<int>(Traj.Label);
+	    tPositions.WriteRowVector<int_ll>(Traj.Position);
+	    tTime.WriteRowVector<float_>(Traj.Time);
+	}
+	BOOST_CHECK_THROW(wLabels.WriteRowVector<std::string>({ "L" }), std::invalid_argument);
+    }
+    auto labels = ReadEncodedRows<int>(base + ".rle");
+    auto positions = ReadEncodedRows<int_ll>(base + ".delta");
+    auto times = ReadEncodedRows<float_>(base + ".dod");
+    BOOST_TEST(labels.size() == Trajs.size());
+    for (size_t j = 0; j < Trajs.size(); ++j) {
+	BOOST_TEST(labels[j] == Trajs[j].Label);
+	BOOST_TEST(positions[j] == Trajs[j].Position);
+	BOOST_TEST(times[j] == Trajs[j].Time);
+    }
+    const auto size = [&base](const std::string& ext) { return std::filesystem::file_size(base + ext); };
+    BOOST_TEST(size(".rle") * 2 < size("Labels.dat"));
+    BOOST_TEST(size(".delta") * 2 < size("Positions.dat"));
+    BOOST_TEST(size(".dod") < size("Time.dat"));
+    for (auto ext : { ".rle", ".delta", ".dod", "Labels.dat", "Positions.dat", "Time.dat" })
+	std::filesystem::remove(base + ext);
+}
@@ -0,0 +1,92 @@
+/*@brief Tests of the detection of periodic orbits and of fast-forwarded trajectories
+*/
+
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "ScatteringMap.h"
+#include "Cycle.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Cycle
+#include <boost/test/unit_test.hpp>
+
+/**@brief Periods, displacements and durations of a repeating sequence of states
+ */
+BOOST_AUTO_TEST_CASE(detects_periods) {
+    CycleDetector<float_> Cycle;
+    const std::vector<float_> h = { 0.1, 0.2, 0.3 };
+    size_t found = 0;
+    for (size_t n = 0; n < 12; ++n) {
+	const size_t period = Cycle.Push(h[n % 3], 0.5, 4, 2*n, 1.5*n);
+	if (n < 3) {
+	    BOOST_TEST(period == 0u);
+	} else {
+	    BOOST_TEST(period == 3u);
+	    BOOST_TEST(Cycle.Displacement() == 6);
+	    BOOST_TEST(Cycle.Duration() == 4.5);
+	    found++;
+	}
+    }
+    BOOST_TEST(found == 9u);
+    Cycle.Reset();
+    BOOST_TEST(Cycle.Push(0.1, 0.5, 4, 0, 0.) == 0u);
+    BOOST_TEST(Cycle.Push(0.1, -0., 4, 0, 0.) == 0u); // -0 and 0 are different states
+    BOOST_TEST(Cycle.Push(0.1, 0.5, -1, 0, 0.) == 0u); // No cycles in no region
+}
+
+/**@brief Ballistic orbits are skipped in closed form, to the same states, positions and (nearly) times
+ */
+BOOST_AUTO_TEST_CASE(ballistic_fast_forward) {
+    const std::vector<size_t> iterates = { 0, 7, 100, 10001, 1000000 };
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	ScatteringMap<float_> Map(config::d), Fast(config::d);
+	Fast.FastForward = true;
+	std::vector<float_> times;
+	for (const auto& n : iterates)
+	    times.push_back((1 + 2*config::d)*n + 0.3);
+	for (const float_ theta : { (float_)0, PI }) {
+	    SParticle<float_> SP(0.2, theta), SPFast(0.2, theta);
+	    const STrajectory<float_> Traj = Map.getTrajectory(SP, iterates), TrajFast = Fast.getTrajectory(SPFast, iterates);
+	    BOOST_TEST(TrajFast.Position == Traj.Position);
+	    BOOST_TEST(TrajFast.Label == Traj.Label);
+	    BOOST_TEST(TrajFast.H == Traj.H);
+	    BOOST_TEST(TrajFast.Theta == Traj.Theta);
+	    for (size_t k = 0; k < iterates.size(); ++k)
+		BOOST_TEST(TrajFast.Time[k] == Traj.Time[k], boost::test_tools::tolerance(1e-12));
+	    SParticle<float_> SPTime(0.2, theta), SPTimeFast(0.2, theta);
+	    const STrajectory<float_> InTime = Map.getTrajectory(SPTime, times), InTimeFast = Fast.getTrajectory(SPTimeFast, times);
+	    BOOST_TEST(InTimeFast.Position == InTime.Position);
+	    BOOST_TEST(InTimeFast.Label == InTime.Label);
+	    for (size_t k = 0; k < times.size(); ++k)
+		BOOST_TEST(InTimeFast.Time[k] == InTime.Time[k], boost::test_tools::tolerance(1e-12));
+	}
+    }
+}
+
+/**@brief Trajectories with no exact cycle are unchanged by fast-forwarding
+ */
+BOOST_AUTO_TEST_CASE(aperiodic_unchanged) {
+    const std::vector<size_t> iterates = { 0, 10, 100, 1000 };
+    const std::vector<float_> times = { 0., 10., 100., 1000. };
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	ScatteringMap<float_> Map(config::d), Fast(config::d);
+	Fast.FastForward = true;
+	for (size_t j = 0; j < 200; ++j) {
+	    Random<float_> rng(11, j);
+	    const SParticle<float_> Initial({ 0., config::d }, { -PI2, PI2 }, rng);
+	    SParticle<float_> A = Initial, B = Initial, C = Initial, D = Initial;
+	    const STrajectory<float_> Traj = Map.getTrajectory(A, iterates), TrajFast = Fast.getTrajectory(B, iterates);
+	    const STrajectory<float_> InTime = Map.getTrajectory(C, times), InTimeFast = Fast.getTrajectory(D, times);
+	    BOOST_TEST(TrajFast.H == Traj.H);
+	    BOOST_TEST(TrajFast.Time == Traj.Time);
+	    BOOST_TEST(TrajFast.Position == Traj.Position);
+	    BOOST_TEST(InTimeFast.H == InTime.H);
+	    BOOST_TEST(InTimeFast.Time == InTime.Time);
+	    BOOST_TEST(InTimeFast.Position == InTime.Position);
+	}
+    }
+}
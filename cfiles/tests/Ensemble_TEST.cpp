@@ -0,0 +1,47 @@
+/*@brief Tests of batched evolution over a `ParticleEnsemble`
+*/ 
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "json.hpp"	   // https://github.com/nlohmann/json
+#include "config.h"        
+#include "Random.h"        
+#include "SMapHelper.h"    
+#include "Ensemble.h"    
+#include "ScatteringMap.h" 
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Ensemble
+#include <boost/test/unit_test.hpp>
+
+/**@brief `EvolveBatch` must reproduce `Evolve` applied to each particle exactly
+ */
+BOOST_AUTO_TEST_CASE(batch_matches_scalar) {
+    size_t nParticles = 1000;
+    size_t nSteps = 100;
+    for (size_t i = 0; i < config::channel_widths.size(); ++i) {
+	config::configure_compiletime(0, i);
+    	ScatteringMap<float_> SM(config::d);
+
+	std::vector<SParticle<float_>> particles;
+	ParticleEnsemble<float_> PE;
+	for (size_t j = 0; j < nParticles; ++j) {
+	    SParticle<float_> SP;
+	    particles.push_back(SP);
+	    PE.Add(SP);
+	}
+	SM.EvolveBatch(PE, nSteps);
+	for (size_t j = 0; j < nParticles; ++j) {
+	    for (size_t n = 0; n < nSteps; ++n) 
+		SM.Evolve(particles[j]);
+	    BOOST_TEST(PE.H[j] == particles[j].H);
+	    BOOST_TEST(PE.Theta[j] == particles[j].Theta);
+	    BOOST_TEST(PE.Tau[j] == particles[j].Tau);
+	    BOOST_TEST(PE.Position[j] == particles[j].Position);
+	    BOOST_TEST(PE.Label[j] == particles[j].Label);
+	}
+    }
+}
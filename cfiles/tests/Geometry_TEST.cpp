@@ -0,0 +1,56 @@
+/*@brief Tests of the compile-time geometries
+*/
+
+#include <vector>
+
+#include "config.h"
+#include "Geometry.h"
+#include "SMapHelper.h"
+#include "ScatteringMap.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Geometry
+#include <boost/test/unit_test.hpp>
+
+/**@brief Geometries agree with the runtime configuration they replace
+ */
+BOOST_AUTO_TEST_CASE(matches_config) {
+    for (size_t i = 0; i < config::channel_widths.size(); ++i) {
+	config::configure_compiletime(0, i);
+	withGeometry([](auto G) {
+	    using Geometry = decltype(G);
+	    BOOST_TEST(Geometry::widthSelection == config::widthSelection);
+	    BOOST_TEST(Geometry::d == config::d);
+	    BOOST_TEST(std::vector<int>(Geometry::labels.begin(), Geometry::labels.end()) == config::regionLabels);
+	});
+    }
+}
+
+/**@brief `ScatteringMap<T, Geometry>` reproduces `ScatteringMap<T>` exactly
+ */
+BOOST_AUTO_TEST_CASE(static_matches_dynamic) {
+    const size_t nParticles = 500, nSteps = 200;
+    for (size_t i = 0; i < config::channel_widths.size(); ++i) {
+	config::configure_compiletime(0, i);
+	ScatteringMap<float_> Dynamic(config::d);
+	ParticleEnsemble<float_> A, B;
+	for (size_t j = 0; j < nParticles; ++j) {
+	    SParticle<float_> SP;
+	    A.Add(SP);
+	    B.Add(SP);
+	    BOOST_TEST(withGeometry([&](auto G) { return whichRegion<float_, decltype(G)>(SP.H, SP.Theta); })
+		       == whichRegion<float_>(SP.H, SP.Theta));
+	}
+	Dynamic.EvolveBatch(A, nSteps);
+	withGeometry([&](auto G) {
+	    ScatteringMap<float_, decltype(G)> Static;
+	    Static.EvolveBatch(B, nSteps);
+	});
+	BOOST_TEST(A.H == B.H);
+	BOOST_TEST(A.Theta == B.Theta);
+	BOOST_TEST(A.Tau == B.Tau);
+	BOOST_TEST(A.Position == B.Position);
+	BOOST_TEST(A.Label == B.Label);
+    }
+    BOOST_CHECK_THROW((ScatteringMap<float_, UnitWidth>(0.5)), std::invalid_argument);
+}
@@ -0,0 +1,68 @@
+/*@brief Tests of the hot-path instrumentation
+*/
+
+#define SMAP_INSTRUMENT
+
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "SMapHelper.h"
+#include "ScatteringMap.h"
+#include "Instrument.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Instrument
+#include <boost/test/unit_test.hpp>
+
+std::uint64_t sum(const auto& counts) {
+    std::uint64_t total = 0;
+    for (const auto& c : counts) total += c;
+    return total;
+}
+
+/**@brief Steps, their labels and classifications are counted, on the thread stepping and after it exits
+ */
+BOOST_AUTO_TEST_CASE(counts_steps) {
+    config::configure_compiletime(0, 0);
+    const size_t nSteps = 5000;
+    const InstrumentCounters Before = getInstrumentTotals();
+    std::vector<std::uint64_t> expected(N_LABELS);
+    std::thread worker([&] {
+	ScatteringMap<float_, HalfWidth> Map;
+	SParticle<float_> SP(0.2, 0.3);
+	for (size_t n = 0; n < nSteps; ++n) {
+	    expected[SP.Label]++;
+	    Map.Evolve(SP);
+	}
+	const InstrumentCounters& C = getThreadCounters();
+	BOOST_TEST(sum(C.steps) >= nSteps);
+    });
+    worker.join();
+    const InstrumentCounters After = getInstrumentTotals();
+    std::uint64_t wide = After.wideSteps - Before.wideSteps;
+    for (size_t l = 0; l < N_LABELS; ++l) {
+	const std::uint64_t steps = After.steps[l] - Before.steps[l];
+	BOOST_TEST((steps >= expected[l] && steps <= expected[l] + wide));
+	BOOST_TEST(sum(After.cycleHistogram[l]) == After.steps[l]);
+	if (steps > 0)
+	    BOOST_TEST(After.CycleQuantile(l, 0.5) > 0u);
+    }
+    BOOST_TEST(sum(After.classified) - sum(Before.classified) >= nSteps);
+}
+
+/**@brief Rejection sampling counts one acceptance per point and at least as many proposals
+ */
+BOOST_AUTO_TEST_CASE(counts_rejection_sampling) {
+    config::configure_compiletime(0, 0);
+    const InstrumentCounters Before = getInstrumentTotals();
+    Random<float_> rng(8, 0);
+    for (const int label : { 0, 9, 14 })
+	getPointsInRegion<float_>(label, 200, rng);
+    const InstrumentCounters After = getInstrumentTotals();
+    for (const int label : { 0, 9, 14 }) {
+	BOOST_TEST(After.accepted[label] - Before.accepted[label] == 200u);
+	BOOST_TEST(After.proposals[label] - Before.proposals[label] >= 200u);
+    }
+}
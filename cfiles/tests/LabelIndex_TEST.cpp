@@ -0,0 +1,104 @@
+/*@brief Tests of the precomputed label index
+*/
+
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "LabelIndex.h"
+#include "SMapHelper.h"
+#include "ScatteringMap.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE LabelIndex
+#include <boost/test/unit_test.hpp>
+
+/**@brief Labels agree with `whichRegion` everywhere, including next to every boundary
+ */
+BOOST_AUTO_TEST_CASE(matches_whichRegion) {
+    const std::vector<BoundaryFn> curves = { X1, X2, X3, X4, X5, X6, X7, X8, X9, X10, X11, X12, X13,
+					     X14, X15, X16, X17, X18, XG, XA0, XA1, XB19 };
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	const LabelIndex Index(LABEL_INDEX_H, LABEL_INDEX_THETA);
+	BOOST_TEST(Index.CleanFraction() > 0.9);
+	Random<double> rng(1, 0);
+	size_t mismatched = 0;
+	auto check = [&](const double& h, const double& theta) {
+	    mismatched += (Index.Classify<double>(h, theta) != whichRegion<double>(h, theta));
+	    mismatched += (Index.Classify<double>(h, PI - theta) != whichRegion<double>(h, PI - theta));
+	    mismatched += (Index.Classify<float>(h, theta) != whichRegion<float>(h, theta));
+	};
+	for (size_t i = 0; i < 1000000; ++i)
+	    check(rng.getUniformRandom(-0.1, config::d + 0.1), rng.getUniformRandom(-PI2, PI2));
+	for (size_t i = 0; i < 20000; ++i) {
+	    const double h = rng.getUniformRandom(0, config::d);
+	    for (auto f : curves) {
+		double theta = f(config::d, h);
+		for (int k = 0; k < 3; ++k) theta = std::nextafter(theta, -PI);
+		for (int k = 0; k < 7; ++k, theta = std::nextafter(theta, PI))
+		    check(h, theta);
+		// Boundaries as evaluated in float
+		float thetaF = f(config::d, h);
+		for (int k = 0; k < 4; ++k) thetaF = std::nextafter(thetaF, -4.f);
+		for (int k = 0; k < 9; ++k, thetaF = std::nextafter(thetaF, 4.f))
+		    mismatched += (Index.Classify<float>((float)h, thetaF) != whichRegion<float>((float)h, thetaF));
+	    }
+	}
+	for (double c : { 0., 1/8., 1/6., 1/4., 1/3., 2/5., 1/2., 3/5., 2/3., 1. }) {
+	    for (size_t i = 0; i < 2000; ++i) {
+		const double theta = rng.getUniformRandom(-PI2, PI2);
+		check(std::nextafter(c, -1.), theta);
+		check(c, theta);
+		check(std::nextafter(c, 2.), theta);
+	    }
+	}
+	BOOST_TEST(mismatched == 0u);
+    }
+}
+
+/**@brief A saved index loads back unchanged, and only for the width it was built for
+ */
+BOOST_AUTO_TEST_CASE(cache_round_trip) {
+    const std::string fname = std::filesystem::temp_directory_path().string() + "/LabelIndex_TEST.bin";
+    config::configure_compiletime(0, 0);
+    const LabelIndex Index(LABEL_INDEX_H, LABEL_INDEX_THETA);
+    Index.Save(fname);
+    LabelIndex Loaded;
+    BOOST_TEST(Loaded.Load(fname));
+    BOOST_TEST(Loaded.cells == Index.cells);
+    BOOST_TEST(Loaded.Classify<double>(0.25, 0.1) == whichRegion<double>(0.25, 0.1));
+    config::configure_compiletime(0, 1);
+    BOOST_TEST(!LabelIndex().Load(fname));
+    std::filesystem::resize_file(fname, 100);
+    config::configure_compiletime(0, 0);
+    BOOST_TEST(!LabelIndex().Load(fname));
+    std::filesystem::remove(fname);
+}
+
+/**@brief Evolving with the index selected reproduces the exact classifier
+ */
+BOOST_AUTO_TEST_CASE(map_matches_exact) {
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	ParticleEnsemble<float_> A, B;
+	for (size_t j = 0; j < 500; ++j) {
+	    SParticle<float_> SP;
+	    A.Add(SP);
+	    B.Add(SP);
+	}
+	ScatteringMap<float_> Exact(config::d);
+	Exact.EvolveBatch(A, 200);
+	config::classifier = RegionClassifier::Index;
+	ScatteringMap<float_> Indexed(config::d);
+	BOOST_TEST(Indexed.Index != nullptr);
+	Indexed.EvolveBatch(B, 200);
+	config::classifier = RegionClassifier::Exact;
+	BOOST_TEST(A.H == B.H);
+	BOOST_TEST(A.Theta == B.Theta);
+	BOOST_TEST(A.Position == B.Position);
+	BOOST_TEST(A.Label == B.Label);
+    }
+}
@@ -0,0 +1,171 @@
+/*@brief Tests of the background trajectory writer
+*/
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "Writer.h"
+#include "Trajectory.h"
+#include "ScatteringMap.h"
+#include "Pipeline.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Pipeline
+#include <boost/test/unit_test.hpp>
+
+/**@brief Items arrive once and in order
+ */
+BOOST_AUTO_TEST_CASE(spsc_order) {
+    const size_t n = 100000;
+    SPSCQueue<size_t, 4> q;
+    std::thread producer([&q] {
+	for (size_t i = 1; i <= n; ++i) q.Push(std::move(i));
+    });
+    bool ordered = true;
+    for (size_t i = 1; i <= n; ++i)
+	ordered &= (q.Pop() == i);
+    producer.join();
+    BOOST_TEST(ordered);
+}
+
+/**@brief Files written through the pipeline are identical to writing synchronously
+ */
+BOOST_AUTO_TEST_CASE(matches_synchronous_write) {
+    config::configure_compiletime(0, 0);
+    ScatteringMap<float_> Map(config::d);
+    std::vector<size_t> iterates = { 0, 1, 2, 5, 10 };
+    std::vector<STrajectory<float_>> Trajs;
+    for (size_t j = 0; j < 500; ++j) {
+	SParticle<float_> SP;
+	Trajs.push_back(Map.getTrajectory(SP, iterates));
+    }
+
+    const std::string dir = std::filesystem::temp_directory_path().string() + "/Pipeline_TEST_";
+    auto open = [&dir](const std::string& tag) {
+	std::array<Writer,6> writers;
+	for (size_t k = 0; k < writers.size(); ++k)
+	    writers[k] = Writer(dir + tag + std::to_string(k) + ".dat");
+	return writers;
+    };
+    {
+	auto sync = open("sync");
+	for (const auto& Traj : Trajs)
+	    Traj.Write(sync);
+	for (size_t nThreads : { 1, 2, 6 }) {
+	    auto async = open("async" + std::to_string(nThreads));
+	    TrajectoryPipeline<float_> Pipeline(async, nThreads);
+	    for (size_t b = 0; b < Trajs.size(); b += 64)
+		Pipeline.Push(std::vector<STrajectory<float_>>(Trajs.begin() + b, Trajs.begin() + std::min(b + 64, Trajs.size())));
+	    Pipeline.Close();
+	    BOOST_CHECK_THROW(Pipeline.Push({}), std::logic_error);
+	}
+    }
+    auto read = [](const std::string& fname) {
+	std::ifstream ifs(fname);
+	return std::string(std::istreambuf_iterator<char>(ifs), {});
+    };
+    for (size_t nThreads : { 1, 2, 6 }) {
+	for (size_t k = 0; k < 6; ++k) {
+	    const std::string a = dir + "async" + std::to_string(nThreads) + std::to_string(k) + ".dat";
+	    BOOST_TEST(read(a) == read(dir + "sync" + std::to_string(k) + ".dat"));
+	    std::filesystem::remove(a);
+	}
+    }
+    for (size_t k = 0; k < 6; ++k)
+	std::filesystem::remove(dir + "sync" + std::to_string(k) + ".dat");
+}
+
+/**@brief Trajectories recorded into a reused arena match those of `getTrajectory`, and the arena
+ * grows only for larger batches
+ */
+BOOST_AUTO_TEST_CASE(ensemble_arena) {
+    config::configure_compiletime(0, 0);
+    ScatteringMap<float_> Map(config::d);
+    const std::vector<size_t> iterates = { 0, 3, 7, 40 };
+    const std::vector<float_> times = { 0., 2.5, 30. };
+    EnsembleTrajectory<float_> Trajs;
+    for (const size_t n : { 50, 20, 50 }) {
+	Trajs.Reset(n, iterates.size());
+	const size_t capacity = Trajs.Capacity();
+	for (size_t j = 0; j < n; ++j) {
+	    SParticle<float_> SP(0.01*j, -1.5 + 0.06*j), SPView = SP;
+	    Map.getTrajectory(SPView, iterates, Trajs[j]);
+	    const STrajectory<float_> Traj = Map.getTrajectory(SP, iterates);
+	    const TrajectoryView<float_> View = Trajs[j];
+	    BOOST_TEST(View.nIterations == Traj.nIterations);
+	    BOOST_TEST(std::ranges::equal(View.H, Traj.H));
+	    BOOST_TEST(std::ranges::equal(View.Time, Traj.Time));
+	    BOOST_TEST(std::ranges::equal(View.Label, Traj.Label));
+	    BOOST_TEST(std::ranges::equal(View.Position, Traj.Position));
+	    BOOST_TEST(View.getItineraryCodes() == Traj.getItineraryCodes());
+	}
+	BOOST_TEST(Trajs.Capacity() == capacity);
+	BOOST_TEST(Trajs.size() == n);
+    }
+    const size_t capacity = Trajs.Capacity();
+    Trajs.Reset(10, times.size());
+    BOOST_TEST(Trajs.Capacity() == capacity);
+    BOOST_TEST(Trajs[3].Label[0] == -1); // Cleared as a new STrajectory
+    SParticle<float_> SP(0.2, 0.3), SPView = SP;
+    Map.getTrajectory(SPView, times, Trajs[3]);
+    const STrajectory<float_> Traj = Map.getTrajectory(SP, times);
+    BOOST_TEST(std::ranges::equal(Trajs[3].Time, Traj.Time));
+    BOOST_TEST(std::ranges::equal(Trajs[3].Theta, Traj.Theta));
+}
+
+/**@brief Batches of at most `MaxBatch` trajectories keep the arenas of a pipeline within its budget,
+ * however long the trajectories
+ */
+BOOST_AUTO_TEST_CASE(batch_budget) {
+    const EnsembleTrajectory<float_> Trajs(7, 13);
+    BOOST_TEST(Trajs.Capacity() == 7*13*EnsembleTrajectory<float_>::BytesPerEntry());
+    for (const size_t N : { 0, 1, 6, 1000, 1000000, 1000000000 }) {
+	const size_t n = TrajectoryPipeline<float_>::MaxBatch(N);
+	BOOST_TEST(n >= 1u);
+	if (n > 1)
+	    BOOST_TEST(PIPELINE_ARENAS*n*N*EnsembleTrajectory<float_>::BytesPerEntry() <= PIPELINE_BYTES);
+    }
+    BOOST_TEST(TrajectoryPipeline<float_>::MaxBatch(6) > 10000u); // Short trajectories are not limited
+    BOOST_TEST(TrajectoryPipeline<float_>::MaxBatch(1000000000) == 1u);
+}
+
+/**@brief Whole batches written as blocks are identical to writing trajectory by trajectory
+ */
+BOOST_AUTO_TEST_CASE(ensemble_block_write) {
+    config::configure_compiletime(0, 1);
+    ScatteringMap<float_> Map(config::d);
+    const std::vector<size_t> iterates = { 0, 1, 5, 20 };
+    EnsembleTrajectory<float_> Trajs(100, iterates.size());
+    std::vector<STrajectory<float_>> Single;
+    for (size_t j = 0; j < Trajs.size(); ++j) {
+	SParticle<float_> SP(0.009*j, -1.5 + 0.03*j), SPView = SP;
+	Map.getTrajectory(SPView, iterates, Trajs[j]);
+	Single.push_back(Map.getTrajectory(SP, iterates));
+    }
+    const std::string dir = std::filesystem::temp_directory_path().string() + "/Pipeline_TEST_block_";
+    auto read = [](const std::string& fname) {
+	std::ifstream ifs(fname, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(ifs), {});
+    };
+    for (const std::string ext : { ".dat", ".npy" }) {
+	{
+	    std::array<Writer,6> block, rows;
+	    for (size_t k = 0; k < block.size(); ++k) {
+		block[k] = Writer(dir + "block" + std::to_string(k) + ext);
+		rows[k] = Writer(dir + "rows" + std::to_string(k) + ext);
+	    }
+	    Trajs.Write(block);
+	    for (const auto& Traj : Single)
+		Traj.Write(rows);
+	}
+	for (size_t k = 0; k < 6; ++k) {
+	    BOOST_TEST(read(dir + "block" + std::to_string(k) + ext) == read(dir + "rows" + std::to_string(k) + ext));
+	    std::filesystem::remove(dir + "block" + std::to_string(k) + ext);
+	    std::filesystem::remove(dir + "rows" + std::to_string(k) + ext);
+	}
+    }
+}
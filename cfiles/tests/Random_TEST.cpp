@@ -0,0 +1,60 @@
+/*@brief Tests of the counter-based generator and reproducible sampling
+*/ 
+
+#include <iostream>
+#include <vector>
+
+#include "json.hpp"	   // https://github.com/nlohmann/json
+#include "config.h"        
+#include "Random.h"        
+#include "SMapHelper.h"    
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Random
+#include <boost/test/unit_test.hpp>
+
+/**@brief Known answers for Philox4x32-10 from the Random123 distribution
+ */
+BOOST_AUTO_TEST_CASE(philox_known_answers) {
+    auto zero = Philox::Block({ 0, 0, 0, 0 }, { 0, 0 });
+    BOOST_TEST((zero == std::array<std::uint32_t,4>{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }));
+    auto ones = Philox::Block({ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff });
+    BOOST_TEST((ones == std::array<std::uint32_t,4>{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }));
+    auto pi = Philox::Block({ 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 });
+    BOOST_TEST((pi == std::array<std::uint32_t,4>{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }));
+}
+
+/**@brief Streams are reproducible, distinct and resumable
+ */
+BOOST_AUTO_TEST_CASE(philox_streams) {
+    Philox a(42, 7), b(42, 7), c(42, 8), d(43, 7);
+    std::vector<std::uint64_t> va, vb, vc, vd;
+    for (size_t i = 0; i < 9; ++i) {
+	va.push_back(a());
+	vb.push_back(b());
+	vc.push_back(c());
+	vd.push_back(d());
+    }
+    BOOST_TEST(va == vb);
+    BOOST_TEST(va != vc);
+    BOOST_TEST(va != vd);
+    BOOST_TEST(a.getPosition() == 9u);
+
+    Philox e(42, 7);
+    e.setPosition(5);
+    BOOST_TEST(e() == va[5]);
+}
+
+/**@brief Any initial condition can be regenerated on its own 
+ */
+BOOST_AUTO_TEST_CASE(seeded_region_points) {
+    config::configure_compiletime(0, 0);
+    config::seed = 12345;
+    for (auto label : config::regionLabels) {
+	auto [h, theta] = getSeededPointsInRegion<double>(label, 0, 20);
+	auto [h7, theta7] = getSeededPointsInRegion<double>(label, 7, 1);
+	BOOST_TEST(h7[0] == h[7]);
+	BOOST_TEST(theta7[0] == theta[7]);
+	BOOST_TEST(whichRegion<double>(h[7], theta[7]) == label);
+    }
+}
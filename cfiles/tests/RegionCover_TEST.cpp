@@ -0,0 +1,80 @@
+#include <cmath>
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "RegionCover.h"
+#include "SMapHelper.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE RegionCover
+#include <boost/test/unit_test.hpp>
+
+/**@brief Every point of a region must lie in its covering
+ */
+BOOST_AUTO_TEST_CASE(cover_contains_region) {
+    const size_t nH = 600, nTheta = 1200;
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	const auto& covers = getRegionCovers();
+	size_t missed = 0;
+	for (size_t i = 1; i < nH; ++i) {
+	    const double h = config::d*i/nH;
+	    for (size_t j = 1; j < nTheta; ++j) {
+		const double theta = -PI2 + PI*j/nTheta;
+		const int label = whichRegion<double>(h, theta);
+		if (label == -1) continue;
+		const RegionCover& C = covers[label];
+		bool inside = false;
+		for (size_t r = 0; r < C.strip.size() && !inside; ++r)
+		    inside = (h >= C.hA[r] && h <= C.hB[r] && theta >= C.thetaLo[r] && theta <= C.thetaHi[r]);
+		missed += !inside;
+	    }
+	}
+	BOOST_TEST(missed == 0u);
+    }
+}
+
+/**@brief Sampled points are in the right region and uniform in it
+ */
+BOOST_AUTO_TEST_CASE(sampled_points) {
+    config::configure_compiletime(0, 0);
+    Random<double> rng(7, 0);
+    const int label = 6;
+
+    // Mean height of region 6 from a fine grid
+    const size_t nH = 1000, nTheta = 2000;
+    double sum = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < nH; ++i) {
+	const double h = config::d*(i + 0.5)/nH;
+	for (size_t j = 0; j < nTheta; ++j) {
+	    if (whichRegion<double>(h, -PI2 + PI*(j + 0.5)/nTheta) == label) {
+		sum += h;
+		count++;
+	    }
+	}
+    }
+    const size_t N = 20000;
+    auto [h, theta] = getPointsInRegion<double>(label, N, rng);
+    double mean = 0;
+    for (size_t i = 0; i < N; ++i) {
+	BOOST_TEST(whichRegion<double>(h[i], theta[i]) == label);
+	mean += h[i]/N;
+    }
+    BOOST_TEST(std::abs(mean - sum/count) < 0.005); // ~3 standard errors
+
+    // Joint fill returns the requested number of points in each region
+    std::vector<int> labels = { 0, 2, 11, 16 };
+    std::vector<size_t> counts = { 50, 10, 0, 30 };
+    auto points = getPointsInRegions<double>(labels, counts, rng);
+    for (size_t i = 0; i < labels.size(); ++i) {
+	const auto& [hs, thetas] = points[i];
+	BOOST_TEST(hs.size() == counts[i]);
+	for (size_t k = 0; k < hs.size(); ++k)
+	    BOOST_TEST(whichRegion<double>(hs[k], thetas[k]) == labels[i]);
+    }
+    BOOST_CHECK_THROW(getPointsInRegion<double>(25, 1, rng), std::invalid_argument);
+    config::configure_compiletime(0, 1);
+    BOOST_CHECK_THROW(getPointsInRegion<double>(7, 1, rng), std::invalid_argument);
+}
@@ -34,3 +34,34 @@ BOOST_AUTO_TEST_CASE(itinerary_test) {
 	}
     }
 }
+
+/**@brief Itinerary codes hold the label and number of bounces, and decode to the itinerary of the state
+ */
+BOOST_AUTO_TEST_CASE(itinerary_codes) {
+    for (size_t i = 0; i < config::channel_widths.size(); ++i) {
+	config::configure_compiletime(0, i);
+	const double d = config::d;
+	for (auto label : config::regionLabels) {
+	    auto [h, theta] = getPointsInRegion<double>(label, 50);
+	    for (size_t k = 0; k < h.size(); ++k) {
+		const std::int64_t code = getItineraryCode(h[k], theta[k], label);
+		BOOST_TEST(code % (std::int64_t)N_LABELS == label);
+		std::string expected = config::itineraries[label];
+		if (i == 0 && (label == 1 || label == 12 || label == 18)) {
+		    const int_ll n = (label == 1) ? alpha(d, h[k], theta[k]) 
+				   : (label == 12) ? kappa(d, h[k], theta[k]) : gamma(d, h[k], theta[k]);
+		    BOOST_TEST(code / (std::int64_t)N_LABELS == n);
+		    for (int_ll b = 0; b < n; ++b)
+			expected += (label == 1) ? "04" : "31";
+		    expected += "R";
+		} else {
+		    BOOST_TEST(code == label);
+		}
+		BOOST_TEST(getItineraryFromCode(code) == expected);
+		BOOST_TEST(getItineraryFromLabel(h[k], theta[k], label) == expected);
+	    }
+	}
+	BOOST_TEST(getItineraryCode(0.1, 0.1, -1) == -1);
+	BOOST_TEST(getItineraryFromCode(-1) == "NULL");
+    }
+}
@@ -0,0 +1,130 @@
+/*@brief Tests of the fused step of the scattering map
+*/
+
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "Geometry.h"
+#include "SMapHelper.h"
+#include "ScatteringMap.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ScatteringMap
+#include <boost/test/unit_test.hpp>
+
+/**@brief Iterates with the unfused `SHatMap`
+ */
+template <typename T>
+ParticleEnsemble<T> evolveUnfused(ParticleEnsemble<T> PE, const size_t& nSteps) {
+    ScatteringMap<T> Map(config::d);
+    for (size_t i = 0; i < PE.size(); ++i) {
+	for (size_t n = 0; n < nSteps; ++n) {
+	    bool dirFlag = false;
+	    Map.SHatMap(PE.H[i], PE.Theta[i], PE.Tau[i], PE.Position[i], PE.Label[i], dirFlag);
+	}
+    }
+    return PE;
+}
+
+/**@brief `Step` reproduces `SHatMap` exactly, for every classifier and geometry
+ */
+BOOST_AUTO_TEST_CASE(fused_step_matches_SHatMap) {
+    const size_t nParticles = 2000, nSteps = 500;
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	ParticleEnsemble<float_> Initial;
+	for (size_t j = 0; j < nParticles; ++j)
+	    Initial.Add(SParticle<float_>());
+	const ParticleEnsemble<float_> Expected = evolveUnfused(Initial, nSteps);
+	for (auto classifier : { RegionClassifier::Exact, RegionClassifier::Tangent, RegionClassifier::Index }) {
+	    config::classifier = classifier;
+	    ParticleEnsemble<float_> A = Initial, B = Initial;
+	    ScatteringMap<float_>(config::d).EvolveBatch(A, nSteps);
+	    withGeometry([&](auto G) { ScatteringMap<float_, decltype(G)>().EvolveBatch(B, nSteps); });
+	    for (const auto& PE : { A, B }) {
+		BOOST_TEST(PE.H == Expected.H);
+		BOOST_TEST(PE.Theta == Expected.Theta);
+		BOOST_TEST(PE.Tau == Expected.Tau);
+		BOOST_TEST(PE.Position == Expected.Position);
+		BOOST_TEST(PE.Label == Expected.Label);
+	    }
+	}
+	config::classifier = RegionClassifier::Exact;
+    }
+}
+
+/**@brief In float, `Step` reproduces `SHatMap` for every classifier as well
+ */
+BOOST_AUTO_TEST_CASE(float_step_matches_SHatMap) {
+    const size_t nParticles = 500, nSteps = 100;
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	// Seeded, since a float state may land exactly on a boundary and have no region
+	Random<float> rng(11, w);
+	ParticleEnsemble<float> Initial;
+	for (size_t j = 0; j < nParticles; ++j) {
+	    const float h = rng.getUniformRandom(0, config::d);
+	    Initial.Add(SParticle<float>(h, rng.getUniformRandom(-PI2, PI2)));
+	}
+	const ParticleEnsemble<float> Expected = evolveUnfused(Initial, nSteps);
+	for (auto classifier : { RegionClassifier::Exact, RegionClassifier::Tangent, RegionClassifier::Index }) {
+	    config::classifier = classifier;
+	    ParticleEnsemble<float> A = Initial;
+	    ScatteringMap<float>(config::d).EvolveBatch(A, nSteps);
+	    BOOST_TEST(A.H == Expected.H);
+	    BOOST_TEST(A.Theta == Expected.Theta);
+	    BOOST_TEST(A.Position == Expected.Position);
+	    BOOST_TEST(A.Label == Expected.Label);
+	}
+	config::classifier = RegionClassifier::Exact;
+    }
+}
+
+/**@brief A state without a region is rejected as by `SHatMap`
+ */
+BOOST_AUTO_TEST_CASE(invalid_label) {
+    config::configure_compiletime(0, 0);
+    ScatteringMap<float_> Map(config::d);
+    float_ h = 0.25, theta = 0.1, tau = 0;
+    int_ll x = 0;
+    int label = -1;
+    BOOST_CHECK_THROW(Map.Step(h, theta, tau, x, label), std::runtime_error);
+}
+
+/**@brief Particles left without a region go to the side list, and the rest of the batch is unaffected
+ */
+BOOST_AUTO_TEST_CASE(unresolved_side_list) {
+    config::configure_compiletime(0, 0);
+    Random<float_> rng(5, 0);
+    ParticleEnsemble<float_> A;
+    for (size_t j = 0; j < 100; ++j) {
+	const float_ h = rng.getUniformRandom(0, config::d);
+	A.Add(SParticle<float_>(h, rng.getUniformRandom(-PI2, PI2)));
+    }
+    ParticleEnsemble<float_> B = A;
+    B.Add(SParticle<float_>(0, 0.1)); // On the bottom corner, in no region
+    ScatteringMap<float_> Map(config::d);
+    BOOST_TEST(Map.EvolveBatch(A, 300).empty());
+    BOOST_TEST(Map.EvolveBatch(B, 300) == std::vector<size_t>{ 100 });
+    BOOST_TEST(B.Label.back() == -1);
+    BOOST_TEST(A.H == std::vector<float_>(B.H.begin(), B.H.end() - 1));
+    BOOST_TEST(A.Label == std::vector<int>(B.Label.begin(), B.Label.end() - 1));
+}
+
+/**@brief States that float places on a boundary are resolved in `float_wide` rather than aborting the batch
+ */
+BOOST_AUTO_TEST_CASE(float_boundary_escalation) {
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	Random<float> rng(3, w);
+	ParticleEnsemble<float> PE;
+	for (size_t j = 0; j < 20000; ++j) {
+	    const float h = rng.getUniformRandom(0, config::d);
+	    PE.Add(SParticle<float>(h, rng.getUniformRandom(-PI2, PI2)));
+	}
+	std::vector<size_t> Unresolved;
+	BOOST_CHECK_NO_THROW(Unresolved = ScatteringMap<float>(config::d).EvolveBatch(PE, 500));
+	BOOST_TEST(Unresolved.empty());
+    }
+}
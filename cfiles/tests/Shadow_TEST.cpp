@@ -0,0 +1,62 @@
+/*@brief Tests of shadow runs in float against double
+*/
+
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "Shadow.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Shadow
+#include <boost/test/unit_test.hpp>
+
+/**@brief Initial conditions drawn uniformly over the channel
+ */
+void sampleInitial(std::vector<double>& h, std::vector<double>& theta, const size_t& n) {
+    Random<double> rng(7, 0);
+    for (size_t i = 0; i < n; ++i) {
+	h.push_back(rng.getUniformRandom(0, config::d));
+	theta.push_back(rng.getUniformRandom(-PI2, PI2));
+    }
+}
+
+/**@brief A precision shadowing itself never diverges
+ */
+BOOST_AUTO_TEST_CASE(same_precision) {
+    config::configure_compiletime(0, 0);
+    std::vector<double> h, theta;
+    sampleInitial(h, theta, 200);
+    const ShadowReport Report = ShadowRun<double, double>(h, theta, 300);
+    BOOST_TEST(Report.size() == 200u);
+    BOOST_TEST(Report.FractionDiverged(300) == 0);
+    BOOST_TEST(Report.TrustedIterates(0.01) == 300u);
+    BOOST_TEST(Report.Quantile(0) == 301u);
+}
+
+/**@brief Float runs diverge from double at a finite horizon, and the report summarises it consistently
+ */
+BOOST_AUTO_TEST_CASE(float_against_double) {
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	std::vector<double> h, theta;
+	sampleInitial(h, theta, 500);
+	const size_t nSteps = 5000;
+	const ShadowReport Report = ShadowRun<float>(h, theta, nSteps);
+	BOOST_TEST(Report.precision == "float");
+	BOOST_TEST(Report.FractionDiverged(nSteps) > 0.5);
+	// Float agrees with double over the first iterates
+	BOOST_TEST(Report.Quantile(0.5) > 10u);
+	const size_t trusted = Report.TrustedIterates(0.05);
+	BOOST_TEST(Report.FractionDiverged(trusted) <= 0.05);
+	BOOST_TEST(Report.FractionDiverged(trusted + 1) > 0.05);
+	ShadowReport Merged = Report;
+	Merged.Add(Report);
+	BOOST_TEST(Merged.size() == 2*Report.size());
+	BOOST_TEST(Merged.TrustedIterates(0.05) == trusted);
+	ShadowReport Other;
+	Other.nSteps = 1;
+	Other.firstDivergence = { 0 };
+	BOOST_CHECK_THROW(Merged.Add(Other), std::invalid_argument);
+    }
+}
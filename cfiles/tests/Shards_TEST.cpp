@@ -0,0 +1,128 @@
+/*@brief Tests of sharded runs and the merging of their files
+*/
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "config.h"
+#include "Production.h"
+#include "Shards.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Shards
+#include <boost/test/unit_test.hpp>
+#include "utils_TEST.h"
+
+const std::string dir = std::filesystem::temp_directory_path().string() + "/Shards_TEST/";
+
+/**@brief Points the files of the study at the empty directory `dir`
+ */
+void useTestDataPath() {
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    config::DataPath = dir;
+    config::writeJSONConfig();
+}
+
+/**@brief Checks that the runs left no files in `dir`, removes it and points the files of the study
+ * back at its data directory
+ */
+void resetDataPath() {
+    BOOST_TEST(std::filesystem::is_empty(dir));
+    std::filesystem::remove_all(dir);
+    config::DataPath = config::BaseDataPath + config::Study + "/";
+    config::writeJSONConfig();
+}
+
+/**@brief Runs `driver` in one process, then in N shards that are merged, and checks that every
+ * file in `keys` is the same
+ */
+template <typename F>
+void checkShardedRun(const size_t& N, const std::vector<std::string>& keys, F&& driver) {
+    const nlohmann::json jfiles = config::getJSONFiles();
+    driver();
+    std::vector<std::string> reference;
+    for (const auto& key : keys)
+	reference.push_back(readFile(jfiles[key]));
+    config::shardCount = N;
+    for (size_t i = 0; i < N; ++i) {
+	config::shardIndex = i;
+	driver();
+    }
+    config::shardIndex = 0;
+    config::shardCount = 1;
+    for (size_t k = 0; k < keys.size(); ++k) {
+	const std::string fname = jfiles[keys[k]];
+	std::filesystem::remove(fname);
+	MergeShards(fname, N, keys[k].starts_with("Regions"));
+	BOOST_TEST(reference[k].size() > 0u);
+	BOOST_TEST((readFile(fname) == reference[k]), fname + " differs when merged from " + std::to_string(N) + " shards");
+	std::filesystem::remove(fname);
+	for (size_t i = 0; i < N; ++i)
+	    std::filesystem::remove(config::getShardName(fname, i, N));
+    }
+}
+
+/**@brief Trajectories of regions and of a rectangle merged from shards are those of a single run,
+ * in every output format
+ */
+BOOST_AUTO_TEST_CASE(trajectories_merge_bit_identically) {
+    config::configure_compiletime(0, 0);
+    config::seed = 2024;
+    useTestDataPath();
+    const std::vector<std::string> keys = { "H", "Time", "Theta", "Labels", "Positions", "Itineraries" };
+    for (const std::string format : { "text", "npy", "packed" }) {
+	config::outputFormat = format;
+	config::writeJSONConfig();
+	for (const size_t N : { 2, 7 }) {
+	    checkShardedRun(N, keys, [] {
+		WriteTrajectoryData<float_>(150, 12, std::vector<int>{ 0, 5, 9 }, std::vector<float_>(20, 1.));
+	    });
+	    checkShardedRun(N, keys, [] {
+		WriteTrajectoryData<float_>(300, 12, std::pair<float_,float_>{ 0.1, 0.4 }, std::pair<float_,float_>{ -1., 1. });
+	    });
+	}
+    }
+    config::outputFormat = "text";
+    resetDataPath();
+}
+
+/**@brief Region points merged from shards are those of a single run, also with shards of no points
+ */
+BOOST_AUTO_TEST_CASE(region_points_merge_bit_identically) {
+    config::configure_compiletime(0, 0);
+    config::seed = 2024;
+    useTestDataPath();
+    for (const size_t N : { 3, 100 }) // More shards than passes of WriteRegionPoints
+	checkShardedRun(N, { "Regions-H", "Regions-Theta" }, [] {
+	    WriteRegionPoints<float_>(500, { 1, 4, 14 }, std::vector<float_>(20, 1.));
+	});
+    resetDataPath();
+}
+
+/**@brief Shard names, slices and missing shards
+ */
+BOOST_AUTO_TEST_CASE(shard_slices) {
+    BOOST_TEST(config::getShardName("data/H.npy", 1, 4) == "data/H.shard-1-of-4.npy");
+    BOOST_TEST(config::getShardName("data/H.npy", 0, 1) == "data/H.npy");
+    config::shardCount = 3;
+    size_t total = 0;
+    for (size_t i = 0; i < 3; ++i) { // Calls of 10, 0 and 20 initial conditions
+	config::shardIndex = i;
+	const auto a = getShardSlice(0, 10, 30), b = getShardSlice(10, 0, 30), c = getShardSlice(10, 20, 30);
+	BOOST_TEST(b.first == b.second);
+	total += (a.second - a.first) + (c.second - c.first);
+    }
+    config::shardIndex = 0;
+    BOOST_TEST((getShardSlice(0, 10, 30) == std::pair<size_t,size_t>{ 0, 10 }));
+    BOOST_TEST((getShardSlice(10, 20, 30) == std::pair<size_t,size_t>{ 0, 0 }));
+    config::shardIndex = 2;
+    BOOST_TEST((getShardSlice(10, 20, 30) == std::pair<size_t,size_t>{ 10, 20 }));
+    config::shardIndex = 0;
+    config::shardCount = 1;
+    BOOST_TEST(total == 30u);
+    BOOST_CHECK_THROW(MergeShards(dir + "H.npy", 2),
+		      std::runtime_error);
+}
@@ -0,0 +1,71 @@
+/*@brief Tests of time-synchronous ensemble snapshots
+*/
+
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "ScatteringMap.h"
+#include "ThreadPool.h"
+#include "Production.h"
+#include "Snapshot.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Snapshot
+#include <boost/test/unit_test.hpp>
+#include "utils_TEST.h"
+
+/**@brief Snapshots hold, particle by particle, the states recorded by `getTrajectory(SP, Time)`
+ */
+BOOST_AUTO_TEST_CASE(matches_trajectories) {
+    const std::vector<float_> Time = { 0., 0.5, 1., 1.01, 7.3, 20., 20., 55.5, 200. };
+    const size_t nParticles = 500;
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	ScatteringMap<float_> Map(config::d);
+	std::vector<STrajectory<float_>> Trajs;
+	for (size_t j = 0; j < nParticles; ++j) {
+	    SParticle<float_> SP = getTestParticle(j);
+	    Trajs.push_back(Map.getTrajectory(SP, Time));
+	}
+	ThreadPool Pool(3);
+	size_t nSnapshots = 0;
+	EvolveSnapshots<float_>(Pool, nParticles, getTestParticle, Time, [&](const EnsembleSnapshot<float_>& Snapshot) {
+	    const size_t k = Snapshot.index;
+	    BOOST_TEST(k == nSnapshots++);
+	    BOOST_TEST(Snapshot.t == Time[k]);
+	    const ParticleEnsemble<float_>& S = Snapshot.State;
+	    for (size_t j = 0; j < nParticles; ++j) {
+		const STrajectory<float_>& Traj = Trajs[j];
+		BOOST_TEST(S.H[j] == Traj.H[k]);
+		BOOST_TEST(S.Theta[j] == Traj.Theta[k]);
+		BOOST_TEST(S.Tau[j] == Traj.Tau[k]);
+		BOOST_TEST(S.Position[j] == Traj.Position[k]);
+		BOOST_TEST(S.Label[j] == Traj.Label[k]);
+		BOOST_TEST(Snapshot.Time[j] == Traj.Time[k]);
+	    }
+	});
+	BOOST_TEST(nSnapshots == Time.size());
+    }
+}
+
+/**@brief Histograms count every particle once, in the bin of its position or the last one
+ */
+BOOST_AUTO_TEST_CASE(position_histogram) {
+    config::configure_compiletime(0, 1);
+    const size_t nParticles = 1000;
+    const int_ll maxDisplacement = 3;
+    ThreadPool Pool(2);
+    EvolveSnapshots<float_>(Pool, nParticles, getTestParticle, std::vector<float_>{ 1., 10., 100. },
+			    [&](const EnsembleSnapshot<float_>& Snapshot) {
+	const std::vector<std::uint64_t> counts = getPositionHistogram(Snapshot, maxDisplacement);
+	BOOST_TEST(counts.size() == 2*maxDisplacement + 2);
+	BOOST_TEST(std::accumulate(counts.begin(), counts.end(), (std::uint64_t)0) == nParticles);
+	std::uint64_t atZero = 0;
+	for (const auto& x : Snapshot.State.Position)
+	    atZero += (x == 0);
+	BOOST_TEST(counts[maxDisplacement] == atZero);
+    });
+    BOOST_CHECK_THROW(EvolveSnapshots<float_>(Pool, 10, getTestParticle, std::vector<float_>{ 2., 1. },
+					      [](const EnsembleSnapshot<float_>&) { }), std::invalid_argument);
+}
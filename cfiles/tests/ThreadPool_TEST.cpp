@@ -0,0 +1,40 @@
+/*@brief Tests of the work-stealing thread pool used by the production drivers
+*/ 
+
+#include <iostream>
+#include <vector>
+
+#include "config.h"        
+#include "ThreadPool.h"    
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ThreadPool
+#include <boost/test/unit_test.hpp>
+
+/**@brief Every index is visited exactly once, for any chunk size and across repeated jobs
+ */
+BOOST_AUTO_TEST_CASE(covers_range_once) {
+    ThreadPool Pool(8);
+    for (size_t chunk : { 1, 3, 64, 1000 }) {
+	for (size_t n : { 1, 7, 1000, 12345 }) {
+	    std::vector<int> visits(n, 0);
+	    Pool.ParallelFor(n, chunk, [&](size_t first, size_t last, size_t) {
+		for (size_t i = first; i < last; ++i) 
+		    visits[i]++;
+	    });
+	    BOOST_TEST(std::count(visits.begin(), visits.end(), 1) == (long)n);
+	}
+    }
+}
+
+/**@brief Exceptions thrown by a job reach the calling thread and the pool remains usable
+ */
+BOOST_AUTO_TEST_CASE(rethrows_exceptions) {
+    ThreadPool Pool(4);
+    BOOST_CHECK_THROW(Pool.ParallelFor(100, 1, [](size_t first, size_t, size_t) {
+	if (first == 50) throw std::runtime_error("ERROR: test");
+    }), std::runtime_error);
+    std::atomic<size_t> total = 0;
+    Pool.ParallelFor(100, 10, [&](size_t first, size_t last, size_t) { total += last - first; });
+    BOOST_TEST(total.load() == 100u);
+}
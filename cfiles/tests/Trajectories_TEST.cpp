@@ -4,6 +4,7 @@
 #include <iostream>
 #include <chrono>
 #include <cmath>
+#include <numeric>
 #include <vector>
 
 #include "json.hpp"	   // https://github.com/nlohmann/json
@@ -101,6 +102,8 @@ BOOST_AUTO_TEST_CASE(localised_traj_2) {
 BOOST_AUTO_TEST_CASE(pos_from_label) {
     size_t n = 10000;
     size_t M = 10000;
+    std::vector<size_t> iterates(n); // Every iterate 0...n-1
+    std::iota(iterates.begin(), iterates.end(), 0);
     std::cout << "Checking label (L/R) to position map..." << std::endl; 
     std::cout << "NOTE: Initial horizontal velocity components which are negative are not being tested." << std::endl;
     for (size_t i = 0; i < 2; ++i) {
@@ -111,7 +114,7 @@ BOOST_AUTO_TEST_CASE(pos_from_label) {
             float_ h_random = runif<float_>(EPSILON, config::d); 
 	    float_ theta_random = runif<float_>(-PI2 + EPSILON, PI2);
             SParticle<float_> particle(h_random,theta_random);
-            STrajectory<float_> random_traj = SM.getTrajectory(particle, n); 
+            STrajectory<float_> random_traj = SM.getTrajectory(particle, iterates); 
 	    BOOST_TEST(random_traj.Position == random_traj.getLiftedPositionsFromLabel(random_traj.Label));
 	    //random_traj.Print(4);
 	}
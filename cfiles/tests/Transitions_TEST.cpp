@@ -0,0 +1,102 @@
+/*@brief Tests of the region-to-region transition counts
+*/
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "ScatteringMap.h"
+#include "ThreadPool.h"
+#include "Production.h"
+#include "Transitions.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Transitions
+#include <boost/test/unit_test.hpp>
+#include "utils_TEST.h"
+
+/**@brief Counts agree with those of recorded trajectories, for every lag and jump
+ */
+BOOST_AUTO_TEST_CASE(matches_trajectories) {
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	const size_t nSteps = 300;
+	const std::vector<size_t> lags = { 1, 2, 5 };
+	std::vector<size_t> iterates(nSteps + 1);
+	std::iota(iterates.begin(), iterates.end(), 0);
+	ScatteringMap<float_> Map(config::d);
+	TransitionCounts Counts(lags, true);
+	std::vector<std::uint64_t> expected(Counts.counts.size());
+	for (size_t p = 0; p < 50; ++p) {
+	    SParticle<float_> SP = getTestParticle(p);
+	    Counts.AddParticle(Map, SP, nSteps);
+	    const STrajectory<float_> Traj = Map.getTrajectory(SP, iterates);
+	    for (size_t l = 0; l < lags.size(); ++l)
+		for (size_t n = lags[l]; n <= nSteps; ++n)
+		    expected[Counts.Index(l, Traj.Label[n - lags[l]], Traj.Label[n], Traj.Position[n] - Traj.Position[n - lags[l]])]++;
+	}
+	BOOST_TEST(Counts.counts == expected);
+	std::uint64_t total = 0;
+	for (size_t i = 0; i < N_LABELS; ++i) {
+	    float_ p = 0;
+	    for (size_t j = 0; j < N_LABELS; ++j) {
+		total += Counts.Count(0, i, j);
+		p += Counts.Probability(0, i, j);
+	    }
+	    BOOST_TEST((p == 0 || std::abs(p - 1) < 1e-12));
+	}
+	BOOST_TEST(total == 50*nSteps);
+    }
+}
+
+/**@brief Reductions over a thread pool do not depend on its number of threads
+ */
+BOOST_AUTO_TEST_CASE(thread_independent) {
+    config::configure_compiletime(0, 0);
+    auto reduce = [](const size_t& nThreads) {
+	ThreadPool Pool(nThreads);
+	return ReduceParticles<float_>(Pool, 500, getTestParticle, TransitionCounts({ 1, 4 }, true),
+				       [](TransitionCounts& C, auto& Map, const SParticle<float_>& SP) {
+	    C.AddParticle(Map, SP, 200);
+	});
+    };
+    BOOST_TEST(reduce(1).counts == reduce(3).counts);
+}
+
+/**@brief Counts written as JSON and NumPy read back unchanged
+ */
+BOOST_AUTO_TEST_CASE(export_round_trip) {
+    config::configure_compiletime(0, 0);
+    ScatteringMap<float_> Map(config::d);
+    TransitionCounts Counts({ 1, 3 }, true);
+    for (size_t p = 0; p < 20; ++p)
+	Counts.AddParticle(Map, getTestParticle(p), 100);
+    const std::string dir = std::filesystem::temp_directory_path().string();
+    Counts.WriteJSON(dir + "/Transitions_TEST.json");
+    const nlohmann::json j = nlohmann::json::parse(std::ifstream(dir + "/Transitions_TEST.json"));
+    BOOST_TEST(j["lags"].get<std::vector<size_t>>() == Counts.lags);
+    BOOST_TEST(j["counts"]["3"][4][7].get<std::uint64_t>() == Counts.Count(1, 4, 7));
+    BOOST_TEST(j["jump_counts"]["3"][4][7][2].get<std::uint64_t>() == Counts.Count(1, 4, 7, -1));
+    Counts.WriteNPY(dir + "/Transitions_TEST.npy");
+    std::ifstream ifs(dir + "/Transitions_TEST.npy", std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    BOOST_TEST(bytes.size() == NPY_HEADER_SIZE + 8*800*7);
+    BOOST_TEST(bytes.find("'shape': (800, 7)") != std::string::npos);
+    std::vector<std::uint64_t> data(800*7), expected(800*7, 0); // Lag 1 padded to the jumps of lag 3
+    std::memcpy(data.data(), bytes.data() + NPY_HEADER_SIZE, 8*data.size());
+    for (size_t l = 0; l < 2; ++l)
+	for (size_t a = 0; a < N_LABELS; ++a)
+	    for (size_t b = 0; b < N_LABELS; ++b)
+		for (int_ll dx = -(int_ll)Counts.lags[l]; dx <= (int_ll)Counts.lags[l]; ++dx)
+		    expected[((l*N_LABELS + a)*N_LABELS + b)*7 + dx + 3] = Counts.Count(l, a, b, dx);
+    BOOST_TEST(data == expected);
+    BOOST_TEST(Counts.counts.size() == N_LABELS*N_LABELS*(3 + 7)); // Each lag stores its own jumps
+    std::filesystem::remove(dir + "/Transitions_TEST.json");
+    std::filesystem::remove(dir + "/Transitions_TEST.npy");
+    BOOST_CHECK_THROW(TransitionCounts({ 0, 1 }), std::invalid_argument);
+    BOOST_CHECK_THROW(Counts.Merge(TransitionCounts({ 1, 3 })), std::invalid_argument);
+    BOOST_CHECK_THROW(TransitionCounts({ 1 }).Count(0, 1, 1, 0), std::invalid_argument);
+}
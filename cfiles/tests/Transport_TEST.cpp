@@ -0,0 +1,125 @@
+/*@brief Tests of the streaming transport statistics
+*/
+
+#include <cmath>
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "ScatteringMap.h"
+#include "ThreadPool.h"
+#include "Production.h"
+#include "Transport.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Transport
+#include <boost/test/unit_test.hpp>
+
+namespace tt = boost::test_tools;
+
+/**@brief Moments, their errors and the diffusion coefficient of known displacements
+ */
+BOOST_AUTO_TEST_CASE(moments_and_diffusion) {
+    const std::vector<float_> times = { 1, 2, 3, 4, 5, 6 };
+    TransportStatistics A(times), B(times);
+    const float_ D = 0.75;
+    for (size_t g = 0; g < times.size(); ++g) {
+	const float_ dx = std::sqrt(2*D*times[g]); // Variance 2Dt
+	A.Add(g, dx, times[g]);
+	A.Add(g, -dx, times[g]);
+	B.Add(g, dx, times[g]);
+    }
+    BOOST_TEST(A.Moment(0, 1) == 0, tt::tolerance(1e-12));
+    BOOST_TEST(A.Moment(0, 2) == 2*D, tt::tolerance(1e-12));
+    BOOST_TEST(A.Moment(0, 4) == 4*D*D, tt::tolerance(1e-12));
+    BOOST_TEST(A.MomentError(0, 1) == std::sqrt(2*D), tt::tolerance(1e-12));
+    BOOST_TEST(A.MeanTime(3) == 4.);
+    const auto [DFit, error] = A.Diffusion();
+    BOOST_TEST(DFit == D, tt::tolerance(1e-9));
+    BOOST_TEST(error < 1e-9);
+    // Merging a copy doubles the counts and leaves the moments unchanged
+    TransportStatistics C = A;
+    C.Merge(A);
+    BOOST_TEST(C.count[2] == 4u);
+    BOOST_TEST(C.Moment(2, 2) == A.Moment(2, 2), tt::tolerance(1e-12));
+    BOOST_CHECK_THROW(C.Merge(TransportStatistics(std::vector<size_t>{ 1, 2 })), std::invalid_argument);
+    BOOST_CHECK_THROW(TransportStatistics(std::vector<float_>{ 2, 1 }), std::invalid_argument);
+}
+
+/**@brief On a grid of iterates, displacements and times are those of the recorded trajectories
+ */
+BOOST_AUTO_TEST_CASE(matches_trajectories) {
+    config::configure_compiletime(0, 1);
+    const std::vector<size_t> iterates = { 0, 10, 50, 100, 200 };
+    Random<float_> rng(9, 0);
+    std::vector<SParticle<float_>> Initial;
+    for (size_t j = 0; j < 200; ++j)
+	Initial.push_back(SParticle<float_>({ 0., config::d }, { -PI2, PI2 }, rng));
+    ScatteringMap<float_> Map(config::d);
+    TransportStatistics Stats(iterates);
+    std::vector<float_> sumX(iterates.size()), sumX2(iterates.size()), sumT(iterates.size());
+    for (const auto& SP : Initial) {
+	Stats.AddParticle(Map, SP);
+	SParticle<float_> P = SP;
+	const STrajectory<float_> Traj = Map.getTrajectory(P, iterates);
+	for (size_t g = 0; g < iterates.size(); ++g) {
+	    sumX[g] += Traj.Position[g];
+	    sumX2[g] += Traj.Position[g]*Traj.Position[g];
+	    sumT[g] += Traj.Time[g];
+	}
+    }
+    for (size_t g = 0; g < iterates.size(); ++g) {
+	BOOST_TEST(Stats.count[g] == Initial.size());
+	BOOST_TEST(Stats.Moment(g, 1) == sumX[g]/Initial.size(), tt::tolerance(1e-12));
+	BOOST_TEST(Stats.Moment(g, 2) == sumX2[g]/Initial.size(), tt::tolerance(1e-12));
+	BOOST_TEST(Stats.MeanTime(g) == sumT[g]/Initial.size(), tt::tolerance(1e-9));
+    }
+}
+
+/**@brief On a grid of times, the displacement is that of the last collision before each time
+ */
+BOOST_AUTO_TEST_CASE(time_grid) {
+    config::configure_compiletime(0, 1);
+    ScatteringMap<float_> Map(config::d);
+    const SParticle<float_> SP(0.3, 0.4);
+    // Collision times and positions
+    std::vector<float_> clock = { 0 };
+    std::vector<int_ll> x = { SP.Position };
+    SParticle<float_> P = SP;
+    for (size_t n = 0; n < 100; ++n) {
+	Map.Evolve(P);
+	clock.push_back(clock.back() + P.Tau);
+	x.push_back(P.Position);
+    }
+    std::vector<float_> times;
+    for (size_t i = 0; i < 20; ++i)
+	times.push_back(clock[50]*i/20);
+    TransportStatistics Stats(times);
+    Stats.AddParticle(Map, SP);
+    for (size_t g = 0; g < times.size(); ++g) {
+	const size_t n = std::ranges::upper_bound(clock, times[g]) - clock.begin() - 1;
+	BOOST_TEST(Stats.count[g] == 1u);
+	BOOST_TEST(Stats.Moment(g, 1) == (float_)(x[n] - x[0]));
+    }
+}
+
+/**@brief Reductions over a thread pool do not depend on its number of threads
+ */
+BOOST_AUTO_TEST_CASE(thread_independent) {
+    config::configure_compiletime(0, 0);
+    const std::vector<size_t> iterates = { 0, 100, 200, 400 };
+    auto reduce = [&](const size_t& nThreads) {
+	ThreadPool Pool(nThreads);
+	return ReduceParticles<float_>(Pool, 1000, [](const size_t& j) {
+	    Random<float_> rng(4, j);
+	    return SParticle<float_>({ 0., config::d }, { -PI2, PI2 }, rng);
+	}, TransportStatistics(iterates), [](TransportStatistics& S, auto& Map, const SParticle<float_>& SP) {
+	    S.AddParticle(Map, SP);
+	});
+    };
+    const TransportStatistics A = reduce(1), B = reduce(3);
+    BOOST_TEST(A.count == B.count);
+    BOOST_TEST((A.sums == B.sums));
+    BOOST_TEST((A.timeSums == B.timeSums));
+    BOOST_TEST(A.count.back() == 1000u);
+}
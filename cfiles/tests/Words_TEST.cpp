@@ -0,0 +1,122 @@
+/*@brief Tests of the streaming word statistics of region labels
+*/
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <vector>
+
+#include "config.h"
+#include "Random.h"
+#include "ScatteringMap.h"
+#include "ThreadPool.h"
+#include "Production.h"
+#include "Words.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Words
+#include <boost/test/unit_test.hpp>
+#include "utils_TEST.h"
+
+/**@brief Counts, entropies and forbidden words of a short periodic sequence
+ */
+BOOST_AUTO_TEST_CASE(periodic_sequence) {
+    WordStatistics Words(3);
+    Words.AddSequence({ 1, 2, 1, 2, 1, 2, -1, 1, 1 }); // Counting stops at -1
+    BOOST_TEST(Words.Count(1, 1) == 3u);
+    BOOST_TEST(Words.Count(1, 2) == 3u);
+    BOOST_TEST(Words.Count(2, 1*N_LABELS + 2) == 3u);
+    BOOST_TEST(Words.Count(2, 2*N_LABELS + 1) == 2u);
+    BOOST_TEST(Words.Count(2, 1*N_LABELS + 1) == 0u);
+    BOOST_TEST(Words.Words(3) == 2u);
+    BOOST_TEST(Words.Total(3) == 4u);
+    BOOST_TEST(Words.BlockEntropy(1) == std::log(2.), boost::test_tools::tolerance(1e-12));
+    BOOST_TEST(Words.BlockEntropy(3) == std::log(2.), boost::test_tools::tolerance(1e-12));
+    const float_ H2 = -0.6*std::log(0.6) - 0.4*std::log(0.4); // Words 1-2 and 2-1 seen 3 and 2 times
+    BOOST_TEST(Words.BlockEntropy(2) == H2, boost::test_tools::tolerance(1e-12));
+    BOOST_TEST(Words.EntropyRate(3) == std::log(2.) - H2, boost::test_tools::tolerance(1e-12));
+    BOOST_TEST(Words.TopologicalEntropy(3) == 0., boost::test_tools::tolerance(1e-12));
+    const std::vector<std::uint64_t> forbidden = { 1*N_LABELS + 1, 2*N_LABELS + 2 };
+    BOOST_TEST(Words.ForbiddenWords(2) == forbidden);
+    BOOST_TEST(Words.ForbiddenWords(3).empty());
+    BOOST_TEST(WordStatistics::toString(1*N_LABELS*N_LABELS + 17*N_LABELS + 3, 3) == "1-17-3");
+    BOOST_CHECK_THROW(WordStatistics(0), std::invalid_argument);
+    BOOST_CHECK_THROW(WordStatistics(WORDS_MAX_LENGTH + 1), std::invalid_argument);
+    BOOST_CHECK_THROW(Words.Merge(WordStatistics(2)), std::invalid_argument);
+}
+
+/**@brief Streamed counts agree with those of recorded trajectories, also for the longest words
+ */
+BOOST_AUTO_TEST_CASE(matches_trajectories) {
+    for (size_t w = 0; w < config::channel_widths.size(); ++w) {
+	config::configure_compiletime(0, w);
+	const size_t nSteps = 300;
+	std::vector<size_t> iterates(nSteps + 1);
+	std::iota(iterates.begin(), iterates.end(), 0);
+	ScatteringMap<float_> Map(config::d);
+	WordStatistics Words(WORDS_MAX_LENGTH), FromLabels(WORDS_MAX_LENGTH);
+	for (size_t p = 0; p < 50; ++p) {
+	    SParticle<float_> SP = getTestParticle(p);
+	    Words.AddParticle(Map, SP, nSteps);
+	    const STrajectory<float_> Traj = Map.getTrajectory(SP, iterates);
+	    FromLabels.AddSequence(Traj.Label);
+	    for (const size_t k : { (size_t)1, (size_t)5, WORDS_MAX_LENGTH }) {
+		std::uint64_t word = 0;
+		for (size_t i = 0; i < k; ++i)
+		    word = word*N_LABELS + Traj.Label[nSteps - k + 1 + i];
+		BOOST_TEST(FromLabels.Count(k, word) > 0u);
+	    }
+	}
+	for (size_t k = 1; k <= WORDS_MAX_LENGTH; ++k) {
+	    BOOST_TEST((Words.counts[k-1] == FromLabels.counts[k-1]));
+	    BOOST_TEST(Words.Total(k) == 50*(nSteps + 2 - k));
+	}
+    }
+}
+
+/**@brief Reductions over a thread pool do not depend on its number of threads
+ */
+BOOST_AUTO_TEST_CASE(thread_independent) {
+    config::configure_compiletime(0, 0);
+    auto reduce = [](const size_t& nThreads) {
+	ThreadPool Pool(nThreads);
+	return ReduceParticles<float_>(Pool, 500, getTestParticle, WordStatistics(6),
+				       [](WordStatistics& W, auto& Map, const SParticle<float_>& SP) {
+	    W.AddParticle(Map, SP, 200);
+	});
+    };
+    const WordStatistics One = reduce(1), Three = reduce(3);
+    for (size_t k = 1; k <= 6; ++k)
+	BOOST_TEST((One.counts[k-1] == Three.counts[k-1]));
+}
+
+/**@brief Statistics written as JSON and NumPy read back unchanged
+ */
+BOOST_AUTO_TEST_CASE(export_round_trip) {
+    config::configure_compiletime(0, 0);
+    ScatteringMap<float_> Map(config::d);
+    WordStatistics Words(4);
+    for (size_t p = 0; p < 20; ++p)
+	Words.AddParticle(Map, getTestParticle(p), 100);
+    const std::string dir = std::filesystem::temp_directory_path().string();
+    Words.WriteJSON(dir + "/Words_TEST.json");
+    const nlohmann::json j = nlohmann::json::parse(std::ifstream(dir + "/Words_TEST.json"));
+    BOOST_TEST(j["max_length"].get<size_t>() == 4u);
+    BOOST_TEST(j["words"][2].get<size_t>() == Words.Words(3));
+    BOOST_TEST(j["block_entropy"][3].get<float_>() == Words.BlockEntropy(4));
+    BOOST_TEST(j["forbidden"]["2"].size() == Words.ForbiddenWords(2).size());
+    const nlohmann::json counts = j["counts"]["2"];
+    for (const auto& [word, c] : Words.counts[1])
+	BOOST_TEST(counts[WordStatistics::toString(word, 2)].get<std::uint64_t>() == c);
+    Words.WriteNPY(dir + "/Words_TEST.npy");
+    std::ifstream ifs(dir + "/Words_TEST.npy", std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    size_t rows = 0;
+    for (size_t k = 1; k <= 4; ++k)
+	rows += Words.Words(k);
+    BOOST_TEST(bytes.size() == NPY_HEADER_SIZE + 3*8*rows);
+    BOOST_TEST(bytes.find("'shape': (" + std::to_string(rows) + ", 3)") != std::string::npos);
+    std::filesystem::remove(dir + "/Words_TEST.json");
+    std::filesystem::remove(dir + "/Words_TEST.npy");
+}
@@ -0,0 +1,51 @@
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "config.h"
+#include "Writer.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Writer
+#include <boost/test/unit_test.hpp>
+#include "utils_TEST.h"
+
+/**@brief .npy files hold a valid header with the final shape followed by the raw rows
+ */
+BOOST_AUTO_TEST_CASE(npy_rows) {
+    const std::string fname = std::filesystem::temp_directory_path().string() + "/Writer_TEST.npy";
+    std::vector<std::vector<double>> data = {{ 0.1, -2., 3e-300, 4.5 }, { 5., 6., 7., 8. }, { 9., 10., 11., 12. }};
+    {
+	Writer w;
+	w = Writer(fname); // As in `getTrajectoryWriters`
+	for (const auto& row : data)
+	    w.WriteRowVector<double>(row);
+	BOOST_CHECK_THROW(w.WriteRowVector<double>({ 1. }), std::invalid_argument);
+	BOOST_CHECK_THROW(w.WriteRowVector<int>({ 1, 2, 3, 4 }), std::invalid_argument);
+    }
+    const std::string file = readFile(fname);
+    BOOST_TEST(file.size() == NPY_HEADER_SIZE + 12*sizeof(double));
+    BOOST_TEST(file.substr(0, 8) == std::string("\x93NUMPY\x01\x00", 8));
+    const size_t headerLength = (unsigned char)file[8] | ((unsigned char)file[9] << 8);
+    BOOST_TEST(10 + headerLength == NPY_HEADER_SIZE);
+    BOOST_TEST(NPY_HEADER_SIZE % 64 == 0u);
+    const std::string header = file.substr(10, headerLength);
+    BOOST_TEST(header.find("'descr': '<f8'") != std::string::npos);
+    BOOST_TEST(header.find("'shape': (3, 4)") != std::string::npos);
+    BOOST_TEST(header.back() == '\n');
+    for (size_t i = 0; i < 3; ++i) {
+	for (size_t j = 0; j < 4; ++j) {
+	    double x;
+	    std::memcpy(&x, file.data() + NPY_HEADER_SIZE + (4*i + j)*sizeof(double), sizeof(double));
+	    BOOST_TEST(x == data[i][j]);
+	}
+    }
+
+    {
+	Writer w(fname);
+	w.WriteRowVector<int_ll>({ -1, 2 });
+    }
+    BOOST_TEST(readFile(fname).find("'descr': '<i4', 'fortran_order': False, 'shape': (1, 2)") != std::string::npos);
+    std::filesystem::remove(fname);
+}
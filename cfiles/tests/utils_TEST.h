@@ -1,12 +1,31 @@
 #ifndef UTILS_TEST
 #define UTILS_TEST
 
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <string>
 
 
 #include "json.hpp"	   // https://github.com/nlohmann/json
 #include "config.h"        
+#include "Random.h"
+#include "Particle.h"
 
 //TODO: Every test must be passed through each possible configuration. How to best organise this?
 
+/**@brief Initial condition `j` of the tests, uniform over the channel
+ */
+inline SParticle<float_> getTestParticle(const size_t& j) {
+    Random<float_> rng(6, j);
+    return SParticle<float_>({ 0., config::d }, { -PI2, PI2 }, rng);
+}
+
+/**@brief Contents of a file, as bytes
+ */
+inline std::string readFile(const std::string& fname) {
+    std::ifstream ifs(fname, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(ifs), {});
+}
+
 #endif  // UTILS_TEST
@@ -106,6 +106,147 @@ def get_study_files(study=STUDY_PREFIX + "0", warn=False):
         return jfiles
     #return [f for f in fnames if Path(f).exists()]
 
+CODEC_MAGIC = b"SMPK"
+CODEC_RLE, CODEC_DELTA, CODEC_DOD = 1, 2, 3
+
+def decode_varints(buf):
+    """@brief Decodes a byte string of LEB128 varints into an array of uint64
+    """
+    b = np.frombuffer(buf, dtype=np.uint8).astype(np.uint64)
+    ends = np.flatnonzero(b < 0x80)
+    if len(ends) == 0:
+        return np.zeros(0, np.uint64)
+    starts = np.concatenate(([0], ends[:-1] + 1))
+    group = np.repeat(np.arange(len(ends)), ends - starts + 1)
+    shift = (np.arange(len(b)) - starts[group]).astype(np.uint64) * np.uint64(7)
+    return np.add.reduceat((b & np.uint64(0x7F)) << shift, starts)
+
+def unzigzag(u):
+    return ((u >> np.uint64(1)) ^ (np.uint64(0) - (u & np.uint64(1)))).view(np.int64)
+
+def decode_row(codec, buf, n, dtype):
+    """@brief Decodes one row of an encoded file (see cfiles/include/Codec.h)
+    """
+    u = decode_varints(buf)
+    if codec == CODEC_RLE:
+        runs = (u >> np.uint64(5)).astype(np.int64)
+        labels = (u & np.uint64(0x1F)).astype(np.int64) - 1
+        return np.repeat(labels, runs).astype(np.int32)
+    z = unzigzag(u)
+    with np.errstate(over='ignore'):
+        if codec == CODEC_DELTA:
+            return np.cumsum(z).astype(np.int64)
+        delta = np.cumsum(z[1:])        # First difference, then differences of differences
+        c = np.concatenate((z[:1], z[0] + np.cumsum(delta)))
+    return c.view(np.float64) if dtype == np.float64 else c.astype(np.int64)
+
+def read_encoded_rows(fname, dtype, start_row=0, max_rows=None):
+    """@brief Reads rows of a .rle, .delta or .dod file written by `Writer` as a 2D array
+    """
+    buf = Path(fname).read_bytes()
+    if buf[:4] != CODEC_MAGIC or buf[4] != 1:
+        raise ValueError(f"{fname} is not an encoded trajectory file.")
+    codec, pos, rows, i = buf[5], 6, [], 0
+    def varint():
+        nonlocal pos
+        u, shift = 0, 0
+        while True:
+            b = buf[pos]; pos += 1
+            u |= (b & 0x7F) << shift
+            shift += 7
+            if b < 0x80:
+                return u
+    while pos < len(buf) and (max_rows is None or i < start_row + max_rows):
+        n, nbytes = varint(), varint()
+        if i >= start_row:
+            rows.append(decode_row(codec, buf[pos:pos + nbytes], n, dtype))
+        pos += nbytes
+        i += 1
+    return np.array(rows)
+
+def load_member(fname, dtype, start_row=0, max_rows=None):
+    """@brief Loads rows of a data file written by `Writer` as a 2D array
+    .npy files are memory mapped rather than parsed, so only the rows used are read from disk.
+    .rle, .delta and .dod files are decoded
+    @param fname File name from ../config.json
+    @param dtype Type of text data. Ignored for .npy files, which store their own type
+    @param start_row Index of the first row
+    @param max_rows Number of rows. All remaining rows if None
+    """
+    if fname.endswith(".npy"):
+        data = np.load(fname, mmap_mode='r')
+        stop = None if max_rows is None else start_row + max_rows
+        return data[start_row:stop]
+    if fname.endswith((".rle", ".delta", ".dod")):
+        return read_encoded_rows(fname, dtype, start_row, max_rows)
+    return np.loadtxt(fname, ndmin=2, skiprows=start_row, max_rows=max_rows, dtype=dtype)
+
+def load_transitions(fname):
+    """@brief Loads region transition counts written by `WriteTransitionData`
+    @param fname Transitions.json in the study's data directory
+    @return Lags, and counts of shape (lags, 20, 20, 2*max(lags)+1) indexed by [lag, from, to, jump + max(lags)],
+    or (lags, 20, 20, 1) when jumps were not counted. Read from Transitions.npy when present
+    """
+    jtrans = json.load(open(fname))
+    lags = jtrans["lags"]
+    npy = Path(fname).with_suffix(".npy")
+    if npy.exists():
+        return lags, np.load(npy).reshape(len(lags), jtrans["labels"], jtrans["labels"], -1)
+    if not jtrans["jumps"]:
+        return lags, np.array([jtrans["counts"][str(k)] for k in lags], dtype=np.uint64)[..., None]
+    K = max(lags)
+    counts = np.zeros((len(lags), jtrans["labels"], jtrans["labels"], 2*K + 1), dtype=np.uint64)
+    for l, k in enumerate(lags):
+        counts[l, :, :, K - k:K + k + 1] = jtrans["jump_counts"][str(k)]
+    return lags, counts
+
+def load_words(fname):
+    """@brief Loads the word statistics written by `WriteWordData`
+    @param fname Words.json in the study's data directory
+    @return The JSON summary (entropies, forbidden words), and for each length k a pair of the words
+    seen, as an array of labels of shape (words, k), and their counts. Read from Words.npy when present
+    """
+    jwords = json.load(open(fname))
+    npy = Path(fname).with_suffix(".npy")
+    if npy.exists():
+        rows = np.load(npy)
+        coded = {k: (rows[rows[:, 0] == k, 1], rows[rows[:, 0] == k, 2]) for k in range(1, jwords["max_length"] + 1)}
+    else:
+        coded = {}
+        for k in range(1, jwords["max_length"] + 1):
+            counts = jwords["counts"][str(k)]
+            words = np.array([[int(l) for l in w.split("-")] for w in counts], dtype=np.uint64).reshape(-1, k)
+            coded[k] = ((words * jwords["labels"]**np.arange(k - 1, -1, -1, dtype=np.uint64)).sum(axis=1),
+                        np.array(list(counts.values()), dtype=np.uint64))
+    words = {}
+    for k, (codes, counts) in coded.items():
+        labels = (codes[:, None] // jwords["labels"]**np.arange(k - 1, -1, -1, dtype=np.uint64)) % jwords["labels"]
+        words[k] = (labels.astype(np.int64), counts)
+    return jwords, words
+
+N_LABELS = 20 # Itinerary codes are label + N_LABELS*bounces (getItineraryCode in SMapHelper.h)
+
+def decode_itineraries(codes, study=STUDY_PREFIX + "0"):
+    """@brief Itineraries of the itinerary codes written by `STrajectory::Write`
+    Each distinct code is decoded once, e.g. label 1 with n bounces to "L04" + "04"*n + "R" (d = 1/2)
+    @param codes Array of codes
+    @param study Study the codes were written for
+    @return Array of strings of the same shape, "NULL" for a state in no region (-1)
+    """
+    parameters = get_study_parameters(study)
+    itineraries = parameters["itineraries"]
+    bouncing = {1: "04", 12: "31", 18: "31"} if parameters["width"] == 0.5 else {}
+    def decode(code):
+        if code < 0:
+            return "NULL"
+        label, n = code % N_LABELS, code // N_LABELS
+        if label in bouncing:
+            return itineraries[label] + bouncing[label]*n + "R"
+        return itineraries[label]
+    codes = np.asarray(codes)
+    unique, inverse = np.unique(codes, return_inverse=True)
+    return np.array([decode(int(c)) for c in unique])[inverse].reshape(codes.shape)
+
 def get_ensemble(study=STUDY_PREFIX + "0"):
     """@brief Loads data into an `Ensemble` 
     @param study 
@@ -113,13 +254,13 @@ def get_ensemble(study=STUDY_PREFIX + "0"):
     TODO: Guard against large files?
     """
     all_files = get_study_files(study)
-    H           = np.loadtxt(all_files["H"],           ndmin=2,dtype=np.float64)
-    Time        = np.loadtxt(all_files["Time"],        ndmin=2,dtype=np.float64)
+    H           = load_member(all_files["H"],           np.float64)
+    Time        = load_member(all_files["Time"],        np.float64)
     print(Time)
-    Theta       = np.loadtxt(all_files["Theta"],       ndmin=2,dtype=np.float64)
-    Positions   = np.loadtxt(all_files["Positions"],   ndmin=2,dtype=np.int64)
-    Itineraries = np.loadtxt(all_files["Itineraries"], ndmin=2,dtype=str)
-    Labels      = np.loadtxt(all_files["Labels"],      ndmin=2,dtype=np.int32)
+    Theta       = load_member(all_files["Theta"],       np.float64)
+    Positions   = load_member(all_files["Positions"],   np.int64)
+    Itineraries = decode_itineraries(load_member(all_files["Itineraries"], np.int64), study)
+    Labels      = load_member(all_files["Labels"],      np.int32)
     return Ensemble(H,Theta,Time,Positions,Itineraries,Labels)
 
 def get_trajectory_member(study=STUDY_PREFIX + "0", member_name="H"):
@@ -128,10 +269,10 @@ def get_trajectory_member(study=STUDY_PREFIX + "0", member_name="H"):
     all_files = get_study_files(study)
     ftype = np.float64
     if member_name == "Itineraries":
-        ftype = str
+        return decode_itineraries(load_member(all_files[member_name], np.int64), study)
     elif member_name == "Positions" or member_name == "Labels":
         ftype = np.int64
-    return np.loadtxt(all_files[member_name],ndmin=2,dtype=ftype)
+    return load_member(all_files[member_name], ftype)
 
 def get_ensemble_row_chunk(study, start_row, chunk_size):
     """@brief Loads a chunk (subset of what is available) into ensemble 
@@ -141,14 +282,12 @@ def get_ensemble_row_chunk(study, start_row, chunk_size):
     @return Ensemble data class object
     """
     all_files = get_study_files(study)
-    H           = np.loadtxt(all_files["H"],           ndmin=2, skiprows=start_row, max_rows=chunk_size, dtype=np.float64)
-    Time        = np.loadtxt(all_files["Time"],        ndmin=2, skiprows=start_row, max_rows=chunk_size, dtype=np.float64)
-    Theta       = np.loadtxt(all_files["Theta"],       ndmin=2, skiprows=start_row, max_rows=chunk_size, dtype=np.float64)
-    Positions   = np.loadtxt(all_files["Positions"],   ndmin=2, skiprows=start_row, max_rows=chunk_size, dtype=np.int64)
-    Labels      = np.loadtxt(all_files["Labels"],      ndmin=2, skiprows=start_row, max_rows=chunk_size, dtype=np.int32)
-    # BUG:
-    #Itineraries = np.loadtxt(all_files["Itineraries"], ndmin=2, skiprows=start_row, max_rows=chunk_size, dtype=str)
-    Itineraries = np.array(pd.read_csv(all_files["Itineraries"], skiprows=start_row, nrows=chunk_size, dtype=str, sep=" ", header=None))
+    H           = load_member(all_files["H"],         np.float64, start_row, chunk_size)
+    Time        = load_member(all_files["Time"],      np.float64, start_row, chunk_size)
+    Theta       = load_member(all_files["Theta"],     np.float64, start_row, chunk_size)
+    Positions   = load_member(all_files["Positions"], np.int64,   start_row, chunk_size)
+    Labels      = load_member(all_files["Labels"],    np.int32,   start_row, chunk_size)
+    Itineraries = decode_itineraries(load_member(all_files["Itineraries"], np.int64, start_row, chunk_size), study)
     return Ensemble(H,Theta,Time,Positions,Itineraries,Labels)
 
 